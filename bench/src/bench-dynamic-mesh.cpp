@@ -0,0 +1,152 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include "bench-dynamic-mesh.hpp"
+#include "bench-util.hpp"
+#include "dynamic/faces.hpp"
+#include "dynamic/mesh.hpp"
+#include "intersection.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/ray.hpp"
+#include "tool/sculpt/util/action.hpp"
+#include "tool/sculpt/util/brush.hpp"
+
+namespace
+{
+  static const unsigned int numSculptSteps = 200;
+
+  void benchmark (unsigned int level)
+  {
+    const Mesh                   source = MeshUtil::icosphere (level);
+    std::unique_ptr<DynamicMesh> mesh;
+    std::unique_ptr<DynamicMesh> copy;
+
+    const double build = BenchUtil::milliseconds ([&]() { mesh.reset (new DynamicMesh (source)); });
+    const double copying =
+      BenchUtil::milliseconds ([&]() { copy.reset (new DynamicMesh (*mesh)); });
+
+    // moves a single vertex of the fresh copy: clones only the touched chunks
+    const double editing = BenchUtil::milliseconds ([&]() {
+      copy->vertex (0, 1.01f * copy->vertex (0));
+      copy->setVertexNormal (0);
+      for (unsigned int f : copy->adjacentFaces (0))
+      {
+        copy->realignFace (f);
+      }
+      copy->sanitize ();
+    });
+
+    const double normals = BenchUtil::milliseconds ([&]() { copy->setAllNormals (); });
+
+    DynamicFaces faces;
+    copy->forEachFace ([&faces](unsigned int f) { faces.insert (f); });
+    faces.commit ();
+
+    // visits each edge of the closed mesh once, by its vertices and by its half-edge
+    unsigned int numEdges = 0;
+    const double pairs = BenchUtil::milliseconds ([&]() {
+      copy->forEachFace ([&copy, &numEdges](unsigned int f) {
+        unsigned int i[3];
+        copy->vertexIndices (f, i[0], i[1], i[2]);
+
+        for (unsigned int k = 0; k < 3; k++)
+        {
+          const unsigned int e1 = i[k];
+          const unsigned int e2 = i[(k + 1) % 3];
+
+          if (e1 < e2)
+          {
+            unsigned int leftFace, leftVertex, rightFace, rightVertex;
+            copy->findAdjacent (e1, e2, leftFace, leftVertex, rightFace, rightVertex);
+            numEdges += leftFace != rightFace ? 1 : 0;
+          }
+        }
+      });
+    });
+    const double edges = BenchUtil::milliseconds ([&]() {
+      copy->forEachEdge (faces, [&copy, &numEdges](unsigned int h) {
+        unsigned int leftFace, leftVertex, rightFace, rightVertex;
+        copy->findAdjacent (h, leftFace, leftVertex, rightFace, rightVertex);
+        numEdges += leftFace != rightFace ? 1 : 0;
+      });
+    });
+    if (numEdges != 3 * copy->numFaces ())
+    {
+      std::cout << "edges of icosphere (" << level << ") are not manifold\n";
+    }
+
+    // flips edges around vertices of high valence
+    const double relaxing =
+      BenchUtil::milliseconds ([&]() { ToolSculptAction::smoothMesh (*copy); });
+
+    std::default_random_engine            gen;
+    std::uniform_real_distribution<float> unitD (-1.0f, 1.0f);
+    glm::vec3                             direction = glm::normalize (glm::vec3 (1.0f));
+
+    const auto stroke = [&](SculptBrush& brush) {
+      return BenchUtil::milliseconds ([&]() {
+        for (unsigned int i = 0; i < numSculptSteps; i++)
+        {
+          Intersection intersection;
+
+          direction = glm::normalize (
+            direction + 0.05f * glm::vec3 (unitD (gen), unitD (gen), unitD (gen)));
+
+          if (mesh->intersects (PrimRay (2.0f * direction, -direction), intersection))
+          {
+            brush.setPointOfAction (*mesh, intersection.position (), intersection.normal ());
+            ToolSculptAction::sculpt (brush);
+          }
+        }
+        mesh->sanitize ();
+      });
+    };
+
+    SculptBrush draw;
+    draw.radius (0.2f);
+    draw.detailFactor (0.75f);
+    draw.stepWidthFactor (0.1f);
+    draw.initParameters<SBDrawParameters> ().intensity (0.02f);
+
+    // topology-heavy: collapses and relaxes edges
+    SculptBrush reduce;
+    reduce.radius (0.2f);
+    reduce.detailFactor (0.75f);
+    reduce.stepWidthFactor (0.1f);
+    reduce.initParameters<SBReduceParameters> ().intensity (0.75f);
+
+    const double sculpting = stroke (draw);
+    const double reducing = stroke (reduce);
+
+    std::cout << std::setw (16) << std::left << ("icosphere (" + std::to_string (level) + ")")
+              << std::right << std::setw (10) << source.numVertices () << std::fixed
+              << std::setprecision (1) << std::setw (10) << build << std::setw (10) << copying
+              << std::setw (10) << editing << std::setw (10) << normals << std::setw (10) << pairs
+              << std::setw (10) << edges << std::setw (10) << relaxing << std::setw (10)
+              << sculpting << std::setw (10) << reducing << "\n";
+  }
+}
+
+void BenchDynamicMesh::run ()
+{
+  std::cout << "\ndynamic mesh: normals, adjacency and relaxing of all faces, " << numSculptSteps
+            << " sculpt steps per brush (ms)\n"
+            << std::setw (16) << std::left << "mesh" << std::right << std::setw (10)
+            << "vertices" << std::setw (10) << "build" << std::setw (10) << "copy"
+            << std::setw (10) << "edit" << std::setw (10) << "normals" << std::setw (10) << "pairs"
+            << std::setw (10) << "edges" << std::setw (10) << "relax" << std::setw (10) << "draw"
+            << std::setw (10) << "reduce"
+            << "\n";
+
+  for (unsigned int level : {6, 7, 8})
+  {
+    benchmark (level);
+  }
+}
@@ -0,0 +1,107 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+#include "bench-octree.hpp"
+#include "bench-util.hpp"
+#include "dynamic/octree.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/sphere.hpp"
+#include "primitive/triangle.hpp"
+
+namespace
+{
+  static const unsigned int numSpheres = 2000;
+
+  // measures the operations of the octree itself: the callbacks do no per-element work
+  void benchmark (unsigned int level)
+  {
+    const Mesh                mesh = MeshUtil::icosphere (level);
+    std::vector<PrimTriangle> triangles;
+
+    for (unsigned int i = 0; i < mesh.numIndices (); i += 3)
+    {
+      triangles.emplace_back (mesh.vertex (mesh.index (i + 0)), mesh.vertex (mesh.index (i + 1)),
+                              mesh.vertex (mesh.index (i + 2)));
+    }
+
+    std::default_random_engine            gen;
+    std::uniform_real_distribution<float> unitD (-1.0f, 1.0f);
+    std::uniform_real_distribution<float> radiusD (0.01f, 0.2f);
+
+    std::vector<PrimSphere> spheres;
+    for (unsigned int i = 0; i < numSpheres; i++)
+    {
+      spheres.emplace_back (glm::normalize (glm::vec3 (unitD (gen), unitD (gen), unitD (gen))),
+                            radiusD (gen));
+    }
+
+    std::unique_ptr<DynamicOctree> octree;
+    std::unique_ptr<DynamicOctree> copy;
+
+    const double insert = BenchUtil::milliseconds ([&]() {
+      octree.reset (new DynamicOctree);
+      octree->setupRoot (glm::vec3 (0.0f), 2.0f);
+
+      for (unsigned int i = 0; i < triangles.size (); i++)
+      {
+        octree->addElement (i, triangles[i].center (), triangles[i].maxDimExtent ());
+      }
+    });
+
+    const double copying =
+      BenchUtil::milliseconds ([&]() { copy.reset (new DynamicOctree (*octree)); });
+
+    // moves every element a bit, like a sculpt stroke over the whole mesh
+    const double realign = BenchUtil::milliseconds ([&]() {
+      for (unsigned int i = 0; i < triangles.size (); i++)
+      {
+        const glm::vec3 offset = 0.01f * glm::vec3 (unitD (gen), unitD (gen), unitD (gen));
+        copy->realignElement (i, triangles[i].center () + offset, triangles[i].maxDimExtent ());
+      }
+    });
+
+    unsigned int numVisited = 0;
+    const double queries = BenchUtil::milliseconds ([&]() {
+      for (const PrimSphere& sphere : spheres)
+      {
+        copy->intersects (sphere, [&numVisited](bool, unsigned int) { numVisited++; });
+      }
+    });
+
+    const double deletion = BenchUtil::milliseconds ([&]() {
+      for (unsigned int i = 0; i < triangles.size (); i += 2)
+      {
+        copy->deleteElement (i);
+      }
+      copy->deleteEmptyChildren ();
+    });
+
+    std::cout << std::setw (16) << std::left << ("icosphere (" + std::to_string (level) + ")")
+              << std::right << std::setw (10) << triangles.size () << std::fixed
+              << std::setprecision (1) << std::setw (10) << insert << std::setw (10) << copying
+              << std::setw (10) << realign << std::setw (10) << queries << std::setw (10)
+              << deletion << "    (" << numVisited << " visited)\n";
+  }
+}
+
+void BenchOctree::run ()
+{
+  std::cout << "octree: " << numSpheres << " sphere queries (ms)\n"
+            << std::setw (16) << std::left << "mesh" << std::right << std::setw (10) << "elements"
+            << std::setw (10) << "insert" << std::setw (10) << "copy" << std::setw (10)
+            << "realign" << std::setw (10) << "spheres" << std::setw (10) << "delete"
+            << "\n";
+
+  for (unsigned int level : {5, 6, 7})
+  {
+    benchmark (level);
+  }
+}
@@ -0,0 +1,91 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "bench-parallel.hpp"
+#include "bench-util.hpp"
+#include "dynamic/mesh.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "parallel.hpp"
+
+namespace
+{
+  static const unsigned int level = 8;
+
+  std::vector<unsigned int> threadCounts ()
+  {
+    const unsigned int        maxThreads = std::max (1u, std::thread::hardware_concurrency ());
+    std::vector<unsigned int> counts;
+
+    // oversubscribed counts are reported as well: they show the overhead of the worker pool
+    for (unsigned int n = 1; n < std::max (maxThreads, 8u); n *= 2)
+    {
+      counts.push_back (n);
+    }
+    counts.push_back (std::max (maxThreads, 8u));
+    return counts;
+  }
+
+  // many small calls, dominated by handing the ranges to the workers
+  double dispatch (unsigned int numThreads)
+  {
+    static const unsigned int numCalls = 1000;
+
+    std::vector<unsigned int> data (numThreads);
+    return BenchUtil::milliseconds ([&]() {
+      for (unsigned int c = 0; c < numCalls; c++)
+      {
+        Parallel::forRanges (data.size (), 1, [&data](unsigned int begin, unsigned int end) {
+          for (unsigned int i = begin; i < end; i++)
+          {
+            data[i]++;
+          }
+        });
+      }
+    });
+  }
+}
+
+void BenchParallel::run ()
+{
+  const Mesh source = MeshUtil::icosphere (level);
+
+  std::cout << "\nparallel: icosphere (" << level << ") with " << source.numVertices ()
+            << " vertices (ms)\n"
+            << std::setw (10) << std::left << "threads" << std::right << std::setw (10)
+            << "build" << std::setw (10) << "normals" << std::setw (10) << "realign"
+            << std::setw (10) << "faces" << std::setw (10) << "dispatch"
+            << "\n";
+
+  for (unsigned int numThreads : threadCounts ())
+  {
+    Parallel::numThreads (numThreads);
+
+    std::unique_ptr<DynamicMesh> mesh;
+
+    const double build = BenchUtil::milliseconds ([&]() { mesh.reset (new DynamicMesh (source)); });
+    const double normals = BenchUtil::milliseconds ([&]() { mesh->setAllNormals (); });
+    const double realign = BenchUtil::milliseconds ([&]() {
+      mesh->realignAllFaces ();
+      mesh->sanitize ();
+    });
+
+    std::vector<glm::vec3> faceNormals (mesh->numFaces ());
+    const double           faces = BenchUtil::milliseconds ([&]() {
+      mesh->forEachFaceParallel ([&](unsigned int i) { faceNormals[i] = mesh->faceNormal (i); });
+    });
+
+    std::cout << std::setw (10) << std::left << numThreads << std::right << std::fixed
+              << std::setprecision (1) << std::setw (10) << build << std::setw (10) << normals
+              << std::setw (10) << realign << std::setw (10) << faces << std::setw (10)
+              << dispatch (numThreads) << "\n";
+  }
+  Parallel::numThreads (0);
+}
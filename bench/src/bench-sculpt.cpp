@@ -0,0 +1,93 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <chrono>
+#include <functional>
+#include <glm/glm.hpp>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "bench-sculpt.hpp"
+#include "dynamic/mesh.hpp"
+#include "intersection.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/ray.hpp"
+#include "tool/sculpt/util/action.hpp"
+#include "tool/sculpt/util/brush.hpp"
+
+namespace
+{
+  static const unsigned int level = 7;
+  static const unsigned int numSteps = 200;
+
+  /* Strokes of `numSteps` steps along the same random path, so that the timings of different
+   * brushes and builds are comparable.
+   */
+  template <typename T>
+  void benchmark (const std::string& name, const Mesh& source,
+                  const std::function<void(T&)>& init)
+  {
+    DynamicMesh                           mesh (source);
+    SculptBrush                           brush;
+    std::default_random_engine            gen;
+    std::uniform_real_distribution<float> unitD (-1.0f, 1.0f);
+    glm::vec3                             direction = glm::normalize (glm::vec3 (1.0f));
+
+    brush.radius (0.2f);
+    brush.detailFactor (0.75f);
+    brush.stepWidthFactor (0.1f);
+    init (brush.initParameters<T> ());
+
+    double       milliseconds = 0.0;
+    unsigned int numSculpted = 0;
+
+    for (unsigned int i = 0; i < numSteps; i++)
+    {
+      Intersection intersection;
+
+      direction =
+        glm::normalize (direction + 0.05f * glm::vec3 (unitD (gen), unitD (gen), unitD (gen)));
+
+      if (mesh.intersects (PrimRay (2.0f * direction, -direction), intersection))
+      {
+        const auto start = std::chrono::steady_clock::now ();
+
+        brush.setPointOfAction (mesh, intersection.position (), intersection.normal ());
+        ToolSculptAction::sculpt (brush);
+
+        const auto end = std::chrono::steady_clock::now ();
+        milliseconds += std::chrono::duration<double, std::milli> (end - start).count ();
+        numSculpted++;
+      }
+    }
+
+    std::cout << std::setw (10) << std::left << name << std::right << std::setw (10)
+              << numSculpted << std::fixed << std::setprecision (3) << std::setw (12)
+              << (milliseconds / numSculpted) << std::setw (10) << mesh.numFaces () << "\n";
+  }
+}
+
+void BenchSculpt::run ()
+{
+  const Mesh source = MeshUtil::icosphere (level);
+
+  std::cout << "\nsculpt: " << numSteps << " steps per brush on icosphere (" << level << ")\n"
+            << std::setw (10) << std::left << "brush" << std::right << std::setw (10)
+            << "sculpted" << std::setw (12) << "ms/step" << std::setw (10) << "faces"
+            << "\n";
+
+  benchmark<SBDrawParameters> ("draw", source,
+                               [](SBDrawParameters& p) { p.intensity (0.02f); });
+  benchmark<SBGrablikeParameters> ("grab", source, [](SBGrablikeParameters&) {});
+  benchmark<SBSmoothParameters> ("smooth", source,
+                                 [](SBSmoothParameters& p) { p.intensity (0.5f); });
+  benchmark<SBReduceParameters> ("reduce", source,
+                                 [](SBReduceParameters& p) { p.intensity (0.75f); });
+  benchmark<SBFlattenParameters> ("flatten", source,
+                                  [](SBFlattenParameters& p) { p.intensity (0.5f); });
+  benchmark<SBCreaseParameters> ("crease", source,
+                                 [](SBCreaseParameters& p) { p.intensity (0.5f); });
+  benchmark<SBPinchParameters> ("pinch", source, [](SBPinchParameters&) {});
+}
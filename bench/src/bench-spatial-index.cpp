@@ -0,0 +1,98 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "bench-spatial-index.hpp"
+#include "bench-util.hpp"
+#include "dynamic/faces.hpp"
+#include "dynamic/mesh.hpp"
+#include "intersection.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/ray.hpp"
+#include "primitive/sphere.hpp"
+
+namespace
+{
+  static const unsigned int numRays = 20000;
+  static const unsigned int numDistances = 2000;
+  static const unsigned int numSpheres = 2000;
+
+  void benchmark (const std::string& name, const Mesh& source, bool useBVH)
+  {
+    std::default_random_engine            gen;
+    std::uniform_real_distribution<float> unitD (-1.0f, 1.0f);
+    std::uniform_real_distribution<float> radiusD (0.01f, 0.2f);
+
+    const auto randomDirection = [&gen, &unitD]() {
+      return glm::normalize (glm::vec3 (unitD (gen), unitD (gen), unitD (gen)));
+    };
+
+    DynamicMesh mesh (source);
+    mesh.useBVH (useBVH == false);
+
+    const double build = BenchUtil::milliseconds ([&mesh, useBVH]() { mesh.useBVH (useBVH); });
+
+    unsigned int numHits = 0;
+    const double rays = BenchUtil::milliseconds ([&]() {
+      for (unsigned int i = 0; i < numRays; i++)
+      {
+        const glm::vec3 origin = 2.0f * randomDirection ();
+        const glm::vec3 target = 0.5f * glm::vec3 (unitD (gen), unitD (gen), unitD (gen));
+        Intersection    intersection;
+
+        if (mesh.intersects (PrimRay (origin, glm::normalize (target - origin)), intersection))
+        {
+          numHits++;
+        }
+      }
+    });
+
+    float        sumDistances = 0.0f;
+    const double distances = BenchUtil::milliseconds ([&]() {
+      for (unsigned int i = 0; i < numDistances; i++)
+      {
+        sumDistances += mesh.unsignedDistance (1.5f * glm::vec3 (unitD (gen), unitD (gen),
+                                                                 unitD (gen)));
+      }
+    });
+
+    unsigned int numFaces = 0;
+    const double spheres = BenchUtil::milliseconds ([&]() {
+      for (unsigned int i = 0; i < numSpheres; i++)
+      {
+        DynamicFaces faces;
+        mesh.intersects (PrimSphere (randomDirection (), radiusD (gen)), faces);
+        numFaces += faces.numElements ();
+      }
+    });
+
+    std::cout << std::setw (16) << std::left << name << std::setw (8)
+              << (useBVH ? "bvh" : "octree") << std::right << std::fixed << std::setprecision (1)
+              << std::setw (10) << build << std::setw (10) << rays << std::setw (12) << distances
+              << std::setw (10) << spheres << "    (" << numHits << " hits, " << sumDistances
+              << " distance, " << numFaces << " faces)\n";
+  }
+}
+
+void BenchSpatialIndex::run ()
+{
+  std::cout << "spatial index: " << numRays << " rays, " << numDistances << " distances, "
+            << numSpheres << " spheres (ms)\n"
+            << std::setw (16) << std::left << "mesh" << std::setw (8) << "index" << std::right
+            << std::setw (10) << "build" << std::setw (10) << "rays" << std::setw (12)
+            << "distances" << std::setw (10) << "spheres" << "\n";
+
+  for (unsigned int level : {4, 5, 6})
+  {
+    const Mesh        mesh = MeshUtil::icosphere (level);
+    const std::string name = "icosphere (" + std::to_string (level) + ")";
+
+    benchmark (name, mesh, false);
+    benchmark (name, mesh, true);
+  }
+}
@@ -0,0 +1,14 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <chrono>
+#include "bench-util.hpp"
+
+double BenchUtil::milliseconds (const std::function<void()>& f)
+{
+  const auto start = std::chrono::steady_clock::now ();
+  f ();
+  const auto end = std::chrono::steady_clock::now ();
+  return std::chrono::duration<double, std::milli> (end - start).count ();
+}
@@ -0,0 +1,15 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_BENCH_UTIL
+#define DILAY_BENCH_UTIL
+
+#include <functional>
+
+namespace BenchUtil
+{
+  double milliseconds (const std::function<void()>&);
+}
+
+#endif
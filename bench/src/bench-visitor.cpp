@@ -0,0 +1,213 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <functional>
+#include <glm/glm.hpp>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include "bench-visitor.hpp"
+#include "bench-util.hpp"
+#include "distance.hpp"
+#include "dynamic/bvh.hpp"
+#include "dynamic/octree.hpp"
+#include "intersection.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/ray.hpp"
+#include "primitive/sphere.hpp"
+#include "primitive/triangle.hpp"
+
+namespace
+{
+  static const unsigned int numRays = 20000;
+  static const unsigned int numDistances = 2000;
+  static const unsigned int numSpheres = 2000;
+
+  struct Triangles
+  {
+    std::vector<glm::vec3> vertices;
+
+    unsigned int numTriangles () const { return this->vertices.size () / 3; }
+
+    PrimTriangle triangle (unsigned int i) const
+    {
+      return PrimTriangle (this->vertices[(3 * i) + 0], this->vertices[(3 * i) + 1],
+                           this->vertices[(3 * i) + 2]);
+    }
+  };
+
+  void printRow (const std::string& index, const std::string& query, double callback,
+                 double visitor)
+  {
+    std::cout << std::setw (8) << std::left << index << std::setw (12) << query << std::right
+              << std::fixed << std::setprecision (1) << std::setw (12) << callback
+              << std::setw (12) << visitor << std::setw (10) << std::setprecision (2)
+              << (callback / visitor) << "x\n";
+  }
+
+  /* Runs the same per-element work once through the `std::function` overloads and once through
+   * the templated entry points of `Index`.
+   */
+  template <typename Index>
+  void benchmark (const std::string& name, const Index& index, const Triangles& triangles)
+  {
+    std::default_random_engine            gen;
+    std::uniform_real_distribution<float> unitD (-1.0f, 1.0f);
+    std::uniform_real_distribution<float> radiusD (0.01f, 0.2f);
+
+    std::vector<PrimRay>    rays;
+    std::vector<glm::vec3>  points;
+    std::vector<PrimSphere> spheres;
+
+    for (unsigned int i = 0; i < numRays; i++)
+    {
+      const glm::vec3 origin =
+        2.0f * glm::normalize (glm::vec3 (unitD (gen), unitD (gen), unitD (gen)));
+      const glm::vec3 target = 0.5f * glm::vec3 (unitD (gen), unitD (gen), unitD (gen));
+      rays.emplace_back (origin, glm::normalize (target - origin));
+    }
+    for (unsigned int i = 0; i < numDistances; i++)
+    {
+      points.push_back (1.5f * glm::vec3 (unitD (gen), unitD (gen), unitD (gen)));
+    }
+    for (unsigned int i = 0; i < numSpheres; i++)
+    {
+      spheres.emplace_back (glm::normalize (glm::vec3 (unitD (gen), unitD (gen), unitD (gen))),
+                            radiusD (gen));
+    }
+
+    unsigned int numHits[2] = {0, 0};
+    const auto   rayQueries = [&rays, &triangles, &numHits](bool templated, const Index& i) {
+      for (const PrimRay& ray : rays)
+      {
+        const auto f = [&triangles, &ray, &numHits, templated](unsigned int e) {
+          float t;
+          if (IntersectionUtil::intersects (ray, triangles.triangle (e), false, &t))
+          {
+            numHits[templated]++;
+            return t;
+          }
+          return Util::maxFloat ();
+        };
+        if (templated)
+        {
+          i.intersectsT (ray, f);
+        }
+        else
+        {
+          i.intersects (ray, f);
+        }
+      }
+    };
+
+    float      sumDistances[2] = {0.0f, 0.0f};
+    const auto distanceQueries = [&points, &triangles, &sumDistances](bool         templated,
+                                                                      const Index& i) {
+      for (const glm::vec3& p : points)
+      {
+        const auto f = [&triangles, &p](unsigned int e) {
+          return Distance::distance (triangles.triangle (e), p);
+        };
+        sumDistances[templated] += templated ? i.distanceT (p, f) : i.distance (p, f);
+      }
+    };
+
+    unsigned int numElements[2] = {0, 0};
+    const auto   sphereQueries = [&spheres, &triangles, &numElements](bool         templated,
+                                                                    const Index& i) {
+      for (const PrimSphere& sphere : spheres)
+      {
+        const auto f = [&triangles, &sphere, &numElements, templated](bool contains,
+                                                                      unsigned int e) {
+          if (contains || IntersectionUtil::intersects (sphere, triangles.triangle (e)))
+          {
+            numElements[templated]++;
+          }
+        };
+        if (templated)
+        {
+          i.intersectsT (sphere, f);
+        }
+        else
+        {
+          i.intersects (sphere, f);
+        }
+      }
+    };
+
+    // no per-element work: measures the overhead of the callbacks only
+    unsigned int numVisited[2] = {0, 0};
+    const auto   visitQueries = [&spheres, &numVisited](bool templated, const Index& i) {
+      for (const PrimSphere& sphere : spheres)
+      {
+        const auto f = [&numVisited, templated](bool, unsigned int) { numVisited[templated]++; };
+        if (templated)
+        {
+          i.intersectsT (PrimSphere (sphere.center (), 4.0f * sphere.radius ()), f);
+        }
+        else
+        {
+          i.intersects (PrimSphere (sphere.center (), 4.0f * sphere.radius ()), f);
+        }
+      }
+    };
+
+    printRow (name, "rays", BenchUtil::milliseconds ([&]() { rayQueries (false, index); }),
+              BenchUtil::milliseconds ([&]() { rayQueries (true, index); }));
+    printRow (name, "distances",
+              BenchUtil::milliseconds ([&]() { distanceQueries (false, index); }),
+              BenchUtil::milliseconds ([&]() { distanceQueries (true, index); }));
+    printRow (name, "spheres", BenchUtil::milliseconds ([&]() { sphereQueries (false, index); }),
+              BenchUtil::milliseconds ([&]() { sphereQueries (true, index); }));
+    printRow (name, "visits", BenchUtil::milliseconds ([&]() { visitQueries (false, index); }),
+              BenchUtil::milliseconds ([&]() { visitQueries (true, index); }));
+
+    if (numHits[0] != numHits[1] || sumDistances[0] != sumDistances[1] ||
+        numElements[0] != numElements[1] || numVisited[0] != numVisited[1])
+    {
+      std::cout << "results of " << name << " differ\n";
+    }
+  }
+}
+
+void BenchVisitor::run ()
+{
+  const Mesh mesh = MeshUtil::icosphere (6);
+  Triangles  triangles;
+
+  for (unsigned int i = 0; i < mesh.numIndices (); i++)
+  {
+    triangles.vertices.push_back (mesh.vertex (mesh.index (i)));
+  }
+
+  glm::vec3 minVertex, maxVertex;
+  mesh.minMax (minVertex, maxVertex);
+
+  const glm::vec3 delta = maxVertex - minVertex;
+  DynamicOctree   octree;
+  DynamicBVH      bvh;
+
+  octree.setupRoot ((maxVertex + minVertex) * glm::vec3 (0.5f),
+                    glm::max (glm::max (delta.x, delta.y), delta.z));
+
+  for (unsigned int i = 0; i < triangles.numTriangles (); i++)
+  {
+    const PrimTriangle triangle = triangles.triangle (i);
+
+    octree.addElement (i, triangle.center (), triangle.maxDimExtent ());
+    bvh.addElement (i, triangle.minimum (), triangle.maximum ());
+  }
+  bvh.rebuild ();
+
+  std::cout << "\nvisitor: " << triangles.numTriangles () << " triangles, " << numRays
+            << " rays, " << numDistances << " distances, " << numSpheres << " spheres (ms)\n"
+            << std::setw (8) << std::left << "index" << std::setw (12) << "query" << std::right
+            << std::setw (12) << "callback" << std::setw (12) << "template" << std::setw (11)
+            << "speedup"
+            << "\n";
+
+  benchmark ("octree", octree, triangles);
+  benchmark ("bvh", bvh, triangles);
+}
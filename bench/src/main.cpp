@@ -0,0 +1,25 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <QCoreApplication>
+#include "bench-dynamic-mesh.hpp"
+#include "bench-octree.hpp"
+#include "bench-parallel.hpp"
+#include "bench-sculpt.hpp"
+#include "bench-spatial-index.hpp"
+#include "bench-visitor.hpp"
+
+int main ()
+{
+  QCoreApplication::setApplicationName ("dilay");
+
+  BenchOctree::run ();
+  BenchSpatialIndex::run ();
+  BenchVisitor::run ();
+  BenchDynamicMesh::run ();
+  BenchParallel::run ();
+  BenchSculpt::run ();
+
+  return 0;
+}
@@ -7,14 +7,19 @@ INCLUDEPATH += src
 CONFIG      += staticlib
 
 SOURCES += \
+           src/binary-util.cpp \
            src/camera.cpp \
            src/color.cpp \
            src/config.cpp \
            src/configurable.cpp \
            src/dimension.cpp \
+           src/dirty-pages.cpp \
            src/distance.cpp \
+           src/dynamic/adjacency.cpp \
+           src/dynamic/bvh.cpp \
            src/dynamic/faces.cpp \
            src/dynamic/mesh.cpp \
+           src/dynamic/mesh-delta.cpp \
            src/dynamic/mesh-intersection.cpp \
            src/dynamic/octree.cpp \
            src/history.cpp \
@@ -23,11 +28,13 @@ SOURCES += \
            src/isosurface-extraction.cpp \
            src/kvstore.cpp \
            src/log.cpp \
+           src/memory-usage.cpp \
            src/mesh.cpp \
            src/mesh-util.cpp \
            src/mirror.cpp \
            src/opengl.cpp \
            src/opengl-buffer-id.cpp \
+           src/parallel.cpp \
            src/primitive/aabox.cpp \
            src/primitive/cone.cpp \
            src/primitive/cone-sphere.cpp \
@@ -104,18 +111,25 @@ SOURCES += \
            src/xml-conversion.cpp \
 
 HEADERS += \
+           src/binary-util.hpp \
            src/bitset.hpp \
            src/cache.hpp \
            src/camera.hpp \
            src/color.hpp \
            src/config.hpp \
+           src/cow-vector.hpp \
            src/configurable.hpp \
            src/dimension.hpp \
+           src/dirty-pages.hpp \
            src/distance.hpp \
+           src/dynamic/adjacency.hpp \
+           src/dynamic/bvh.hpp \
            src/dynamic/faces.hpp \
            src/dynamic/mesh.hpp \
+           src/dynamic/mesh-delta.hpp \
            src/dynamic/mesh-intersection.hpp \
            src/dynamic/octree.hpp \
+           src/dynamic/visitor.hpp \
            src/hash.hpp \
            src/history.hpp \
            src/import-export.hpp \
@@ -125,11 +139,13 @@ HEADERS += \
            src/log.hpp \
            src/macro.hpp \
            src/maybe.hpp \
+           src/memory-usage.hpp \
            src/mesh.hpp \
            src/mesh-util.hpp \
            src/mirror.hpp \
            src/opengl.hpp \
            src/opengl-buffer-id.hpp \
+           src/parallel.hpp \
            src/primitive/aabox.hpp \
            src/primitive/cone.hpp \
            src/primitive/cone-sphere.hpp \
@@ -0,0 +1,126 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cstring>
+#include "binary-util.hpp"
+
+void BinaryUtil::putVarint (QByteArray& data, unsigned int value)
+{
+  while (value >= 0x80)
+  {
+    data.append (char((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  data.append (char(value));
+}
+
+void BinaryUtil::putIndex (QByteArray& data, unsigned int& previous, unsigned int index)
+{
+  const unsigned int diff = index - previous;
+  const unsigned int sign = (diff >> 31) == 0 ? 0u : ~0u;
+
+  BinaryUtil::putVarint (data, (diff << 1) ^ sign);
+  previous = index;
+}
+
+void BinaryUtil::putFloats (QByteArray& data, const std::vector<float>& values)
+{
+  const int offset = data.size ();
+  data.resize (offset + int(values.size () * sizeof (float)));
+
+  for (unsigned int i = 0; i < values.size (); i++)
+  {
+    unsigned char bytes[sizeof (float)];
+    std::memcpy (bytes, &values[i], sizeof (float));
+
+    for (unsigned int b = 0; b < sizeof (float); b++)
+    {
+      data[offset + int((b * values.size ()) + i)] = char(bytes[b]);
+    }
+  }
+}
+
+BinaryUtil::Reader::Reader (const QByteArray& d)
+  : data (d)
+  , position (0)
+  , hasFailed (false)
+{
+}
+
+bool BinaryUtil::Reader::failed () const { return this->hasFailed; }
+
+std::size_t BinaryUtil::Reader::remaining () const
+{
+  return std::size_t (this->data.size () - this->position);
+}
+
+bool BinaryUtil::Reader::done () const
+{
+  return this->hasFailed == false && this->remaining () == 0;
+}
+
+unsigned char BinaryUtil::Reader::byte ()
+{
+  if (this->position >= this->data.size ())
+  {
+    this->hasFailed = true;
+    return 0;
+  }
+  return static_cast<unsigned char> (this->data[this->position++]);
+}
+
+bool BinaryUtil::Reader::flag ()
+{
+  const unsigned char b = this->byte ();
+  this->hasFailed = this->hasFailed || b > 1;
+  return b != 0;
+}
+
+unsigned int BinaryUtil::Reader::varint ()
+{
+  unsigned int  value = 0;
+  unsigned int  shift = 0;
+  unsigned char b;
+  do
+  {
+    if (shift >= 32)
+    {
+      this->hasFailed = true;
+      return 0;
+    }
+    b = this->byte ();
+    value |= static_cast<unsigned int> (b & 0x7f) << shift;
+    shift += 7;
+  } while (b & 0x80);
+  return value;
+}
+
+unsigned int BinaryUtil::Reader::index (unsigned int& previous)
+{
+  const unsigned int zigZag = this->varint ();
+  const unsigned int diff = (zigZag >> 1) ^ (0u - (zigZag & 1));
+  previous += diff;
+  return previous;
+}
+
+void BinaryUtil::Reader::floats (std::vector<float>& values)
+{
+  const int n = int(values.size ());
+  if (values.size () > this->remaining () / sizeof (float))
+  {
+    this->hasFailed = true;
+    return;
+  }
+
+  for (int i = 0; i < n; i++)
+  {
+    unsigned char bytes[sizeof (float)];
+    for (unsigned int b = 0; b < sizeof (float); b++)
+    {
+      bytes[b] = static_cast<unsigned char> (this->data[this->position + (int(b) * n) + i]);
+    }
+    std::memcpy (&values[i], bytes, sizeof (float));
+  }
+  this->position += n * int(sizeof (float));
+}
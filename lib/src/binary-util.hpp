@@ -0,0 +1,47 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_BINARY_UTIL
+#define DILAY_BINARY_UTIL
+
+#include <QByteArray>
+#include <cstddef>
+#include <vector>
+
+// compact binary encodings, e.g., of mesh deltas and octree layouts
+namespace BinaryUtil
+{
+  void putVarint (QByteArray&, unsigned int);
+
+  // indices are stored as zig-zag encoded differences to the previous index of the same kind
+  void putIndex (QByteArray&, unsigned int& previous, unsigned int);
+
+  /* Floats are stored byte plane by byte plane (all first bytes, then all second bytes, etc.):
+   * exponents and high mantissa bytes of neighbouring values are similar and compress well.
+   */
+  void putFloats (QByteArray&, const std::vector<float>&);
+
+  // reads data written by the functions above, reads past its end mark it as failed
+  class Reader
+  {
+  public:
+    Reader (const QByteArray&);
+
+    bool          failed () const;
+    std::size_t   remaining () const;
+    bool          done () const;
+    unsigned char byte ();
+    bool          flag ();
+    unsigned int  varint ();
+    unsigned int  index (unsigned int& previous);
+    void          floats (std::vector<float>&);
+
+  private:
+    const QByteArray& data;
+    int               position;
+    bool              hasFailed;
+  };
+}
+
+#endif
@@ -9,7 +9,7 @@
 
 namespace
 {
-  static constexpr int latestVersion = 8;
+  static constexpr int latestVersion = 11;
 
   template <typename T>
   void updateValue (Config& config, const std::string& path, const T& oldValue, const T& newValue)
@@ -74,6 +74,7 @@ void Config::restoreDefaults ()
 
   this->set ("editor/mesh/color/normal", Color (0.8f, 0.8f, 0.8f));
   this->set ("editor/mesh/color/wireframe", Color (0.3f, 0.3f, 0.3f));
+  this->set ("editor/mesh/use-bvh", false);
 
   this->set ("editor/sketch/node/color", Color (0.5f, 0.5f, 0.9f));
   this->set ("editor/sketch/bubble/color", Color (0.5f, 0.5f, 0.7f));
@@ -89,7 +90,9 @@ void Config::restoreDefaults ()
   this->set ("editor/tool/sketch-spheres/cursor-color", Color (1.0f, 0.9f, 0.9f));
   this->set ("editor/tool/sketch-spheres/step-width-factor", 0.3f);
 
-  this->set ("editor/undo-depth", 15);
+  this->set ("editor/undo-memory", 512);
+  this->set ("editor/undo-disk", 4096);
+  this->set ("editor/undo-window", 10);
 
   this->set ("editor/tablet-pressure-intensity", 1.0f);
 
@@ -136,6 +139,20 @@ void Config::update ()
     case 7:
       forceUpdateValue<float> (*this, "editor/camera/zoom-in-factor", 0.95f);
 
+    case 8:
+      this->set ("editor/mesh/use-bvh", false);
+      break;
+
+    case 9:
+      this->remove ("editor/undo-depth");
+      this->set ("editor/undo-memory", 512);
+      break;
+
+    case 10:
+      this->set ("editor/undo-disk", 4096);
+      this->set ("editor/undo-window", 10);
+      break;
+
     case latestVersion:
       return;
 
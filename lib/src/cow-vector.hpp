@@ -0,0 +1,179 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_COW_VECTOR
+#define DILAY_COW_VECTOR
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/* A vector whose elements are stored in chunks of `chunkSize` elements. Copies share their chunks
+ * until a chunk is modified, i.e., copying takes time proportional to the number of chunks and
+ * modifying a copy only clones the touched chunks. Elements of a chunk are contiguous, all chunks
+ * but the last one are full.
+ *
+ * Whether a chunk is shared is decided by its reference count, which is not synchronized with
+ * writes: a vector must not be copied while it is modified, and copies must not be modified
+ * concurrently by different threads. Concurrent reads are fine.
+ */
+template <typename T, unsigned int chunkSize = 4096> class CowVector
+{
+public:
+  typedef std::vector<T> Chunk;
+
+  static constexpr unsigned int elementsPerChunk = chunkSize;
+
+  CowVector ()
+    : _size (0)
+  {
+  }
+
+  unsigned int size () const { return this->_size; }
+  bool         empty () const { return this->_size == 0; }
+  unsigned int numChunks () const { return this->chunks.size (); }
+
+  const Chunk& chunk (unsigned int c) const
+  {
+    assert (c < this->chunks.size ());
+    return *this->chunks[c];
+  }
+
+  // chunks that are shared with other copies
+  unsigned int numSharedChunks () const
+  {
+    unsigned int n = 0;
+    for (const ChunkPtr& c : this->chunks)
+    {
+      if (c.use_count () > 1)
+      {
+        n++;
+      }
+    }
+    return n;
+  }
+
+  // bytes of shared chunks are split evenly between the copies that share them
+  std::size_t memoryBytes () const
+  {
+    std::size_t bytes = this->chunks.capacity () * sizeof (ChunkPtr);
+    for (const ChunkPtr& c : this->chunks)
+    {
+      bytes += (c->capacity () * sizeof (T)) / c.use_count ();
+    }
+    return bytes;
+  }
+
+  const T& operator[] (unsigned int i) const
+  {
+    assert (i < this->_size);
+    return (*this->chunks[i / chunkSize])[i % chunkSize];
+  }
+
+  const T& back () const { return (*this)[this->_size - 1]; }
+
+  // clones the chunk of element `i` if it is shared
+  T& mutableAt (unsigned int i)
+  {
+    assert (i < this->_size);
+    return this->mutableChunk (i / chunkSize)[i % chunkSize];
+  }
+
+  T& mutableBack () { return this->mutableAt (this->_size - 1); }
+
+  void set (unsigned int i, const T& value) { this->mutableAt (i) = value; }
+
+  void push_back (const T& value)
+  {
+    if (this->_size % chunkSize == 0)
+    {
+      this->chunks.emplace_back (std::make_shared<Chunk> ());
+      this->chunks.back ()->reserve (chunkSize);
+    }
+    this->mutableChunk (this->chunks.size () - 1).push_back (value);
+    this->_size++;
+  }
+
+  void pop_back ()
+  {
+    assert (this->_size > 0);
+    this->mutableChunk (this->chunks.size () - 1).pop_back ();
+    this->_size--;
+
+    if (this->_size % chunkSize == 0)
+    {
+      this->chunks.pop_back ();
+    }
+  }
+
+  void resize (unsigned int n, const T& value = T ())
+  {
+    if (n < this->_size)
+    {
+      const unsigned int numChunks = (n + chunkSize - 1) / chunkSize;
+
+      if (numChunks < this->chunks.size ())
+      {
+        this->chunks.resize (numChunks);
+        this->_size = numChunks * chunkSize;
+      }
+      while (this->_size > n)
+      {
+        this->pop_back ();
+      }
+    }
+    while (this->_size < n)
+    {
+      this->push_back (value);
+    }
+  }
+
+  void assign (unsigned int n, const T& value)
+  {
+    this->clear ();
+    this->resize (n, value);
+  }
+
+  void assign (const std::vector<T>& values)
+  {
+    this->clear ();
+    this->reserve (values.size ());
+
+    for (const T& value : values)
+    {
+      this->push_back (value);
+    }
+  }
+
+  void reserve (unsigned int n) { this->chunks.reserve ((n + chunkSize - 1) / chunkSize); }
+
+  void clear ()
+  {
+    this->chunks.clear ();
+    this->_size = 0;
+  }
+
+private:
+  typedef std::shared_ptr<Chunk> ChunkPtr;
+
+  Chunk& mutableChunk (unsigned int c)
+  {
+    assert (c < this->chunks.size ());
+
+    if (this->chunks[c].use_count () > 1)
+    {
+      ChunkPtr copy = std::make_shared<Chunk> ();
+      copy->reserve (chunkSize);
+      copy->assign (this->chunks[c]->begin (), this->chunks[c]->end ());
+      this->chunks[c] = std::move (copy);
+    }
+    return *this->chunks[c];
+  }
+
+  std::vector<ChunkPtr> chunks;
+  unsigned int          _size;
+};
+
+#endif
@@ -0,0 +1,81 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include "dirty-pages.hpp"
+
+DirtyPages::DirtyPages ()
+  : dirty (false)
+{
+}
+
+bool DirtyPages::isDirty () const { return this->dirty; }
+
+std::size_t DirtyPages::memoryBytes () const { return this->pages.capacity () / 8; }
+
+void DirtyPages::mark (unsigned int offset, unsigned int size)
+{
+  if (size == 0)
+  {
+    return;
+  }
+  const unsigned int first = offset / pageSize;
+  const unsigned int last = (offset + size - 1) / pageSize;
+
+  if (last >= this->pages.size ())
+  {
+    this->pages.resize (last + 1, false);
+  }
+  for (unsigned int p = first; p <= last; p++)
+  {
+    this->pages[p] = true;
+  }
+  this->dirty = true;
+}
+
+void DirtyPages::markAll (unsigned int dataSize)
+{
+  this->pages.assign ((dataSize + pageSize - 1) / pageSize, true);
+  this->dirty = dataSize > 0;
+}
+
+void DirtyPages::clear ()
+{
+  std::fill (this->pages.begin (), this->pages.end (), false);
+  this->dirty = false;
+}
+
+std::vector<DirtyPages::Range> DirtyPages::ranges (unsigned int dataSize,
+                                                   unsigned int chunkSize) const
+{
+  const unsigned int n =
+    std::min ((dataSize + pageSize - 1) / pageSize, (unsigned int) this->pages.size ());
+  std::vector<Range> result;
+
+  for (unsigned int p = 0; p < n;)
+  {
+    if (this->pages[p])
+    {
+      const unsigned int begin = p;
+      while (p < n && this->pages[p])
+      {
+        p++;
+      }
+      const unsigned int end = std::min (p * pageSize, dataSize);
+
+      for (unsigned int offset = begin * pageSize; offset < end;)
+      {
+        const unsigned int chunkEnd = std::min (((offset / chunkSize) + 1) * chunkSize, end);
+
+        result.push_back (Range{offset, chunkEnd - offset});
+        offset = chunkEnd;
+      }
+    }
+    else
+    {
+      p++;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,43 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DIRTY_PAGES
+#define DILAY_DIRTY_PAGES
+
+#include <cstddef>
+#include <vector>
+
+// tracks changes of buffer data per page of `pageSize` bytes
+class DirtyPages
+{
+public:
+  static constexpr unsigned int pageSize = 4096;
+
+  struct Range
+  {
+    unsigned int offset;
+    unsigned int size;
+  };
+
+  DirtyPages ();
+
+  bool        isDirty () const;
+  std::size_t memoryBytes () const;
+
+  // marks all pages that overlap the bytes `[offset, offset + size)`
+  void mark (unsigned int offset, unsigned int size);
+  void markAll (unsigned int dataSize);
+  void clear ();
+
+  /* Byte ranges of adjacent dirty pages within the first `dataSize` bytes. Ranges are split at
+   * multiples of `chunkSize`, so that each range can be uploaded from a single chunk of data.
+   */
+  std::vector<Range> ranges (unsigned int dataSize, unsigned int chunkSize) const;
+
+private:
+  std::vector<bool> pages;
+  bool              dirty;
+};
+
+#endif
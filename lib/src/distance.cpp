@@ -176,8 +176,14 @@ float Distance::distance (const PrimConeSphere& coneSphere, const glm::vec3& poi
   }
 }
 
-// cf. https://www.geometrictools.com/Documentation/DistancePoint3Triangle3.pdf
 float Distance::distance (const PrimTriangle& tri, const glm::vec3& point)
+{
+  return glm::distance (point, Distance::closestPoint (tri, point));
+}
+
+// cf. https://www.geometrictools.com/Documentation/DistancePoint3Triangle3.pdf
+glm::vec3 Distance::closestPoint (const PrimTriangle& tri, const glm::vec3& point,
+                                  glm::vec3* barycentric)
 {
   const glm::vec3& P = point;
   const glm::vec3& B = tri.vertex1 ();
@@ -342,5 +348,9 @@ float Distance::distance (const PrimTriangle& tri, const glm::vec3& point)
       t = 1.0f - s;
     }
   }
-  return glm::distance (point, B + (s * E0) + (t * E1));
+  if (barycentric)
+  {
+    *barycentric = glm::vec3 (1.0f - s - t, s, t);
+  }
+  return B + (s * E0) + (t * E1);
 }
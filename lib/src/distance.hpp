@@ -20,6 +20,8 @@ namespace Distance
   float distance (const PrimCone&, const glm::vec3&);
   float distance (const PrimConeSphere&, const glm::vec3&);
   float distance (const PrimTriangle&, const glm::vec3&);
+
+  glm::vec3 closestPoint (const PrimTriangle&, const glm::vec3&, glm::vec3* = nullptr);
 }
 
 #endif
@@ -0,0 +1,170 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include "dynamic/adjacency.hpp"
+
+void DynamicAdjacency::addVertex () { this->entries.push_back (Entry ()); }
+
+void DynamicAdjacency::addFace (unsigned int v, unsigned int face)
+{
+  assert (v < this->entries.size ());
+
+  Entry& entry = this->entries.mutableAt (v);
+
+  if (entry.hasBlock ())
+  {
+    this->blocks[entry.block].push_back (face);
+  }
+  else if (entry.size < DynamicAdjacency::inlineCapacity)
+  {
+    entry.faces[entry.size] = face;
+  }
+  else
+  {
+    if (this->freeBlocks.empty ())
+    {
+      entry.block = this->blocks.size ();
+      this->blocks.emplace_back ();
+    }
+    else
+    {
+      entry.block = this->freeBlocks.back ();
+      this->freeBlocks.pop_back ();
+    }
+    std::vector<unsigned int>& block = this->blocks[entry.block];
+
+    assert (block.empty ());
+    block.insert (block.end (), entry.faces, entry.faces + entry.size);
+    block.push_back (face);
+  }
+  entry.size++;
+}
+
+void DynamicAdjacency::deleteFace (unsigned int v, unsigned int face)
+{
+  assert (v < this->entries.size ());
+
+  Entry&        entry = this->entries.mutableAt (v);
+  unsigned int* faces = this->data (entry);
+  unsigned int* it = std::find (faces, faces + entry.size, face);
+
+  if (it == faces + entry.size)
+  {
+    DILAY_IMPOSSIBLE
+  }
+  // keeps the order of the remaining faces
+  std::copy (it + 1, faces + entry.size, it);
+  entry.size--;
+
+  if (entry.hasBlock ())
+  {
+    this->blocks[entry.block].pop_back ();
+
+    // moves back inline with some hysteresis to avoid thrashing
+    if (entry.size <= DynamicAdjacency::inlineCapacity / 2)
+    {
+      std::copy (faces, faces + entry.size, entry.faces);
+      this->freeBlock (entry);
+    }
+  }
+}
+
+void DynamicAdjacency::reset (unsigned int v)
+{
+  assert (v < this->entries.size ());
+
+  Entry& entry = this->entries.mutableAt (v);
+  this->freeBlock (entry);
+  entry.size = 0;
+}
+
+void DynamicAdjacency::reset ()
+{
+  this->entries.clear ();
+  this->blocks.clear ();
+  this->freeBlocks.clear ();
+}
+
+void DynamicAdjacency::shrink (unsigned int n)
+{
+  assert (n <= this->entries.size ());
+
+  for (unsigned int v = n; v < this->entries.size (); v++)
+  {
+    assert (this->entries[v].size == 0);
+    assert (this->entries[v].hasBlock () == false);
+  }
+  this->entries.resize (n);
+}
+
+void DynamicAdjacency::prune (const std::vector<unsigned int>& vertexIndexMap,
+                              const std::vector<unsigned int>& faceIndexMap)
+{
+  assert (vertexIndexMap.size () == this->entries.size ());
+
+  unsigned int numVertices = 0;
+  for (unsigned int i = 0; i < vertexIndexMap.size (); i++)
+  {
+    const unsigned int newI = vertexIndexMap[i];
+
+    if (newI != Util::invalidIndex ())
+    {
+      assert (newI <= i);
+
+      if (newI != i)
+      {
+        this->entries.set (newI, this->entries[i]);
+      }
+      numVertices = std::max (numVertices, newI + 1);
+    }
+    else
+    {
+      assert (this->entries[i].size == 0);
+      assert (this->entries[i].hasBlock () == false);
+    }
+  }
+  this->entries.resize (numVertices);
+
+  for (unsigned int v = 0; v < this->entries.size (); v++)
+  {
+    Entry&        entry = this->entries.mutableAt (v);
+    unsigned int* faces = this->data (entry);
+
+    for (unsigned int i = 0; i < entry.size; i++)
+    {
+      assert (faceIndexMap.at (faces[i]) != Util::invalidIndex ());
+
+      faces[i] = faceIndexMap[faces[i]];
+    }
+  }
+}
+
+std::size_t DynamicAdjacency::memoryBytes () const
+{
+  std::size_t bytes = this->entries.memoryBytes () +
+                      (this->blocks.capacity () * sizeof (std::vector<unsigned int>)) +
+                      (this->freeBlocks.capacity () * sizeof (unsigned int));
+
+  for (const std::vector<unsigned int>& block : this->blocks)
+  {
+    bytes += block.capacity () * sizeof (unsigned int);
+  }
+  return bytes;
+}
+
+unsigned int* DynamicAdjacency::data (Entry& entry)
+{
+  return entry.hasBlock () ? this->blocks[entry.block].data () : entry.faces;
+}
+
+void DynamicAdjacency::freeBlock (Entry& entry)
+{
+  if (entry.hasBlock ())
+  {
+    this->blocks[entry.block].clear ();
+    this->freeBlocks.push_back (entry.block);
+    entry.block = Util::invalidIndex ();
+  }
+}
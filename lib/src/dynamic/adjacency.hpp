@@ -0,0 +1,99 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DYNAMIC_ADJACENCY
+#define DILAY_DYNAMIC_ADJACENCY
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include "cow-vector.hpp"
+#include "util.hpp"
+
+/* Stores the faces that are adjacent to each vertex of a `DynamicMesh`.
+ * Up to `inlineCapacity` faces are stored inline, i.e., without a separate allocation per vertex.
+ * Vertices of higher valence store their faces in a block of an overflow pool.
+ * Entries are shared between copies until they are modified.
+ */
+class DynamicAdjacency
+{
+public:
+  static constexpr unsigned int inlineCapacity = 8;
+
+  // contiguous view of the adjacent faces of a vertex: invalidated if the adjacency is modified
+  class Faces
+  {
+  public:
+    Faces (const unsigned int* b, unsigned int s)
+      : _begin (b)
+      , _size (s)
+    {
+    }
+
+    const unsigned int* begin () const { return this->_begin; }
+    const unsigned int* end () const { return this->_begin + this->_size; }
+    unsigned int        size () const { return this->_size; }
+    bool                empty () const { return this->_size == 0; }
+
+    unsigned int operator[] (unsigned int i) const
+    {
+      assert (i < this->_size);
+      return this->_begin[i];
+    }
+
+  private:
+    const unsigned int* _begin;
+    unsigned int        _size;
+  };
+
+  unsigned int numVertices () const { return this->entries.size (); }
+
+  Faces faces (unsigned int v) const
+  {
+    assert (v < this->entries.size ());
+
+    const Entry& entry = this->entries[v];
+    return Faces (entry.hasBlock () ? this->blocks[entry.block].data () : entry.faces, entry.size);
+  }
+
+  void addVertex ();
+  void addFace (unsigned int, unsigned int);
+  void deleteFace (unsigned int, unsigned int);
+  void reset (unsigned int);
+  void reset ();
+
+  // removes vertices `n` and above, which must not have adjacent faces
+  void shrink (unsigned int);
+
+  std::size_t memoryBytes () const;
+
+  // `vertexIndexMap` and `faceIndexMap` are the index maps of `Util::prune`
+  void prune (const std::vector<unsigned int>& vertexIndexMap,
+              const std::vector<unsigned int>& faceIndexMap);
+
+private:
+  struct Entry
+  {
+    unsigned int size;
+    unsigned int block;
+    unsigned int faces[inlineCapacity];
+
+    Entry ()
+      : size (0)
+      , block (Util::invalidIndex ())
+    {
+    }
+
+    bool hasBlock () const { return this->block != Util::invalidIndex (); }
+  };
+
+  unsigned int* data (Entry&);
+  void          freeBlock (Entry&);
+
+  CowVector<Entry>                       entries;
+  std::vector<std::vector<unsigned int>> blocks;
+  std::vector<unsigned int>              freeBlocks;
+};
+
+#endif
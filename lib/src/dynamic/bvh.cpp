@@ -0,0 +1,980 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <array>
+#include <glm/glm.hpp>
+#include <glm/gtx/norm.hpp>
+#include <iostream>
+#include "cow-vector.hpp"
+#include "dynamic/bvh.hpp"
+#include "intersection.hpp"
+#include "primitive/aabox.hpp"
+#include "primitive/plane.hpp"
+#include "primitive/ray.hpp"
+#include "primitive/sphere.hpp"
+#include "util.hpp"
+
+namespace
+{
+  static constexpr unsigned int numBins = 16;
+  static constexpr unsigned int maxLeafElements = 4;
+  static constexpr unsigned int maxSAHLeafElements = 16;
+  static constexpr unsigned int maxInsertedLeafElements = 4 * maxLeafElements;
+  static constexpr float        traversalCost = 1.0f;
+  static constexpr float        maxRelativeRefitCost = 1.5f;
+
+  struct BVHBounds
+  {
+    glm::vec3 min;
+    glm::vec3 max;
+
+    BVHBounds ()
+      : min (Util::maxFloat ())
+      , max (Util::minFloat ())
+    {
+    }
+
+    BVHBounds (const glm::vec3& mi, const glm::vec3& ma)
+      : min (mi)
+      , max (ma)
+    {
+    }
+
+    bool isEmpty () const { return glm::any (glm::greaterThan (this->min, this->max)); }
+
+    void extend (const glm::vec3& p)
+    {
+      this->min = glm::min (this->min, p);
+      this->max = glm::max (this->max, p);
+    }
+
+    void extend (const BVHBounds& b)
+    {
+      this->min = glm::min (this->min, b.min);
+      this->max = glm::max (this->max, b.max);
+    }
+
+    bool contains (const BVHBounds& b) const
+    {
+      return glm::all (glm::lessThanEqual (this->min, b.min)) &&
+             glm::all (glm::lessThanEqual (b.max, this->max));
+    }
+
+    bool operator== (const BVHBounds& b) const { return this->min == b.min && this->max == b.max; }
+
+    glm::vec3 center () const { return (this->min + this->max) * 0.5f; }
+
+    float area () const
+    {
+      if (this->isEmpty ())
+      {
+        return 0.0f;
+      }
+      else
+      {
+        const glm::vec3 d = this->max - this->min;
+        return 2.0f * ((d.x * d.y) + (d.x * d.z) + (d.y * d.z));
+      }
+    }
+
+    float distance2 (const glm::vec3& p) const
+    {
+      return glm::distance2 (p, glm::clamp (p, this->min, this->max));
+    }
+
+    PrimAABox aabox () const { return PrimAABox (this->min, this->max); }
+
+    static BVHBounds merge (const BVHBounds& a, const BVHBounds& b)
+    {
+      BVHBounds m (a);
+      m.extend (b);
+      return m;
+    }
+  };
+
+  struct BVHNode
+  {
+    BVHBounds                   bounds;
+    unsigned int                parent;
+    std::array<unsigned int, 2> children;
+    std::vector<unsigned int>   elements;
+    bool                        isDirty;
+
+    BVHNode (unsigned int p)
+      : parent (p)
+      , isDirty (false)
+    {
+      this->children.fill (Util::invalidIndex ());
+    }
+
+    bool isLeaf () const { return this->children[0] == Util::invalidIndex (); }
+  };
+
+  struct BVHElement
+  {
+    BVHBounds    bounds;
+    unsigned int leaf;
+    unsigned int position;
+
+    BVHElement ()
+      : leaf (Util::invalidIndex ())
+      , position (Util::invalidIndex ())
+    {
+    }
+
+    bool isFree () const
+    {
+      return this->leaf == Util::invalidIndex () && this->position == Util::invalidIndex ();
+    }
+
+    bool isPending () const
+    {
+      return this->leaf == Util::invalidIndex () && this->position != Util::invalidIndex ();
+    }
+  };
+
+  struct BVHStatistics
+  {
+    unsigned int numNodes;
+    unsigned int numLeaves;
+    unsigned int numElements;
+    unsigned int numPendingElements;
+    unsigned int maxElementsPerLeaf;
+    int          maxDepth;
+  };
+}
+
+/* Elements that are added while there is no hierarchy (e.g., while loading a mesh) are kept in
+ * `pendingElements` until the next `rebuild` or `refit`: queries test them one by one.
+ */
+struct DynamicBVH::Impl
+{
+  CowVector<BVHNode>        nodes;
+  CowVector<BVHElement>     elements;
+  std::vector<unsigned int> pendingElements;
+  std::vector<unsigned int> dirtyNodes;
+  std::vector<unsigned int> freeNodes;
+  unsigned int              root;
+  unsigned int              numElements;
+  float                     builtCost;
+
+  Impl ()
+    : root (Util::invalidIndex ())
+    , numElements (0)
+    , builtCost (0.0f)
+  {
+  }
+
+  bool isEmpty () const { return this->numElements == 0; }
+
+  bool hasRoot () const { return this->root != Util::invalidIndex (); }
+
+  unsigned int makeNode (unsigned int parent)
+  {
+    if (this->freeNodes.empty ())
+    {
+      this->nodes.push_back (BVHNode (parent));
+      return this->nodes.size () - 1;
+    }
+    else
+    {
+      const unsigned int n = this->freeNodes.back ();
+      this->freeNodes.pop_back ();
+      this->nodes.set (n, BVHNode (parent));
+      return n;
+    }
+  }
+
+  // free nodes have empty bounds and are neither reachable nor dirty
+  void freeNode (unsigned int n)
+  {
+    this->nodes.set (n, BVHNode (Util::invalidIndex ()));
+    this->freeNodes.push_back (n);
+  }
+
+  // replaces the parent of the empty leaf `n` by the sibling of `n`
+  void deleteEmptyLeaf (unsigned int n)
+  {
+    assert (n != this->root);
+    assert (this->nodes[n].isLeaf () && this->nodes[n].elements.empty ());
+
+    const unsigned int parent = this->nodes[n].parent;
+    const unsigned int grandParent = this->nodes[parent].parent;
+    const auto&        siblings = this->nodes[parent].children;
+    const unsigned int sibling = siblings[0] == n ? siblings[1] : siblings[0];
+
+    this->nodes.mutableAt (sibling).parent = grandParent;
+
+    if (grandParent == Util::invalidIndex ())
+    {
+      this->root = sibling;
+    }
+    else
+    {
+      auto& children = this->nodes.mutableAt (grandParent).children;
+      children[children[0] == parent ? 0 : 1] = sibling;
+      this->markDirty (grandParent);
+    }
+    this->freeNode (n);
+    this->freeNode (parent);
+  }
+
+  void makeLeaf (unsigned int n, std::vector<unsigned int>::const_iterator begin,
+                 std::vector<unsigned int>::const_iterator end)
+  {
+    BVHNode& node = this->nodes.mutableAt (n);
+
+    node.children.fill (Util::invalidIndex ());
+    node.elements.assign (begin, end);
+
+    for (unsigned int i = 0; i < node.elements.size (); i++)
+    {
+      this->elements.mutableAt (node.elements[i]).leaf = n;
+      this->elements.mutableAt (node.elements[i]).position = i;
+    }
+  }
+
+  // binned SAH split of the elements in [begin, end) into node `n`
+  void build (unsigned int n, std::vector<unsigned int>::iterator begin,
+              std::vector<unsigned int>::iterator end)
+  {
+    const unsigned int numNodeElements = end - begin;
+    BVHBounds          bounds, centroidBounds;
+
+    for (auto it = begin; it != end; ++it)
+    {
+      bounds.extend (this->elements[*it].bounds);
+      centroidBounds.extend (this->elements[*it].bounds.center ());
+    }
+    this->nodes.mutableAt (n).bounds = bounds;
+
+    if (numNodeElements <= maxLeafElements)
+    {
+      this->makeLeaf (n, begin, end);
+      return;
+    }
+
+    const glm::vec3 centroidExtent = centroidBounds.max - centroidBounds.min;
+    const float     area = bounds.area ();
+    float           bestCost = float(numNodeElements);
+    int             bestAxis = -1;
+    unsigned int    bestSplit = 0;
+
+    const auto binIndex = [&centroidBounds, &centroidExtent](const glm::vec3& c, int axis) {
+      const float relative = (c[axis] - centroidBounds.min[axis]) / centroidExtent[axis];
+      return glm::min (numBins - 1, (unsigned int) (relative * float(numBins)));
+    };
+
+    std::array<std::array<BVHBounds, numBins>, 3>    binBounds;
+    std::array<std::array<unsigned int, numBins>, 3> binCounts;
+    std::array<bool, 3>                              isSplittable;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+      binCounts[axis].fill (0);
+      isSplittable[axis] = centroidExtent[axis] > Util::epsilon ();
+    }
+    for (auto it = begin; it != end; ++it)
+    {
+      const BVHBounds& elementBounds = this->elements[*it].bounds;
+      const glm::vec3  center = elementBounds.center ();
+
+      for (int axis = 0; axis < 3; axis++)
+      {
+        if (isSplittable[axis])
+        {
+          const unsigned int b = binIndex (center, axis);
+          binBounds[axis][b].extend (elementBounds);
+          binCounts[axis][b]++;
+        }
+      }
+    }
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+      if (isSplittable[axis] == false)
+      {
+        continue;
+      }
+      std::array<float, numBins> rightCosts;
+      BVHBounds                  rightBounds;
+      unsigned int               rightCount = 0;
+      for (unsigned int b = numBins - 1; b > 0; b--)
+      {
+        rightBounds.extend (binBounds[axis][b]);
+        rightCount += binCounts[axis][b];
+        rightCosts[b - 1] = rightBounds.area () * float(rightCount);
+      }
+
+      BVHBounds    leftBounds;
+      unsigned int leftCount = 0;
+      for (unsigned int b = 0; b < numBins - 1; b++)
+      {
+        leftBounds.extend (binBounds[axis][b]);
+        leftCount += binCounts[axis][b];
+
+        const float cost =
+          traversalCost + (((leftBounds.area () * float(leftCount)) + rightCosts[b]) / area);
+        if (leftCount > 0 && leftCount < numNodeElements && cost < bestCost)
+        {
+          bestCost = cost;
+          bestAxis = axis;
+          bestSplit = b;
+        }
+      }
+    }
+
+    std::vector<unsigned int>::iterator mid;
+    if (bestAxis >= 0)
+    {
+      mid = std::partition (begin, end, [this, &binIndex, bestAxis, bestSplit](unsigned int e) {
+        return binIndex (this->elements[e].bounds.center (), bestAxis) <= bestSplit;
+      });
+    }
+    else if (numNodeElements <= maxSAHLeafElements)
+    {
+      this->makeLeaf (n, begin, end);
+      return;
+    }
+    else
+    {
+      // all centroids coincide (or splitting does not pay off): split in the middle
+      mid = begin + (numNodeElements / 2);
+    }
+    assert (mid != begin && mid != end);
+
+    const unsigned int left = this->makeNode (n);
+    const unsigned int right = this->makeNode (n);
+
+    BVHNode& node = this->nodes.mutableAt (n);
+    node.children[0] = left;
+    node.children[1] = right;
+    node.elements.clear ();
+
+    this->build (left, begin, mid);
+    this->build (right, mid, end);
+  }
+
+  float cost () const
+  {
+    if (this->hasRoot () && this->nodes[this->root].bounds.area () > 0.0f)
+    {
+      float cost = 0.0f;
+      for (unsigned int n = 0; n < this->nodes.size (); n++)
+      {
+        const BVHNode& node = this->nodes[n];
+        cost += node.bounds.area () *
+                (node.isLeaf () ? float(node.elements.size ()) : traversalCost);
+      }
+      return cost / this->nodes[this->root].bounds.area ();
+    }
+    else
+    {
+      return 0.0f;
+    }
+  }
+
+  void rebuild ()
+  {
+    std::vector<unsigned int> ids;
+    ids.reserve (this->numElements);
+
+    for (unsigned int i = 0; i < this->elements.size (); i++)
+    {
+      if (this->elements[i].isFree () == false)
+      {
+        ids.push_back (i);
+      }
+    }
+    assert (ids.size () == this->numElements);
+
+    this->resetNodes ();
+
+    if (ids.empty () == false)
+    {
+      this->nodes.reserve (2 * ids.size () / maxLeafElements);
+      this->root = this->makeNode (Util::invalidIndex ());
+      this->build (this->root, ids.begin (), ids.end ());
+    }
+    this->builtCost = this->cost ();
+  }
+
+  void addElement (unsigned int i, const glm::vec3& min, const glm::vec3& max)
+  {
+    if (i >= this->elements.size ())
+    {
+      this->elements.resize (i + 1);
+    }
+    assert (this->elements[i].isFree ());
+
+    const BVHBounds bounds (min, max);
+    this->elements.mutableAt (i).bounds = bounds;
+    this->numElements++;
+
+    if (this->hasRoot () == false)
+    {
+      this->elements.mutableAt (i).position = this->pendingElements.size ();
+      this->pendingElements.push_back (i);
+      return;
+    }
+
+    // descend into the child whose surface area grows the least
+    unsigned int n = this->root;
+    while (true)
+    {
+      BVHNode& node = this->nodes.mutableAt (n);
+      node.bounds.extend (bounds);
+
+      if (node.isLeaf ())
+      {
+        break;
+      }
+      const BVHNode& c0 = this->nodes[node.children[0]];
+      const BVHNode& c1 = this->nodes[node.children[1]];
+      const float    growth0 = BVHBounds::merge (c0.bounds, bounds).area () - c0.bounds.area ();
+      const float    growth1 = BVHBounds::merge (c1.bounds, bounds).area () - c1.bounds.area ();
+
+      n = growth0 <= growth1 ? node.children[0] : node.children[1];
+    }
+
+    this->elements.mutableAt (i).leaf = n;
+    this->elements.mutableAt (i).position = this->nodes[n].elements.size ();
+    this->nodes.mutableAt (n).elements.push_back (i);
+
+    if (this->nodes[n].elements.size () > maxInsertedLeafElements)
+    {
+      std::vector<unsigned int> leafElements (this->nodes[n].elements);
+      this->build (n, leafElements.begin (), leafElements.end ());
+    }
+  }
+
+  void markDirty (unsigned int n)
+  {
+    if (this->nodes[n].isDirty == false)
+    {
+      this->nodes.mutableAt (n).isDirty = true;
+      this->dirtyNodes.push_back (n);
+    }
+  }
+
+  void realignElement (unsigned int i, const glm::vec3& min, const glm::vec3& max)
+  {
+    assert (i < this->elements.size ());
+    assert (this->elements[i].isFree () == false);
+
+    const BVHBounds bounds (min, max);
+    this->elements.mutableAt (i).bounds = bounds;
+
+    if (this->elements[i].isPending ())
+    {
+      return;
+    }
+
+    // keep ancestors conservative until the next `refit`
+    for (unsigned int n = this->elements[i].leaf; n != Util::invalidIndex ();
+         n = this->nodes[n].parent)
+    {
+      if (this->nodes[n].bounds.contains (bounds))
+      {
+        break;
+      }
+      this->nodes.mutableAt (n).bounds.extend (bounds);
+    }
+    this->markDirty (this->elements[i].leaf);
+  }
+
+  void deleteElement (unsigned int i)
+  {
+    assert (i < this->elements.size ());
+    assert (this->elements[i].isFree () == false);
+
+    BVHElement&                element = this->elements.mutableAt (i);
+    std::vector<unsigned int>& elementsOfNode =
+      element.isPending () ? this->pendingElements : this->nodes.mutableAt (element.leaf).elements;
+
+    assert (elementsOfNode[element.position] == i);
+
+    elementsOfNode[element.position] = elementsOfNode.back ();
+    this->elements.mutableAt (elementsOfNode.back ()).position = element.position;
+    elementsOfNode.pop_back ();
+
+    const unsigned int leaf = element.leaf;
+    element = BVHElement ();
+    this->numElements--;
+
+    if (this->numElements == 0)
+    {
+      this->resetNodes ();
+    }
+    else if (leaf != Util::invalidIndex ())
+    {
+      if (this->nodes[leaf].elements.empty () && leaf != this->root)
+      {
+        this->deleteEmptyLeaf (leaf);
+      }
+      else
+      {
+        this->markDirty (leaf);
+      }
+    }
+  }
+
+  void updateIndices (const std::vector<unsigned int>& newIndices)
+  {
+    unsigned int numSurviving = 0;
+    for (unsigned int newI : newIndices)
+    {
+      if (newI != Util::invalidIndex ())
+      {
+        numSurviving = std::max (numSurviving, newI + 1);
+      }
+    }
+    std::vector<BVHElement> newElements (numSurviving);
+
+    for (unsigned int i = 0; i < newIndices.size () && i < this->elements.size (); i++)
+    {
+      if (newIndices[i] != Util::invalidIndex ())
+      {
+        assert (this->elements[i].isFree () == false);
+        newElements[newIndices[i]] = this->elements[i];
+      }
+    }
+    this->elements.assign (newElements);
+
+    for (unsigned int& e : this->pendingElements)
+    {
+      assert (newIndices[e] != Util::invalidIndex ());
+      e = newIndices[e];
+    }
+    for (unsigned int n = 0; n < this->nodes.size (); n++)
+    {
+      for (unsigned int& e : this->nodes.mutableAt (n).elements)
+      {
+        assert (newIndices[e] != Util::invalidIndex ());
+        e = newIndices[e];
+      }
+    }
+  }
+
+  void updateBounds (unsigned int n)
+  {
+    BVHNode& node = this->nodes.mutableAt (n);
+    node.bounds = BVHBounds ();
+
+    if (node.isLeaf ())
+    {
+      for (unsigned int e : node.elements)
+      {
+        node.bounds.extend (this->elements[e].bounds);
+      }
+    }
+    else
+    {
+      node.bounds.extend (this->nodes[node.children[0]].bounds);
+      node.bounds.extend (this->nodes[node.children[1]].bounds);
+    }
+  }
+
+  void refit ()
+  {
+    for (unsigned int d : this->dirtyNodes)
+    {
+      if (this->nodes[d].isDirty == false)
+      {
+        continue;
+      }
+      this->nodes.mutableAt (d).isDirty = false;
+
+      for (unsigned int n = d; n != Util::invalidIndex (); n = this->nodes[n].parent)
+      {
+        const BVHBounds oldBounds = this->nodes[n].bounds;
+        this->updateBounds (n);
+
+        if (n != d && oldBounds == this->nodes[n].bounds)
+        {
+          break;
+        }
+      }
+    }
+    this->dirtyNodes.clear ();
+
+    if (this->pendingElements.empty () == false ||
+        (this->isEmpty () == false && this->cost () > maxRelativeRefitCost * this->builtCost))
+    {
+      this->rebuild ();
+    }
+  }
+
+  void resetNodes ()
+  {
+    this->nodes.clear ();
+    this->pendingElements.clear ();
+    this->dirtyNodes.clear ();
+    this->freeNodes.clear ();
+    this->root = Util::invalidIndex ();
+    this->builtCost = 0.0f;
+  }
+
+  void reset ()
+  {
+    this->resetNodes ();
+    this->elements.clear ();
+    this->numElements = 0;
+  }
+
+  bool intersects (const BVHBounds& bounds, const PrimRay& ray, float& t) const
+  {
+    return bounds.isEmpty () == false && IntersectionUtil::intersects (ray, bounds.aabox (), &t);
+  }
+
+  void intersects (unsigned int n, const PrimRay& ray, float& distance,
+                   const DynamicBVH::NodeRayIntersectionCallback& f) const
+  {
+    const BVHNode& node = this->nodes[n];
+
+    if (node.isLeaf ())
+    {
+      if (node.elements.empty () == false)
+      {
+        distance = glm::min (f (node.elements), distance);
+      }
+    }
+    else
+    {
+      unsigned int near = node.children[0];
+      unsigned int far = node.children[1];
+      float        tNear, tFar;
+      bool         hitNear = this->intersects (this->nodes[near].bounds, ray, tNear);
+      bool         hitFar = this->intersects (this->nodes[far].bounds, ray, tFar);
+
+      if (hitNear && hitFar && tFar < tNear)
+      {
+        std::swap (near, far);
+        std::swap (tNear, tFar);
+      }
+      else if (hitNear == false)
+      {
+        std::swap (near, far);
+        std::swap (tNear, tFar);
+        std::swap (hitNear, hitFar);
+      }
+
+      if (hitNear && tNear < distance)
+      {
+        this->intersects (near, ray, distance, f);
+      }
+      if (hitFar && tFar < distance)
+      {
+        this->intersects (far, ray, distance, f);
+      }
+    }
+  }
+
+  void intersects (const PrimRay& ray, const DynamicBVH::RayIntersectionCallback& f) const
+  {
+    this->intersectsNodes (ray, DynamicVisitor::rayIntersection (f));
+  }
+
+  void intersects (const std::vector<PrimRay>&                     rays,
+                   const DynamicBVH::RayPacketIntersectionCallback& f) const
+  {
+    for (unsigned int r = 0; r < rays.size (); r++)
+    {
+      const auto rayF = [r, &f](unsigned int e) { return f (r, e); };
+      this->intersectsNodes (rays[r], DynamicVisitor::rayIntersection (rayF));
+    }
+  }
+
+  void intersects (const PrimPlane& plane, const DynamicBVH::IntersectionCallback& f) const
+  {
+    this->intersectsNodes (plane, DynamicVisitor::intersection (f));
+  }
+
+  void intersects (const PrimSphere&                               sphere,
+                   const DynamicBVH::ContainsIntersectionCallback& f) const
+  {
+    this->intersectsNodes (sphere, DynamicVisitor::containsIntersection (f));
+  }
+
+  void intersects (const PrimAABox& box, const DynamicBVH::ContainsIntersectionCallback& f) const
+  {
+    this->intersectsNodes (box, DynamicVisitor::containsIntersection (f));
+  }
+
+  float distance (const glm::vec3& p, const DynamicBVH::DistanceCallback& getDistance,
+                  unsigned int* closest) const
+  {
+    return this->distanceNodes (p, DynamicVisitor::distance (getDistance), closest);
+  }
+
+  template <typename T>
+  void intersectsT (unsigned int n, const T& t, const DynamicBVH::NodeIntersectionCallback& f) const
+  {
+    const BVHNode& node = this->nodes[n];
+
+    if (node.bounds.isEmpty () == false && IntersectionUtil::intersects (t, node.bounds.aabox ()))
+    {
+      if (node.isLeaf ())
+      {
+        if (node.elements.empty () == false)
+        {
+          f (node.elements);
+        }
+      }
+      else
+      {
+        this->intersectsT<T> (node.children[0], t, f);
+        this->intersectsT<T> (node.children[1], t, f);
+      }
+    }
+  }
+
+  void forEachLeaf (unsigned int n, const DynamicBVH::NodeIntersectionCallback& f) const
+  {
+    const BVHNode& node = this->nodes[n];
+
+    if (node.isLeaf ())
+    {
+      if (node.elements.empty () == false)
+      {
+        f (node.elements);
+      }
+    }
+    else
+    {
+      this->forEachLeaf (node.children[0], f);
+      this->forEachLeaf (node.children[1], f);
+    }
+  }
+
+  template <typename T>
+  void containsOrIntersectsT (unsigned int n, const T& t,
+                              const DynamicBVH::NodeContainsIntersectionCallback& f) const
+  {
+    const BVHNode& node = this->nodes[n];
+
+    if (node.bounds.isEmpty ())
+    {
+      return;
+    }
+    const PrimAABox aabox = node.bounds.aabox ();
+
+    if (t.contains (aabox))
+    {
+      this->forEachLeaf (n, [&f](const DynamicVisitor::Elements& elements) { f (true, elements); });
+    }
+    else if (IntersectionUtil::intersects (t, aabox))
+    {
+      if (node.isLeaf ())
+      {
+        if (node.elements.empty () == false)
+        {
+          f (false, node.elements);
+        }
+      }
+      else
+      {
+        this->containsOrIntersectsT<T> (node.children[0], t, f);
+        this->containsOrIntersectsT<T> (node.children[1], t, f);
+      }
+    }
+  }
+
+  void intersectsNodes (const PrimRay& ray, const DynamicBVH::NodeRayIntersectionCallback& f) const
+  {
+    float t;
+    float distance = Util::maxFloat ();
+
+    if (this->pendingElements.empty () == false)
+    {
+      distance = f (this->pendingElements);
+    }
+    if (this->hasRoot () && this->intersects (this->nodes[this->root].bounds, ray, t))
+    {
+      this->intersects (this->root, ray, distance, f);
+    }
+  }
+
+  void intersectsNodes (const PrimPlane& plane, const DynamicBVH::NodeIntersectionCallback& f) const
+  {
+    if (this->pendingElements.empty () == false)
+    {
+      f (this->pendingElements);
+    }
+    if (this->hasRoot ())
+    {
+      this->intersectsT<PrimPlane> (this->root, plane, f);
+    }
+  }
+
+  void intersectsNodes (const PrimSphere&                                   sphere,
+                        const DynamicBVH::NodeContainsIntersectionCallback& f) const
+  {
+    if (this->pendingElements.empty () == false)
+    {
+      f (false, this->pendingElements);
+    }
+    if (this->hasRoot ())
+    {
+      this->containsOrIntersectsT<PrimSphere> (this->root, sphere, f);
+    }
+  }
+
+  void intersectsNodes (const PrimAABox&                                    box,
+                        const DynamicBVH::NodeContainsIntersectionCallback& f) const
+  {
+    if (this->pendingElements.empty () == false)
+    {
+      f (false, this->pendingElements);
+    }
+    if (this->hasRoot ())
+    {
+      this->containsOrIntersectsT<PrimAABox> (this->root, box, f);
+    }
+  }
+
+  void distance (unsigned int n, PrimSphere& sphere, unsigned int& closest,
+                 const DynamicBVH::NodeDistanceCallback& getDistance) const
+  {
+    const BVHNode& node = this->nodes[n];
+
+    if (node.isLeaf ())
+    {
+      if (node.elements.empty () == false)
+      {
+        float distance = sphere.radius ();
+        getDistance (node.elements, distance, closest);
+        sphere.radius (distance);
+      }
+    }
+    else
+    {
+      unsigned int near = node.children[0];
+      unsigned int far = node.children[1];
+
+      if (this->nodes[far].bounds.distance2 (sphere.center ()) <
+          this->nodes[near].bounds.distance2 (sphere.center ()))
+      {
+        std::swap (near, far);
+      }
+      for (unsigned int c : {near, far})
+      {
+        const BVHBounds& bounds = this->nodes[c].bounds;
+        if (bounds.isEmpty () == false && IntersectionUtil::intersects (sphere, bounds.aabox ()))
+        {
+          this->distance (c, sphere, closest, getDistance);
+        }
+      }
+    }
+  }
+
+  float distanceNodes (const glm::vec3& p, const DynamicBVH::NodeDistanceCallback& getDistance,
+                       unsigned int* closest) const
+  {
+    assert (this->isEmpty () == false);
+    float        distance = Util::maxFloat ();
+    unsigned int closestElement = Util::invalidIndex ();
+
+    if (this->pendingElements.empty () == false)
+    {
+      getDistance (this->pendingElements, distance, closestElement);
+    }
+    if (this->hasRoot ())
+    {
+      PrimSphere sphere (p, distance);
+      this->distance (this->root, sphere, closestElement, getDistance);
+      distance = sphere.radius ();
+    }
+    if (closest)
+    {
+      *closest = closestElement;
+    }
+    return distance;
+  }
+
+  void updateStatistics (unsigned int n, int depth, BVHStatistics& stats) const
+  {
+    const BVHNode& node = this->nodes[n];
+
+    stats.numNodes++;
+    stats.maxDepth = glm::max (stats.maxDepth, depth);
+
+    if (node.isLeaf ())
+    {
+      stats.numLeaves++;
+      stats.numElements += node.elements.size ();
+      stats.maxElementsPerLeaf =
+        glm::max (stats.maxElementsPerLeaf, (unsigned int) node.elements.size ());
+    }
+    else
+    {
+      this->updateStatistics (node.children[0], depth + 1, stats);
+      this->updateStatistics (node.children[1], depth + 1, stats);
+    }
+  }
+
+  void printStatistics () const
+  {
+    BVHStatistics stats{0, 0, 0, (unsigned int) this->pendingElements.size (), 0, 0};
+
+    if (this->hasRoot ())
+    {
+      this->updateStatistics (this->root, 0, stats);
+    }
+    std::cout << "bvh:"
+              << "\n\tnum nodes:\t\t\t" << stats.numNodes << "\n\tnum leaves:\t\t\t"
+              << stats.numLeaves << "\n\tnum elements:\t\t\t" << stats.numElements
+              << "\n\tnum pending elements:\t\t" << stats.numPendingElements
+              << "\n\tmax elements per leaf:\t\t" << stats.maxElementsPerLeaf
+              << "\n\tmax depth:\t\t\t" << stats.maxDepth << "\n\tSAH cost:\t\t\t"
+              << this->cost () << " (built: " << this->builtCost << ")" << std::endl;
+  }
+
+  std::size_t memoryBytes () const
+  {
+    return sizeof (DynamicBVH::Impl) + this->nodes.memoryBytes () + this->elements.memoryBytes () +
+           (this->pendingElements.capacity () * sizeof (unsigned int)) +
+           (this->dirtyNodes.capacity () * sizeof (unsigned int)) +
+           (this->freeNodes.capacity () * sizeof (unsigned int));
+  }
+
+  unsigned int numNodes () const { return this->nodes.size () - this->freeNodes.size (); }
+};
+
+DELEGATE_BIG4_COPY (DynamicBVH)
+
+DELEGATE_CONST (bool, DynamicBVH, isEmpty)
+DELEGATE3 (void, DynamicBVH, addElement, unsigned int, const glm::vec3&, const glm::vec3&)
+DELEGATE3 (void, DynamicBVH, realignElement, unsigned int, const glm::vec3&, const glm::vec3&)
+DELEGATE1 (void, DynamicBVH, deleteElement, unsigned int)
+DELEGATE1 (void, DynamicBVH, updateIndices, const std::vector<unsigned int>&)
+DELEGATE (void, DynamicBVH, refit)
+DELEGATE (void, DynamicBVH, rebuild)
+DELEGATE (void, DynamicBVH, reset)
+DELEGATE2_CONST (void, DynamicBVH, intersects, const PrimRay&,
+                 const DynamicBVH::RayIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicBVH, intersects, const std::vector<PrimRay>&,
+                 const DynamicBVH::RayPacketIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicBVH, intersects, const PrimPlane&,
+                 const DynamicBVH::IntersectionCallback&)
+DELEGATE2_CONST (void, DynamicBVH, intersects, const PrimSphere&,
+                 const DynamicBVH::ContainsIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicBVH, intersects, const PrimAABox&,
+                 const DynamicBVH::ContainsIntersectionCallback&)
+DELEGATE3_CONST (float, DynamicBVH, distance, const glm::vec3&,
+                 const DynamicBVH::DistanceCallback&, unsigned int*)
+DELEGATE2_CONST (void, DynamicBVH, intersectsNodes, const PrimRay&,
+                 const DynamicBVH::NodeRayIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicBVH, intersectsNodes, const PrimPlane&,
+                 const DynamicBVH::NodeIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicBVH, intersectsNodes, const PrimSphere&,
+                 const DynamicBVH::NodeContainsIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicBVH, intersectsNodes, const PrimAABox&,
+                 const DynamicBVH::NodeContainsIntersectionCallback&)
+DELEGATE3_CONST (float, DynamicBVH, distanceNodes, const glm::vec3&,
+                 const DynamicBVH::NodeDistanceCallback&, unsigned int*)
+DELEGATE_CONST (void, DynamicBVH, printStatistics)
+DELEGATE_CONST (std::size_t, DynamicBVH, memoryBytes)
+DELEGATE_CONST (unsigned int, DynamicBVH, numNodes)
@@ -0,0 +1,96 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DYNAMIC_BVH
+#define DILAY_DYNAMIC_BVH
+
+#include <cstddef>
+#include <functional>
+#include <glm/fwd.hpp>
+#include <vector>
+#include "dynamic/visitor.hpp"
+#include "macro.hpp"
+
+class PrimAABox;
+class PrimPlane;
+class PrimRay;
+class PrimSphere;
+
+/* A bounding volume hierarchy built with the surface area heuristic (SAH).
+ * Its queries match those of `DynamicOctree`. Moved elements only refit the hierarchy;
+ * `refit` rebuilds it once the refitted hierarchy became too costly.
+ */
+class DynamicBVH
+{
+public:
+  DECLARE_BIG4_EXPLICIT_COPY (DynamicBVH)
+
+  typedef std::function<void(unsigned int)>                IntersectionCallback;
+  typedef std::function<float(unsigned int)>               RayIntersectionCallback;
+  typedef std::function<float(unsigned int, unsigned int)> RayPacketIntersectionCallback;
+  typedef std::function<void(bool, unsigned int)>          ContainsIntersectionCallback;
+  typedef std::function<float(unsigned int)>               DistanceCallback;
+
+  typedef std::function<void(const DynamicVisitor::Elements&)>  NodeIntersectionCallback;
+  typedef std::function<float(const DynamicVisitor::Elements&)> NodeRayIntersectionCallback;
+  typedef std::function<void(bool, const DynamicVisitor::Elements&)>
+    NodeContainsIntersectionCallback;
+  typedef std::function<void(const DynamicVisitor::Elements&, float&, unsigned int&)>
+    NodeDistanceCallback;
+
+  bool  isEmpty () const;
+  void  addElement (unsigned int, const glm::vec3&, const glm::vec3&);
+  void  realignElement (unsigned int, const glm::vec3&, const glm::vec3&);
+  void  deleteElement (unsigned int);
+  void  updateIndices (const std::vector<unsigned int>&);
+  void  refit ();
+  void  rebuild ();
+  void  reset ();
+  void  intersects (const PrimRay&, const RayIntersectionCallback&) const;
+  void  intersects (const std::vector<PrimRay>&, const RayPacketIntersectionCallback&) const;
+  void  intersects (const PrimPlane&, const IntersectionCallback&) const;
+  void  intersects (const PrimSphere&, const ContainsIntersectionCallback&) const;
+  void  intersects (const PrimAABox&, const ContainsIntersectionCallback&) const;
+  float distance (const glm::vec3&, const DistanceCallback&, unsigned int* = nullptr) const;
+  void  intersectsNodes (const PrimRay&, const NodeRayIntersectionCallback&) const;
+  void  intersectsNodes (const PrimPlane&, const NodeIntersectionCallback&) const;
+  void  intersectsNodes (const PrimSphere&, const NodeContainsIntersectionCallback&) const;
+  void  intersectsNodes (const PrimAABox&, const NodeContainsIntersectionCallback&) const;
+  float distanceNodes (const glm::vec3&, const NodeDistanceCallback&,
+                       unsigned int* = nullptr) const;
+  void         printStatistics () const;
+  std::size_t  memoryBytes () const;
+  unsigned int numNodes () const;
+
+  template <typename F> void intersectsT (const PrimRay& ray, const F& f) const
+  {
+    this->intersectsNodes (ray, DynamicVisitor::rayIntersection (f));
+  }
+
+  template <typename F> void intersectsT (const PrimPlane& plane, const F& f) const
+  {
+    this->intersectsNodes (plane, DynamicVisitor::intersection (f));
+  }
+
+  template <typename F> void intersectsT (const PrimSphere& sphere, const F& f) const
+  {
+    this->intersectsNodes (sphere, DynamicVisitor::containsIntersection (f));
+  }
+
+  template <typename F> void intersectsT (const PrimAABox& box, const F& f) const
+  {
+    this->intersectsNodes (box, DynamicVisitor::containsIntersection (f));
+  }
+
+  template <typename F>
+  float distanceT (const glm::vec3& p, const F& f, unsigned int* closest = nullptr) const
+  {
+    return this->distanceNodes (p, DynamicVisitor::distance (f), closest);
+  }
+
+private:
+  IMPLEMENTATION
+};
+
+#endif
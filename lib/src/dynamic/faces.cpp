@@ -2,39 +2,244 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
+#include <limits>
+#include <memory>
 #include "dynamic/faces.hpp"
 
-void DynamicFaces::insert (unsigned int i) { this->_uncommitted.insert (i); }
+/* A face `i` is committed if `values[i] == generation`, uncommitted if
+ * `values[i] == generation + 1` and both if `values[i] == generation + 2`, i.e., if a committed
+ * face has been inserted again. Advancing the generation removes all faces at once.
+ */
+class DynamicFacesStamps
+{
+public:
+  std::vector<unsigned int> values;
+  unsigned int              generation;
+
+  DynamicFacesStamps ()
+    : generation (0)
+  {
+  }
+
+  void advance ()
+  {
+    if (this->generation >= std::numeric_limits<unsigned int>::max () - 6)
+    {
+      std::fill (this->values.begin (), this->values.end (), 0);
+      this->generation = 0;
+    }
+    this->generation += 3;
+  }
+
+  unsigned int committed () const { return this->generation; }
+  unsigned int uncommitted () const { return this->generation + 1; }
+  unsigned int both () const { return this->generation + 2; }
+
+  bool isCommitted (unsigned int i) const
+  {
+    return this->values[i] == this->committed () || this->values[i] == this->both ();
+  }
+
+  // removes `i` from the committed faces if `committed` or from the uncommitted faces otherwise
+  void remove (unsigned int i, bool committed)
+  {
+    if (this->values[i] == this->both ())
+    {
+      this->values[i] = committed ? this->uncommitted () : this->committed ();
+    }
+    else
+    {
+      this->values[i] = 0;
+    }
+  }
+
+  void reserve (unsigned int i)
+  {
+    if (i >= this->values.size ())
+    {
+      this->values.resize (std::max (i + 1, 2 * (unsigned int) (this->values.size ())), 0);
+    }
+  }
+};
+
+namespace
+{
+  static const unsigned int maxNumPooledStamps = 8;
+
+  typedef std::vector<std::unique_ptr<DynamicFacesStamps>> StampsPool;
+
+  StampsPool& stampsPool ()
+  {
+    thread_local StampsPool pool;
+    return pool;
+  }
+
+  DynamicFacesStamps* acquireStamps ()
+  {
+    StampsPool&         pool = stampsPool ();
+    DynamicFacesStamps* stamps = nullptr;
+
+    if (pool.empty ())
+    {
+      stamps = new DynamicFacesStamps;
+    }
+    else
+    {
+      stamps = pool.back ().release ();
+      pool.pop_back ();
+    }
+    stamps->advance ();
+    return stamps;
+  }
+
+  void releaseStamps (DynamicFacesStamps* stamps)
+  {
+    StampsPool& pool = stampsPool ();
+
+    if (stamps && pool.size () < maxNumPooledStamps)
+    {
+      pool.emplace_back (stamps);
+    }
+    else
+    {
+      delete stamps;
+    }
+  }
+}
+
+DynamicFaces::DynamicFaces ()
+  : _stamps (nullptr)
+{
+}
+
+DynamicFaces::DynamicFaces (const DynamicFaces& other)
+  : _indices (other._indices)
+  , _uncommitted (other._uncommitted)
+  , _stamps (nullptr)
+{
+  if (this->isEmpty () == false)
+  {
+    this->_stamps = acquireStamps ();
+
+    for (unsigned int i : this->_indices)
+    {
+      this->_stamps->reserve (i);
+      this->_stamps->values[i] = this->_stamps->committed ();
+    }
+    for (unsigned int i : this->_uncommitted)
+    {
+      this->_stamps->reserve (i);
+      this->_stamps->values[i] = this->_stamps->isCommitted (i) ? this->_stamps->both ()
+                                                                : this->_stamps->uncommitted ();
+    }
+  }
+}
+
+DynamicFaces::DynamicFaces (DynamicFaces&& other)
+  : _indices (std::move (other._indices))
+  , _uncommitted (std::move (other._uncommitted))
+  , _stamps (other._stamps)
+{
+  other._indices.clear ();
+  other._uncommitted.clear ();
+  other._stamps = nullptr;
+}
+
+DynamicFaces& DynamicFaces::operator= (const DynamicFaces& other)
+{
+  if (this != &other)
+  {
+    *this = DynamicFaces (other);
+  }
+  return *this;
+}
+
+DynamicFaces& DynamicFaces::operator= (DynamicFaces&& other)
+{
+  if (this != &other)
+  {
+    releaseStamps (this->_stamps);
+
+    this->_indices = std::move (other._indices);
+    this->_uncommitted = std::move (other._uncommitted);
+    this->_stamps = other._stamps;
+
+    other._indices.clear ();
+    other._uncommitted.clear ();
+    other._stamps = nullptr;
+  }
+  return *this;
+}
+
+DynamicFaces::~DynamicFaces () { releaseStamps (this->_stamps); }
+
+void DynamicFaces::insert (unsigned int i)
+{
+  if (this->_stamps == nullptr)
+  {
+    this->_stamps = acquireStamps ();
+  }
+  this->_stamps->reserve (i);
+
+  unsigned int& stamp = this->_stamps->values[i];
+
+  if (stamp == this->_stamps->committed ())
+  {
+    stamp = this->_stamps->both ();
+    this->_uncommitted.push_back (i);
+  }
+  else if (stamp != this->_stamps->uncommitted () && stamp != this->_stamps->both ())
+  {
+    stamp = this->_stamps->uncommitted ();
+    this->_uncommitted.push_back (i);
+  }
+}
 
 void DynamicFaces::insert (const DynamicFaces::Container& v)
 {
-  this->_uncommitted.insert (v.begin (), v.end ());
+  for (unsigned int i : v)
+  {
+    this->insert (i);
+  }
 }
 
 void DynamicFaces::reset ()
 {
-  this->resetCommitted ();
+  this->_indices.clear ();
   this->_uncommitted.clear ();
-}
 
-void DynamicFaces::resetCommitted () { this->_indices.clear (); }
+  if (this->_stamps)
+  {
+    this->_stamps->advance ();
+  }
+}
 
-void DynamicFaces::commit ()
+void DynamicFaces::resetCommitted ()
 {
-  if (this->_indices.empty ())
+  for (unsigned int i : this->_indices)
   {
-    this->_indices.swap (this->_uncommitted);
+    this->_stamps->remove (i, true);
   }
-  else
+  this->_indices.clear ();
+}
+
+void DynamicFaces::commit ()
+{
+  for (unsigned int i : this->_uncommitted)
   {
-    this->_indices.insert (this->_uncommitted.begin (), this->_uncommitted.end ());
-    this->_uncommitted.clear ();
+    if (this->_stamps->values[i] == this->_stamps->uncommitted ())
+    {
+      this->_indices.push_back (i);
+    }
+    this->_stamps->values[i] = this->_stamps->committed ();
   }
+  this->_uncommitted.clear ();
 }
 
 bool DynamicFaces::contains (unsigned int i) const
 {
-  return this->_indices.find (i) != this->_indices.end ();
+  return this->_stamps && i < this->_stamps->values.size () && this->_stamps->isCommitted (i);
 }
 
 bool DynamicFaces::isEmpty () const
@@ -46,26 +251,21 @@ bool DynamicFaces::hasUncomitted () const { return this->_uncommitted.empty () =
 
 void DynamicFaces::filter (const std::function<bool(unsigned int)>& f)
 {
-  for (auto it = this->_indices.begin (); it != this->_indices.end ();)
-  {
-    if (f (*it) == false)
-    {
-      it = this->_indices.erase (it);
-    }
-    else
-    {
-      ++it;
-    }
-  }
-  for (auto it = this->_uncommitted.begin (); it != this->_uncommitted.end ();)
-  {
-    if (f (*it) == false)
+  const auto filterContainer = [this, &f](Container& container, bool committed) {
+    unsigned int n = 0;
+    for (unsigned int i : container)
     {
-      it = this->_uncommitted.erase (it);
+      if (f (i))
+      {
+        container[n++] = i;
+      }
+      else
+      {
+        this->_stamps->remove (i, committed);
+      }
     }
-    else
-    {
-      ++it;
-    }
-  }
+    container.resize (n);
+  };
+  filterContainer (this->_indices, true);
+  filterContainer (this->_uncommitted, false);
 }
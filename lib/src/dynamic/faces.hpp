@@ -6,19 +6,31 @@
 #define DILAY_DYNAMIC_FACES
 
 #include <functional>
-#include <unordered_set>
+#include <vector>
 
+class DynamicFacesStamps;
+
+/* A sparse set of face indices: elements are stored densely in insertion order, membership is
+ * tracked by stamps indexed by face. Stamps are recycled between sets, so that clearing a set and
+ * creating a new one do not depend on the size of the mesh. Inserting a committed face adds it to
+ * the uncommitted faces again; committing does not duplicate it.
+ */
 class DynamicFaces
 {
 public:
-  typedef std::unordered_set<unsigned int> Container;
+  typedef std::vector<unsigned int> Container;
+
+  DynamicFaces ();
+  DynamicFaces (const DynamicFaces&);
+  DynamicFaces (DynamicFaces&&);
+  DynamicFaces& operator= (const DynamicFaces&);
+  DynamicFaces& operator= (DynamicFaces&&);
+  ~DynamicFaces ();
 
   const Container& indices () const { return this->_indices; }
   const Container& uncommitted () const { return this->_uncommitted; }
   unsigned int     numElements () const { return this->_indices.size (); }
 
-  Container::iterator       begin () { return this->_indices.begin (); }
-  Container::iterator       end () { return this->_indices.end (); }
   Container::const_iterator begin () const { return this->_indices.begin (); }
   Container::const_iterator end () const { return this->_indices.end (); }
 
@@ -33,8 +45,9 @@ public:
   void filter (const std::function<bool(unsigned int)>&);
 
 private:
-  Container _indices;
-  Container _uncommitted;
+  Container           _indices;
+  Container           _uncommitted;
+  DynamicFacesStamps* _stamps;
 };
 
 #endif
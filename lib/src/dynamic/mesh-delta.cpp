@@ -0,0 +1,151 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <QByteArray>
+#include <cassert>
+#include "binary-util.hpp"
+#include "dynamic/mesh-delta.hpp"
+
+namespace
+{
+  // favors speed over ratio since deltas are compressed while sculpting
+  constexpr int compressionLevel = 1;
+}
+
+QByteArray DynamicMeshDelta::compress () const
+{
+  QByteArray         data;
+  std::vector<float> floats;
+  unsigned int       previous;
+
+  BinaryUtil::putVarint (data, this->numVertexSlots);
+  BinaryUtil::putVarint (data, this->numFaceSlots);
+  BinaryUtil::putVarint (data, this->vertices.size ());
+  BinaryUtil::putVarint (data, this->adjacentFaces.size ());
+  BinaryUtil::putVarint (data, this->faces.size ());
+
+  // adjacent faces are recorded in the order of their vertices
+  unsigned int firstAdjacentFace = 0;
+  previous = 0;
+  floats.reserve (6 * this->vertices.size ());
+  for (const Vertex& v : this->vertices)
+  {
+    assert (v.firstAdjacentFace == firstAdjacentFace);
+    firstAdjacentFace += v.numAdjacentFaces;
+
+    BinaryUtil::putIndex (data, previous, v.index);
+    BinaryUtil::putVarint (data, v.numAdjacentFaces);
+    data.append (char(v.isFree));
+
+    floats.insert (floats.end (), {v.position.x, v.position.y, v.position.z});
+    floats.insert (floats.end (), {v.normal.x, v.normal.y, v.normal.z});
+  }
+  assert (firstAdjacentFace == this->adjacentFaces.size ());
+  BinaryUtil::putFloats (data, floats);
+
+  previous = 0;
+  for (unsigned int f : this->adjacentFaces)
+  {
+    BinaryUtil::putIndex (data, previous, f);
+  }
+
+  unsigned int previousVertex = 0;
+  unsigned int previousTwin = 0;
+  previous = 0;
+  for (const Face& f : this->faces)
+  {
+    BinaryUtil::putIndex (data, previous, f.index);
+    data.append (char(f.isFree));
+
+    for (unsigned int k = 0; k < 3; k++)
+    {
+      BinaryUtil::putIndex (data, previousVertex, f.vertices[k]);
+      BinaryUtil::putIndex (data, previousTwin, f.twins[k]);
+    }
+  }
+  return qCompress (data, compressionLevel);
+}
+
+bool DynamicMeshDelta::decompress (const QByteArray& compressed, DynamicMeshDelta& result)
+{
+  const QByteArray   data = qUncompress (compressed);
+  BinaryUtil::Reader reader (data);
+  DynamicMeshDelta   delta;
+  std::vector<float> floats;
+  unsigned int       previous;
+
+  delta.numVertexSlots = reader.varint ();
+  delta.numFaceSlots = reader.varint ();
+
+  const std::size_t numVertices = reader.varint ();
+  const std::size_t numAdjacentFaces = reader.varint ();
+  const std::size_t numFaces = reader.varint ();
+
+  // a vertex takes at least 27 bytes, an adjacent face 1 byte and a face 8 bytes
+  if (reader.failed () ||
+      (27 * numVertices) + numAdjacentFaces + (8 * numFaces) > reader.remaining ())
+  {
+    return false;
+  }
+  delta.vertices.resize (numVertices);
+  delta.adjacentFaces.resize (numAdjacentFaces);
+  delta.faces.resize (numFaces);
+
+  unsigned int firstAdjacentFace = 0;
+  previous = 0;
+  for (Vertex& v : delta.vertices)
+  {
+    v.index = reader.index (previous);
+    v.firstAdjacentFace = firstAdjacentFace;
+    v.numAdjacentFaces = reader.varint ();
+    v.isFree = reader.flag ();
+
+    if (v.numAdjacentFaces > numAdjacentFaces - firstAdjacentFace)
+    {
+      return false;
+    }
+    firstAdjacentFace += v.numAdjacentFaces;
+  }
+  if (firstAdjacentFace != numAdjacentFaces)
+  {
+    return false;
+  }
+
+  floats.resize (6 * delta.vertices.size ());
+  reader.floats (floats);
+  for (unsigned int i = 0; i < delta.vertices.size (); i++)
+  {
+    const float* f = &floats[6 * i];
+    delta.vertices[i].position = glm::vec3 (f[0], f[1], f[2]);
+    delta.vertices[i].normal = glm::vec3 (f[3], f[4], f[5]);
+  }
+
+  previous = 0;
+  for (unsigned int& f : delta.adjacentFaces)
+  {
+    f = reader.index (previous);
+  }
+
+  unsigned int previousVertex = 0;
+  unsigned int previousTwin = 0;
+  previous = 0;
+  for (Face& f : delta.faces)
+  {
+    f.index = reader.index (previous);
+    f.isFree = reader.flag ();
+
+    for (unsigned int k = 0; k < 3; k++)
+    {
+      f.vertices[k] = reader.index (previousVertex);
+      f.twins[k] = reader.index (previousTwin);
+    }
+  }
+
+  if (reader.done () == false)
+  {
+    return false;
+  }
+  result = std::move (delta);
+  return true;
+}
@@ -0,0 +1,68 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DYNAMIC_MESH_DELTA
+#define DILAY_DYNAMIC_MESH_DELTA
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include <vector>
+
+class QByteArray;
+
+/* Changes of a `DynamicMesh` as recorded between `DynamicMesh::startRecording` and
+ * `DynamicMesh::stopRecording`: the previous state of each modified vertex and face and the
+ * previous number of vertices and faces (including free ones). Applying a delta (cf.
+ * `DynamicMesh::applyDelta`) restores this state and turns the delta into its inverse.
+ */
+class DynamicMeshDelta
+{
+public:
+  struct Vertex
+  {
+    unsigned int index;
+    bool         isFree;
+    glm::vec3    position;
+    glm::vec3    normal;
+    unsigned int firstAdjacentFace; // index into `adjacentFaces`
+    unsigned int numAdjacentFaces;
+  };
+
+  struct Face
+  {
+    unsigned int index;
+    bool         isFree;
+    unsigned int vertices[3];
+    unsigned int twins[3];
+  };
+
+  unsigned int              numVertexSlots;
+  unsigned int              numFaceSlots;
+  std::vector<Vertex>       vertices;
+  std::vector<unsigned int> adjacentFaces;
+  std::vector<Face>         faces;
+
+  DynamicMeshDelta ()
+    : numVertexSlots (0)
+    , numFaceSlots (0)
+  {
+  }
+
+  bool isEmpty () const { return this->vertices.empty () && this->faces.empty (); }
+
+  std::size_t memoryBytes () const
+  {
+    return (this->vertices.capacity () * sizeof (Vertex)) +
+           (this->adjacentFaces.capacity () * sizeof (unsigned int)) +
+           (this->faces.capacity () * sizeof (Face));
+  }
+
+  // lossless: indices are delta-coded, positions and normals are kept exactly
+  QByteArray compress () const;
+
+  // returns `false` and leaves the delta untouched if the data is corrupt
+  static bool decompress (const QByteArray&, DynamicMeshDelta&);
+};
+
+#endif
@@ -2,19 +2,27 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <algorithm>
 #include <cstring>
 #include <glm/glm.hpp>
 #include <glm/gtx/norm.hpp>
+#include <mutex>
 #include <vector>
 #include "../mesh.hpp"
 #include "config.hpp"
+#include "cow-vector.hpp"
 #include "distance.hpp"
+#include "dynamic/adjacency.hpp"
+#include "dynamic/bvh.hpp"
 #include "dynamic/faces.hpp"
+#include "dynamic/mesh-delta.hpp"
 #include "dynamic/mesh-intersection.hpp"
 #include "dynamic/mesh.hpp"
 #include "dynamic/octree.hpp"
 #include "intersection.hpp"
+#include "memory-usage.hpp"
 #include "mesh-util.hpp"
+#include "parallel.hpp"
 #include "primitive/plane.hpp"
 #include "primitive/ray.hpp"
 #include "primitive/triangle.hpp"
@@ -23,61 +31,285 @@
 
 namespace
 {
+  /* The octree is checked by `sanitize` once `octreeCheckRatio` of the faces have been added,
+   * realigned or deleted since the last check. It is rebuilt if its root is wider than
+   * `maxRelativeOctreeRootWidth` times the mesh's extent or if a node holds more than
+   * `maxOctreeElementsPerNode` elements. The new octree is only kept if it lowers the query cost
+   * by at least `minOctreeCostGain`, otherwise the interval between checks doubles.
+   */
+  constexpr float        octreeCheckRatio = 0.25f;
+  constexpr float        maxRelativeOctreeRootWidth = 4.0f;
+  constexpr unsigned int maxOctreeElementsPerNode = 1024;
+  constexpr float        minOctreeCostGain = 0.2f;
+  constexpr unsigned int numOctreeQueryCostSamples = 64;
+
+  // a mesh is sparse if more than `maxFreeElementRatio` of its vertices or faces are free
+  constexpr float maxFreeElementRatio = 0.25f;
+
+  // whole-mesh passes split their elements into ranges of at least this size
+  constexpr unsigned int minParallelRangeSize = 16384;
+
   struct VertexData
   {
-    bool                      isFree;
-    std::vector<unsigned int> adjacentFaces;
+    bool isFree;
 
     VertexData () { this->reset (); }
-    void reset ()
+    void reset () { this->isFree = true; }
+  };
+
+  struct FaceData
+  {
+    bool isFree;
+
+    FaceData () { this->reset (); }
+    void reset () { this->isFree = true; }
+  };
+
+  // like `Util::prune` with `isFree` as predicate
+  template <typename T> void pruneData (CowVector<T>& data, std::vector<unsigned int>& indexMap)
+  {
+    std::vector<T> values;
+    values.reserve (data.size ());
+
+    for (unsigned int i = 0; i < data.size (); i++)
     {
-      this->isFree = true;
-      this->adjacentFaces.clear ();
+      values.push_back (data[i]);
     }
+    Util::prune<T> (values, [](const T& d) { return d.isFree; }, &indexMap);
+    data.assign (values);
+  }
+
+  // copies of a mesh get their own mutex
+  struct PendingFacesMutex
+  {
+    std::mutex mutex;
+
+    PendingFacesMutex () {}
+    PendingFacesMutex (const PendingFacesMutex&) {}
+    PendingFacesMutex& operator= (const PendingFacesMutex&) { return *this; }
+  };
+
+  // bounds of a face as required by the spatial indices
+  struct FaceBounds
+  {
+    glm::vec3 center;
+    float     maxDimExtent;
+    glm::vec3 minimum;
+    glm::vec3 maximum;
+
+    FaceBounds () {}
+
+    FaceBounds (const PrimTriangle& tri)
+      : center (tri.center ())
+      , maxDimExtent (tri.maxDimExtent ())
+      , minimum (tri.minimum ())
+      , maximum (tri.maximum ())
+    {
+    }
+  };
+
+  /* Computes the (area-weighted) normals of up to `size` faces at once: edge vectors are gathered
+   * into separate component arrays and the cross products always run over the whole batch, so
+   * that the compiler can vectorize them.
+   */
+  struct FaceNormalBatch
+  {
+    static constexpr unsigned int size = 256;
 
-    void addAdjacentFace (unsigned int face) { this->adjacentFaces.push_back (face); }
+    unsigned int        numFaces;
+    const unsigned int* faces;
+    unsigned int        indices[3 * size];
+    float        ux[size], uy[size], uz[size];
+    float        vx[size], vy[size], vz[size];
+    float        nx[size], ny[size], nz[size];
 
-    void deleteAdjacentFace (unsigned int face)
+    void gather (const Mesh& mesh, const unsigned int* faces, unsigned int n)
     {
-      for (auto it = this->adjacentFaces.begin (); it != this->adjacentFaces.end (); ++it)
+      assert (n <= size);
+      this->numFaces = n;
+      this->faces = faces;
+
+      for (unsigned int i = 0; i < n; i++)
       {
-        if (*it == face)
-        {
-          this->adjacentFaces.erase (it);
-          return;
-        }
+        const unsigned int i1 = mesh.index ((3 * faces[i]) + 0);
+        const unsigned int i2 = mesh.index ((3 * faces[i]) + 1);
+        const unsigned int i3 = mesh.index ((3 * faces[i]) + 2);
+
+        const glm::vec3& p1 = mesh.vertex (i1);
+        const glm::vec3  u = mesh.vertex (i2) - p1;
+        const glm::vec3  v = mesh.vertex (i3) - p1;
+
+        this->indices[(3 * i) + 0] = i1;
+        this->indices[(3 * i) + 1] = i2;
+        this->indices[(3 * i) + 2] = i3;
+        this->ux[i] = u.x;
+        this->uy[i] = u.y;
+        this->uz[i] = u.z;
+        this->vx[i] = v.x;
+        this->vy[i] = v.y;
+        this->vz[i] = v.z;
+      }
+      for (unsigned int i = n; i < size; i++)
+      {
+        this->ux[i] = this->uy[i] = this->uz[i] = 0.0f;
+        this->vx[i] = this->vy[i] = this->vz[i] = 0.0f;
+      }
+    }
+
+    void computeNormals ()
+    {
+      for (unsigned int i = 0; i < size; i++)
+      {
+        this->nx[i] = (this->uy[i] * this->vz[i]) - (this->uz[i] * this->vy[i]);
+        this->ny[i] = (this->uz[i] * this->vx[i]) - (this->ux[i] * this->vz[i]);
+        this->nz[i] = (this->ux[i] * this->vy[i]) - (this->uy[i] * this->vx[i]);
       }
-      DILAY_IMPOSSIBLE
+    }
+
+    glm::vec3 normal (unsigned int i) const
+    {
+      assert (i < this->numFaces);
+      return glm::vec3 (this->nx[i], this->ny[i], this->nz[i]);
     }
   };
 
-  struct FaceData
+  /* Updates the free indices of the elements of a delta: `before[j]` and `after[j]` are the
+   * states of the same element, which is free if it is marked as free and if it is less than the
+   * number of elements.
+   */
+  template <typename T>
+  void updateFreeIndices (std::vector<unsigned int>& freeIndices, const std::vector<T>& before,
+                          unsigned int numBefore, const std::vector<T>& after,
+                          unsigned int numAfter)
   {
-    bool isFree;
+    assert (before.size () == after.size ());
 
-    FaceData () { this->reset (); }
-    void reset () { this->isFree = true; }
-  };
+    std::vector<unsigned int> notFree;
+    for (unsigned int j = 0; j < before.size (); j++)
+    {
+      const unsigned int i = before[j].index;
+      const bool         wasFree = i < numBefore && before[j].isFree;
+      const bool         isFree = i < numAfter && after[j].isFree;
+
+      if (wasFree && isFree == false)
+      {
+        notFree.push_back (i);
+      }
+      else if (wasFree == false && isFree)
+      {
+        freeIndices.push_back (i);
+      }
+    }
+
+    if (notFree.empty () == false)
+    {
+      std::sort (notFree.begin (), notFree.end ());
+      freeIndices.erase (std::remove_if (freeIndices.begin (), freeIndices.end (),
+                                         [&notFree](unsigned int i) {
+                                           return std::binary_search (notFree.begin (),
+                                                                      notFree.end (), i);
+                                         }),
+                         freeIndices.end ());
+    }
+  }
+
+  /* Fills the lowest (at most `maxMoves`) free slots by moving the last elements: `move (from, to)`
+   * moves element `from` into the free slot `to` and appends `from` to `freeIndices`. Free slots
+   * at the end are passed to `record` and removed. Returns the number of remaining slots.
+   * Only the filled slots are sorted, i.e., the costs for large lists of free slots stay linear.
+   */
+  template <typename IsFree, typename Record, typename Move>
+  unsigned int compactSlots (std::vector<unsigned int>& freeIndices, unsigned int numSlots,
+                             unsigned int maxMoves, const IsFree& isFree, const Record& record,
+                             const Move& move)
+  {
+    const unsigned int numCandidates = std::min (maxMoves, (unsigned int) freeIndices.size ());
+
+    std::nth_element (freeIndices.begin (), freeIndices.begin () + numCandidates,
+                      freeIndices.end ());
+    std::sort (freeIndices.begin (), freeIndices.begin () + numCandidates);
+
+    unsigned int numFilled = 0;
+    for (;;)
+    {
+      while (numSlots > 0 && isFree (numSlots - 1))
+      {
+        record (numSlots - 1);
+        numSlots--;
+      }
+      if (numFilled == numCandidates || freeIndices[numFilled] >= numSlots)
+      {
+        break;
+      }
+      move (numSlots - 1, freeIndices[numFilled++]);
+    }
+    freeIndices.erase (freeIndices.begin (), freeIndices.begin () + numFilled);
+    freeIndices.erase (std::remove_if (freeIndices.begin (), freeIndices.end (),
+                                       [numSlots](unsigned int i) { return i >= numSlots; }),
+                       freeIndices.end ());
+    return numSlots;
+  }
 }
 
 struct DynamicMesh::Impl
 {
   DynamicMesh*               self;
   Mesh                       mesh;
-  std::vector<VertexData>    vertexData;
+  CowVector<VertexData>      vertexData;
+  DynamicAdjacency           adjacency;
   std::vector<unsigned char> vertexVisited;
   std::vector<unsigned int>  freeVertexIndices;
-  std::vector<FaceData>      faceData;
+  CowVector<FaceData>        faceData;
   std::vector<unsigned char> faceVisited;
   std::vector<unsigned int>  freeFaceIndices;
-  DynamicOctree              octree;
+  bool                       freeFaceIndicesChanged;
+  CowVector<unsigned int>    twins;
+  std::vector<unsigned int>  waitingHalfEdges;
+  bool                       usingBVH;
+
+  /* Realignments are deferred until the next spatial query, which may be `const`. Concurrent
+   * queries take `pendingFacesMutex`: the first one applies the realignments, the others wait.
+   */
+  mutable DynamicOctree              octree;
+  mutable DynamicBVH                 bvh;
+  mutable std::vector<unsigned int>  pendingFaces;
+  mutable std::vector<unsigned char> facePending;
+  mutable PendingFacesMutex          pendingFacesMutex;
+
+  // faces added, realigned or deleted since `maintainOctree` last checked the octree
+  unsigned int numOctreeChanges;
+  float        octreeCheckInterval;
+
+  /* Modified vertices and faces are recorded into `recordedDelta` while `recording`. Their indices
+   * are kept in sparse sets, so that starting and stopping a recording does not depend on the size
+   * of the mesh.
+   */
+  bool             recording;
+  DynamicMeshDelta recordedDelta;
+  DynamicFaces     recordedVertices;
+  DynamicFaces     recordedFaces;
 
   Impl (DynamicMesh* s, const Mesh& m)
     : self (s)
+    , freeFaceIndicesChanged (true)
+    , usingBVH (false)
+    , numOctreeChanges (0)
+    , octreeCheckInterval (octreeCheckRatio)
+    , recording (false)
   {
     this->fromMesh (m);
   }
 
+  Impl (DynamicMesh* s, const Mesh& m, const DynamicOctree& o)
+    : self (s)
+    , usingBVH (false)
+    , numOctreeChanges (0)
+    , octreeCheckInterval (octreeCheckRatio)
+    , recording (false)
+  {
+    this->fromMesh (m, &o);
+  }
+
   unsigned int numVertices () const
   {
     assert (this->mesh.numVertices () >= this->freeVertexIndices.size ());
@@ -113,7 +345,7 @@ struct DynamicMesh::Impl
   unsigned int valence (unsigned int i) const
   {
     assert (this->isFreeVertex (i) == false);
-    return this->vertexData[i].adjacentFaces.size ();
+    return this->adjacency.faces (i).size ();
   }
 
   void vertexIndices (unsigned int i, unsigned int& i1, unsigned int& i2, unsigned int& i3) const
@@ -147,64 +379,178 @@ struct DynamicMesh::Impl
                                        this->mesh.vertex (i3) - this->mesh.vertex (i1)));
   }
 
-  void findAdjacent (unsigned int e1, unsigned int e2, unsigned int& leftFace,
-                     unsigned int& leftVertex, unsigned int& rightFace,
-                     unsigned int& rightVertex) const
-  {
-    assert (this->isFreeVertex (e1) == false);
-    assert (this->isFreeVertex (e2) == false);
+  /* Half-edge `3 * f + k` of face `f` runs from the face's `k`-th vertex to its `(k + 1) % 3`-th
+   * vertex. `twins` links each half-edge to the opposite half-edge of the adjacent face.
+   */
+  static unsigned int nextHalfEdge (unsigned int h) { return (3 * (h / 3)) + (((h % 3) + 1) % 3); }
 
-    leftFace = Util::invalidIndex ();
-    leftVertex = Util::invalidIndex ();
-    rightFace = Util::invalidIndex ();
-    rightVertex = Util::invalidIndex ();
+  static unsigned int prevHalfEdge (unsigned int h) { return (3 * (h / 3)) + (((h % 3) + 2) % 3); }
 
-    for (unsigned int a : this->vertexData[e1].adjacentFaces)
-    {
-      unsigned int i1, i2, i3;
-      this->vertexIndices (a, i1, i2, i3);
+  unsigned int halfEdgeSource (unsigned int h) const { return this->mesh.index (h); }
+
+  unsigned int halfEdgeTarget (unsigned int h) const
+  {
+    return this->mesh.index (Impl::nextHalfEdge (h));
+  }
 
-      if (e1 == i1 && e2 == i2)
+  unsigned int findHalfEdge (unsigned int e1, unsigned int e2) const
+  {
+    for (unsigned int a : this->adjacency.faces (e1))
+    {
+      for (unsigned int h = 3 * a; h < (3 * a) + 3; h++)
       {
-        leftFace = a;
-        leftVertex = i3;
+        if (this->halfEdgeSource (h) == e1 && this->halfEdgeTarget (h) == e2)
+        {
+          return h;
+        }
       }
-      else if (e1 == i2 && e2 == i1)
+    }
+    return Util::invalidIndex ();
+  }
+
+  // constant time: `addFace` and `deleteFace` keep every half-edge with an opposite linked
+  unsigned int twin (unsigned int h) const
+  {
+    assert (h < this->twins.size ());
+    return this->twins[h];
+  }
+
+  void linkTwin (unsigned int h)
+  {
+    assert (this->twins[h] == Util::invalidIndex ());
+
+    const unsigned int t = this->findHalfEdge (this->halfEdgeTarget (h), this->halfEdgeSource (h));
+
+    if (t != Util::invalidIndex () && this->twins[t] == Util::invalidIndex ())
+    {
+      this->recordFace (h / 3);
+      this->recordFace (t / 3);
+      this->twins.set (h, t);
+      this->twins.set (t, h);
+    }
+    else if (t != Util::invalidIndex ())
+    {
+      this->waitingHalfEdges.push_back (h);
+    }
+  }
+
+  // faces that are added before the faces they replace are deleted share an edge with a third face
+  // until then: their waiting half-edges are linked once the edge is released
+  void linkWaitingHalfEdges ()
+  {
+    std::vector<unsigned int> waiting;
+    waiting.swap (this->waitingHalfEdges);
+
+    for (unsigned int h : waiting)
+    {
+      if (h < this->twins.size () && this->isFreeFace (h / 3) == false &&
+          this->twins[h] == Util::invalidIndex ())
       {
-        rightFace = a;
-        rightVertex = i3;
+        this->linkTwin (h);
       }
-      else if (e1 == i2 && e2 == i3)
+    }
+  }
+
+  void linkTwins (unsigned int f)
+  {
+    for (unsigned int h = 3 * f; h < (3 * f) + 3; h++)
+    {
+      if (this->twins[h] == Util::invalidIndex ())
       {
-        leftFace = a;
-        leftVertex = i1;
+        this->linkTwin (h);
       }
-      else if (e1 == i3 && e2 == i2)
+    }
+  }
+
+  void remapTwins (unsigned int begin, unsigned int end,
+                   const std::vector<unsigned int>& faceIndexMap,
+                   std::vector<unsigned int>&       newTwins) const
+  {
+    for (unsigned int i = begin; i < end; i++)
+    {
+      const unsigned int newF = faceIndexMap[i];
+
+      if (newF != Util::invalidIndex ())
       {
-        rightFace = a;
-        rightVertex = i1;
+        for (unsigned int k = 0; k < 3; k++)
+        {
+          const unsigned int t = this->twins[(3 * i) + k];
+          newTwins[(3 * newF) + k] =
+            t == Util::invalidIndex () ? t : (3 * faceIndexMap[t / 3]) + (t % 3);
+        }
       }
-      else if (e1 == i3 && e2 == i1)
+    }
+  }
+
+  void unlinkTwins (unsigned int f)
+  {
+    for (unsigned int h = 3 * f; h < (3 * f) + 3; h++)
+    {
+      const unsigned int t = this->twins[h];
+
+      if (t != Util::invalidIndex ())
       {
-        leftFace = a;
-        leftVertex = i2;
+        this->recordFace (f);
+        this->recordFace (t / 3);
+        this->twins.set (t, Util::invalidIndex ());
+        this->twins.set (h, Util::invalidIndex ());
       }
-      else if (e1 == i1 && e2 == i3)
+    }
+    if (this->waitingHalfEdges.empty () == false)
+    {
+      this->linkWaitingHalfEdges ();
+    }
+  }
+
+  void findAdjacent (unsigned int h, unsigned int& leftFace, unsigned int& leftVertex,
+                     unsigned int& rightFace, unsigned int& rightVertex) const
+  {
+    assert (h < this->twins.size ());
+    assert (this->isFreeFace (h / 3) == false);
+
+    const unsigned int t = this->twin (h);
+    assert (t != Util::invalidIndex ());
+
+    leftFace = h / 3;
+    leftVertex = this->halfEdgeSource (Impl::prevHalfEdge (h));
+    rightFace = t / 3;
+    rightVertex = this->halfEdgeSource (Impl::prevHalfEdge (t));
+  }
+
+  void findAdjacent (unsigned int e1, unsigned int e2, unsigned int& leftFace,
+                     unsigned int& leftVertex, unsigned int& rightFace,
+                     unsigned int& rightVertex) const
+  {
+    assert (this->isFreeVertex (e1) == false);
+    assert (this->isFreeVertex (e2) == false);
+
+    this->findAdjacent (this->findHalfEdge (e1, e2), leftFace, leftVertex, rightFace, rightVertex);
+  }
+
+  void forEachEdge (const DynamicFaces& faces, const std::function<void(unsigned int)>& f)
+  {
+    this->unvisitFaces ();
+
+    for (unsigned int i : faces)
+    {
+      this->faceVisited[i] = 1;
+
+      for (unsigned int h = 3 * i; h < (3 * i) + 3; h++)
       {
-        rightFace = a;
-        rightVertex = i2;
+        const unsigned int t = this->twin (h);
+
+        if (t == Util::invalidIndex () || this->faceVisited[t / 3] == 0)
+        {
+          f (h);
+        }
       }
     }
-    assert (leftFace != Util::invalidIndex ());
-    assert (leftVertex != Util::invalidIndex ());
-    assert (rightFace != Util::invalidIndex ());
-    assert (rightVertex != Util::invalidIndex ());
   }
 
-  const std::vector<unsigned int>& adjacentFaces (unsigned int i) const
+  DynamicAdjacency::Faces adjacentFaces (unsigned int i) const
   {
     assert (this->isFreeVertex (i) == false);
-    return this->vertexData[i].adjacentFaces;
+    return this->adjacency.faces (i);
   }
 
   void forEachVertex (const std::function<void(unsigned int)>& f)
@@ -270,7 +616,7 @@ struct DynamicMesh::Impl
       this->visitVertices (i, [this, &f](unsigned int j) {
         f (j);
 
-        for (unsigned int a : this->vertexData[j].adjacentFaces)
+        for (unsigned int a : this->adjacency.faces (j))
         {
           if (this->faceVisited[a] == 0)
           {
@@ -286,7 +632,7 @@ struct DynamicMesh::Impl
   {
     assert (this->isFreeVertex (i) == false);
 
-    for (unsigned int a : this->vertexData[i].adjacentFaces)
+    for (unsigned int a : this->adjacency.faces (i))
     {
       unsigned int a1, a2, a3;
       this->vertexIndices (a, a1, a2, a3);
@@ -334,6 +680,34 @@ struct DynamicMesh::Impl
     }
   }
 
+  void forEachVertexParallel (const std::function<void(unsigned int)>& f) const
+  {
+    Parallel::forRanges (this->vertexData.size (), minParallelRangeSize,
+                         [this, &f](unsigned int begin, unsigned int end) {
+                           for (unsigned int i = begin; i < end; i++)
+                           {
+                             if (this->isFreeVertex (i) == false)
+                             {
+                               f (i);
+                             }
+                           }
+                         });
+  }
+
+  void forEachFaceParallel (const std::function<void(unsigned int)>& f) const
+  {
+    Parallel::forRanges (this->faceData.size (), minParallelRangeSize,
+                         [this, &f](unsigned int begin, unsigned int end) {
+                           for (unsigned int i = begin; i < end; i++)
+                           {
+                             if (this->isFreeFace (i) == false)
+                             {
+                               f (i);
+                             }
+                           }
+                         });
+  }
+
   void forEachFaceExt (const DynamicFaces& faces, const std::function<void(unsigned int)>& f)
   {
     this->unvisitVertices ();
@@ -347,7 +721,7 @@ struct DynamicMesh::Impl
         this->faceVisited[i] = 1;
       }
       this->visitVertices (i, [this, &f](unsigned int j) {
-        for (unsigned int a : this->vertexData[j].adjacentFaces)
+        for (unsigned int a : this->adjacency.faces (j))
         {
           if (this->faceVisited[a] == 0)
           {
@@ -398,13 +772,13 @@ struct DynamicMesh::Impl
   glm::vec3 averagePosition (unsigned int i) const
   {
     assert (this->isFreeVertex (i) == false);
-    assert (this->vertexData[i].adjacentFaces.size () > 0);
+    assert (this->adjacency.faces (i).size () > 0);
 
     glm::vec3 position = glm::vec3 (0.0f);
 
     this->forEachVertexAdjacentToVertex (
       i, [this, &position](unsigned int v) { position += this->mesh.vertex (v); });
-    return position / float(this->vertexData[i].adjacentFaces.size ());
+    return position / float(this->adjacency.faces (i).size ());
   }
 
   glm::vec3 averageNormal (const DynamicFaces& faces) const
@@ -427,11 +801,11 @@ struct DynamicMesh::Impl
   glm::vec3 averageNormal (unsigned int i) const
   {
     assert (this->isFreeVertex (i) == false);
-    assert (this->vertexData[i].adjacentFaces.size () > 0);
+    assert (this->adjacency.faces (i).size () > 0);
 
     glm::vec3 normal = glm::vec3 (0.0f);
 
-    for (unsigned int f : this->vertexData[i].adjacentFaces)
+    for (unsigned int f : this->adjacency.faces (i))
     {
       unsigned int i1, i2, i3;
       this->vertexIndices (f, i1, i2, i3);
@@ -468,14 +842,36 @@ struct DynamicMesh::Impl
     return (glm::distance2 (v1, v2) + glm::distance2 (v1, v3) + glm::distance2 (v2, v3)) / 3.0f;
   }
 
-  void setupOctreeRoot () { this->setupOctreeRoot (this->mesh); }
+  // free vertices keep their last position and are ignored
+  void minMax (glm::vec3& minVertex, glm::vec3& maxVertex) const
+  {
+    minVertex = glm::vec3 (Util::maxFloat ());
+    maxVertex = glm::vec3 (Util::minFloat ());
+
+    for (unsigned int i = 0; i < this->vertexData.size (); i++)
+    {
+      if (this->isFreeVertex (i) == false)
+      {
+        minVertex = glm::min (minVertex, this->mesh.vertex (i));
+        maxVertex = glm::max (maxVertex, this->mesh.vertex (i));
+      }
+    }
+    if (this->numVertices () == 0)
+    {
+      this->mesh.minMax (minVertex, maxVertex);
+    }
+  }
 
-  void setupOctreeRoot (const Mesh& mesh)
+  void setupSpatialIndexRoot ()
   {
+    if (this->usingBVH)
+    {
+      return;
+    }
     assert (this->octree.hasRoot () == false);
 
     glm::vec3 minVertex, maxVertex;
-    mesh.minMax (minVertex, maxVertex);
+    this->minMax (minVertex, maxVertex);
 
     const glm::vec3 center = (maxVertex + minVertex) * glm::vec3 (0.5f);
     const glm::vec3 delta = maxVertex - minVertex;
@@ -491,18 +887,21 @@ struct DynamicMesh::Impl
 
     if (this->freeVertexIndices.empty ())
     {
-      this->vertexData.emplace_back ();
-      this->vertexData.back ().isFree = false;
+      this->recordVertex (this->vertexData.size ());
+      this->vertexData.push_back (VertexData ());
+      this->vertexData.mutableBack ().isFree = false;
+      this->adjacency.addVertex ();
       this->vertexVisited.push_back (0);
       return this->mesh.addVertex (vertex, normal);
     }
     else
     {
       const unsigned int index = this->freeVertexIndices.back ();
+      this->recordVertex (index);
       this->mesh.vertex (index, vertex);
       this->mesh.normal (index, normal);
-      this->vertexData[index].reset ();
-      this->vertexData[index].isFree = false;
+      this->vertexData.mutableAt (index).reset ();
+      this->vertexData.mutableAt (index).isFree = false;
       this->vertexVisited[index] = 0;
       this->freeVertexIndices.pop_back ();
       return index;
@@ -510,6 +909,14 @@ struct DynamicMesh::Impl
   }
 
   unsigned int addFace (unsigned int i1, unsigned int i2, unsigned int i3)
+  {
+    const unsigned int index = this->addFaceWithoutSpatialIndex (i1, i2, i3);
+    this->linkTwins (index);
+    this->addFaceToOctree (index);
+    return index;
+  }
+
+  unsigned int addFaceWithoutSpatialIndex (unsigned int i1, unsigned int i2, unsigned int i3)
   {
     assert (i1 < this->mesh.numVertices ());
     assert (i2 < this->mesh.numVertices ());
@@ -521,9 +928,11 @@ struct DynamicMesh::Impl
 
     if (this->freeFaceIndices.empty ())
     {
+      this->recordFace (this->faceData.size ());
       index = this->numFaces ();
-      this->faceData.emplace_back ();
+      this->faceData.push_back (FaceData ());
       this->faceVisited.push_back (0);
+      this->twins.resize (3 * this->faceData.size (), Util::invalidIndex ());
 
       this->mesh.addIndex (i1);
       this->mesh.addIndex (i2);
@@ -532,30 +941,89 @@ struct DynamicMesh::Impl
     else
     {
       index = this->freeFaceIndices.back ();
-      this->faceData[index].reset ();
+      this->recordFace (index);
+      this->faceData.mutableAt (index).reset ();
       this->faceVisited[index] = 0;
       this->freeFaceIndices.pop_back ();
+      this->freeFaceIndicesChanged = true;
 
       this->mesh.index ((3 * index) + 0, i1);
       this->mesh.index ((3 * index) + 1, i2);
       this->mesh.index ((3 * index) + 2, i3);
     }
-    this->faceData[index].isFree = false;
-
-    this->vertexData[i1].addAdjacentFace (index);
-    this->vertexData[i2].addAdjacentFace (index);
-    this->vertexData[i3].addAdjacentFace (index);
+    this->faceData.mutableAt (index).isFree = false;
 
-    this->addFaceToOctree (index);
+    this->recordVertex (i1);
+    this->recordVertex (i2);
+    this->recordVertex (i3);
+    this->adjacency.addFace (i1, index);
+    this->adjacency.addFace (i2, index);
+    this->adjacency.addFace (i3, index);
 
     return index;
   }
 
+  // computes the bounds of `faces` in parallel
+  std::vector<FaceBounds> faceBounds (const std::vector<unsigned int>& faces) const
+  {
+    std::vector<FaceBounds> bounds (faces.size ());
+
+    Parallel::forRanges (faces.size (), minParallelRangeSize,
+                         [this, &faces, &bounds](unsigned int begin, unsigned int end) {
+                           for (unsigned int i = begin; i < end; i++)
+                           {
+                             bounds[i] = FaceBounds (this->face (faces[i]));
+                           }
+                         });
+    return bounds;
+  }
+
+  void addAllFacesToSpatialIndex ()
+  {
+    std::vector<unsigned int> indices;
+    indices.reserve (this->numFaces ());
+    this->forEachFace ([&indices](unsigned int i) { indices.push_back (i); });
+
+    const std::vector<FaceBounds> bounds = this->faceBounds (indices);
+
+    if (this->usingBVH)
+    {
+      for (unsigned int i = 0; i < indices.size (); i++)
+      {
+        this->bvh.addElement (indices[i], bounds[i].minimum, bounds[i].maximum);
+      }
+      this->bvh.rebuild ();
+    }
+    else
+    {
+      std::vector<glm::vec3> positions;
+      std::vector<float>     maxDimExtents;
+
+      positions.reserve (bounds.size ());
+      maxDimExtents.reserve (bounds.size ());
+
+      for (const FaceBounds& b : bounds)
+      {
+        positions.push_back (b.center);
+        maxDimExtents.push_back (b.maxDimExtent);
+      }
+      this->octree.addElements (indices, positions, maxDimExtents);
+    }
+  }
+
   void addFaceToOctree (unsigned int i)
   {
     const PrimTriangle tri = this->face (i);
+    this->numOctreeChanges++;
 
-    this->octree.addElement (i, tri.center (), tri.maxDimExtent ());
+    if (this->usingBVH)
+    {
+      this->bvh.addElement (i, tri.minimum (), tri.maximum ());
+    }
+    else
+    {
+      this->octree.addElement (i, tri.center (), tri.maxDimExtent ());
+    }
   }
 
   void deleteVertex (unsigned int i)
@@ -563,12 +1031,16 @@ struct DynamicMesh::Impl
     assert (i < this->vertexData.size ());
     assert (i < this->vertexVisited.size ());
 
-    std::vector<unsigned int> adjacentFaces = this->vertexData[i].adjacentFaces;
+    this->recordVertex (i);
+
+    const DynamicAdjacency::Faces   faces = this->adjacency.faces (i);
+    const std::vector<unsigned int> adjacentFaces (faces.begin (), faces.end ());
     for (unsigned int f : adjacentFaces)
     {
       this->deleteFace (f);
     }
-    this->vertexData[i].reset ();
+    this->vertexData.mutableAt (i).reset ();
+    this->adjacency.reset (i);
     this->vertexVisited[i] = 0;
     this->freeVertexIndices.push_back (i);
   }
@@ -578,14 +1050,40 @@ struct DynamicMesh::Impl
     assert (i < this->faceData.size ());
     assert (i < this->faceVisited.size ());
 
-    this->vertexData[this->mesh.index ((3 * i) + 0)].deleteAdjacentFace (i);
-    this->vertexData[this->mesh.index ((3 * i) + 1)].deleteAdjacentFace (i);
-    this->vertexData[this->mesh.index ((3 * i) + 2)].deleteAdjacentFace (i);
+    this->recordFace (i);
+    this->recordVertex (this->mesh.index ((3 * i) + 0));
+    this->recordVertex (this->mesh.index ((3 * i) + 1));
+    this->recordVertex (this->mesh.index ((3 * i) + 2));
+    this->adjacency.deleteFace (this->mesh.index ((3 * i) + 0), i);
+    this->adjacency.deleteFace (this->mesh.index ((3 * i) + 1), i);
+    this->adjacency.deleteFace (this->mesh.index ((3 * i) + 2), i);
+    this->unlinkTwins (i);
 
-    this->faceData[i].reset ();
+    this->faceData.mutableAt (i).reset ();
     this->faceVisited[i] = 0;
     this->freeFaceIndices.push_back (i);
-    this->octree.deleteElement (i);
+    this->freeFaceIndicesChanged = true;
+    this->deleteFaceFromOctree (i);
+  }
+
+  void deleteFaceFromOctree (unsigned int i)
+  {
+    this->numOctreeChanges++;
+
+    if (this->usingBVH)
+    {
+      this->bvh.deleteElement (i);
+    }
+    else
+    {
+      this->octree.deleteElement (i);
+    }
+  }
+
+  void vertex (unsigned int i, const glm::vec3& v)
+  {
+    this->recordVertex (i);
+    this->mesh.vertex (i, v);
   }
 
   void vertexNormal (unsigned int i, const glm::vec3& n)
@@ -593,6 +1091,7 @@ struct DynamicMesh::Impl
     assert (this->isFreeVertex (i) == false);
     assert (this->mesh.numVertices () == this->vertexData.size ());
 
+    this->recordVertex (i);
     this->mesh.normal (i, n);
   }
 
@@ -600,6 +1099,7 @@ struct DynamicMesh::Impl
   {
     const glm::vec3 avg = this->averageNormal (i);
 
+    this->recordVertex (i);
     if (Util::isNaN (avg))
     {
       this->mesh.normal (i, glm::vec3 (0.0f));
@@ -610,52 +1110,290 @@ struct DynamicMesh::Impl
     }
   }
 
-  void setAllNormals ()
+  // calls `f (batch, i)` for the `i`-th face of each batch
+  template <typename F> void forEachFaceNormal (const std::vector<unsigned int>& faces,
+                                                const F&                         f) const
   {
-    this->forEachVertex ([this](unsigned int i) { this->setVertexNormal (i); });
+    FaceNormalBatch batch;
+
+    for (unsigned int begin = 0; begin < faces.size (); begin += FaceNormalBatch::size)
+    {
+      const unsigned int batchSize = FaceNormalBatch::size;
+      const unsigned int n = glm::min (batchSize, (unsigned int) (faces.size ()) - begin);
+
+      batch.gather (this->mesh, faces.data () + begin, n);
+      batch.computeNormals ();
+
+      for (unsigned int i = 0; i < batch.numFaces; i++)
+      {
+        f (batch, i);
+      }
+    }
   }
 
-  void reset ()
+  // adds the normals of `faces` to the normals of their visited vertices
+  void accumulateNormals (const std::vector<unsigned int>& faces)
   {
-    this->mesh.reset ();
-    this->vertexData.clear ();
-    this->vertexVisited.clear ();
-    this->freeVertexIndices.clear ();
-    this->faceData.clear ();
-    this->faceVisited.clear ();
-    this->freeFaceIndices.clear ();
-    this->octree.reset ();
+    this->forEachFaceNormal (faces, [this](const FaceNormalBatch& batch, unsigned int i) {
+      const glm::vec3 normal = batch.normal (i);
+
+      for (unsigned int j = 3 * i; j < (3 * i) + 3; j++)
+      {
+        const unsigned int v = batch.indices[j];
+
+        if (this->vertexVisited[v])
+        {
+          this->recordVertex (v);
+          this->mesh.normal (v, this->mesh.normal (v) + normal);
+        }
+      }
+    });
   }
 
-  void fromMesh (const Mesh& mesh)
+  void normalizeNormal (unsigned int i)
   {
-    this->reset ();
-    this->setupOctreeRoot (mesh);
-    this->mesh.reserveVertices (mesh.numVertices ());
+    const glm::vec3 normal = glm::normalize (this->mesh.normal (i));
 
-    for (unsigned int i = 0; i < mesh.numVertices (); i++)
+    this->recordVertex (i);
+    if (Util::isNaN (normal))
     {
-      this->addVertex (mesh.vertex (i), mesh.normal (i));
+      this->mesh.normal (i, glm::vec3 (0.0f));
     }
-
-    assert (mesh.numIndices () % 3 == 0);
-    this->mesh.reserveIndices (mesh.numIndices ());
-
-    for (unsigned int i = 0; i < mesh.numIndices (); i += 3)
+    else
     {
-      this->addFace (mesh.index (i), mesh.index (i + 1), mesh.index (i + 2));
+      this->mesh.normal (i, normal);
     }
-    this->setAllNormals ();
-    this->mesh.bufferData ();
   }
 
-  void realignFace (unsigned int i)
+  void setNormals (const DynamicFaces& faces)
   {
-    assert (this->isFreeFace (i) == false);
+    std::vector<unsigned int> vertices;
+    std::vector<unsigned int> adjacentFaces;
 
-    const PrimTriangle tri = this->face (i);
+    // visits the vertices of `faces`
+    this->forEachVertex (faces, [this, &vertices](unsigned int i) {
+      this->recordVertex (i);
+      this->mesh.normal (i, glm::vec3 (0.0f));
+      vertices.push_back (i);
+    });
+
+    this->unvisitFaces ();
+    for (unsigned int i : vertices)
+    {
+      for (unsigned int a : this->adjacency.faces (i))
+      {
+        if (this->faceVisited[a] == 0)
+        {
+          this->faceVisited[a] = 1;
+          adjacentFaces.push_back (a);
+        }
+      }
+    }
+    this->accumulateNormals (adjacentFaces);
+
+    for (unsigned int i : vertices)
+    {
+      this->normalizeNormal (i);
+    }
+  }
+
+  void computeFaceNormals (unsigned int begin, unsigned int end,
+                           std::vector<glm::vec3>& faceNormals) const
+  {
+    std::vector<unsigned int> faces;
+    for (unsigned int i = begin; i < end; i++)
+    {
+      if (this->isFreeFace (i) == false)
+      {
+        faces.push_back (i);
+      }
+    }
+    this->forEachFaceNormal (faces, [&faceNormals](const FaceNormalBatch& batch, unsigned int i) {
+      faceNormals[batch.faces[i]] = batch.normal (i);
+    });
+  }
+
+  void sumFaceNormals (unsigned int begin, unsigned int end,
+                       const std::vector<glm::vec3>& faceNormals,
+                       std::vector<glm::vec3>&       vertexNormals) const
+  {
+    for (unsigned int i = begin; i < end; i++)
+    {
+      if (this->isFreeVertex (i) == false)
+      {
+        glm::vec3 normal (0.0f);
+        for (unsigned int a : this->adjacency.faces (i))
+        {
+          normal += faceNormals[a];
+        }
+        normal = glm::normalize (normal);
+        vertexNormals[i] = Util::isNaN (normal) ? glm::vec3 (0.0f) : normal;
+      }
+    }
+  }
+
+  /* Face normals are computed in parallel and then summed up per vertex in the order of the
+   * adjacent faces, so that the result does not depend on the number of threads.
+   */
+  void setAllNormals ()
+  {
+    std::vector<glm::vec3> faceNormals (this->faceData.size ());
+    std::vector<glm::vec3> vertexNormals (this->vertexData.size ());
+
+    Parallel::forRanges (this->faceData.size (), minParallelRangeSize,
+                         [this, &faceNormals](unsigned int begin, unsigned int end) {
+                           this->computeFaceNormals (begin, end, faceNormals);
+                         });
+    Parallel::forRanges (
+      this->vertexData.size (), minParallelRangeSize,
+      [this, &faceNormals, &vertexNormals](unsigned int begin, unsigned int end) {
+        this->sumFaceNormals (begin, end, faceNormals, vertexNormals);
+      });
+
+    this->forEachVertex ([this, &vertexNormals](unsigned int i) {
+      this->recordVertex (i);
+      this->mesh.normal (i, vertexNormals[i]);
+    });
+  }
+
+  void reset ()
+  {
+    assert (this->recording == false);
+
+    this->mesh.reset ();
+    this->vertexData.clear ();
+    this->adjacency.reset ();
+    this->vertexVisited.clear ();
+    this->freeVertexIndices.clear ();
+    this->faceData.clear ();
+    this->faceVisited.clear ();
+    this->freeFaceIndices.clear ();
+    this->freeFaceIndicesChanged = true;
+    this->twins.clear ();
+    this->waitingHalfEdges.clear ();
+    this->octree.reset ();
+    this->bvh.reset ();
+    this->dropPendingFaces ();
+  }
+
+  void fromMesh (const Mesh& mesh, const DynamicOctree* octree = nullptr)
+  {
+    this->reset ();
+    this->mesh.reserveVertices (mesh.numVertices ());
+
+    for (unsigned int i = 0; i < mesh.numVertices (); i++)
+    {
+      this->addVertex (mesh.vertex (i), mesh.normal (i));
+    }
+
+    assert (mesh.numIndices () % 3 == 0);
+    this->mesh.reserveIndices (mesh.numIndices ());
+    this->twins.reserve (mesh.numIndices ());
+
+    for (unsigned int i = 0; i < mesh.numIndices (); i += 3)
+    {
+      this->addFaceWithoutSpatialIndex (mesh.index (i), mesh.index (i + 1), mesh.index (i + 2));
+    }
+
+    // linking after all faces have been added finds each pair of twins once
+    for (unsigned int i = 0; i < this->faceData.size (); i++)
+    {
+      this->linkTwins (i);
+    }
+
+    if (octree == nullptr || this->adoptOctree (*octree) == false)
+    {
+      this->setupSpatialIndexRoot ();
+      this->addAllFacesToSpatialIndex ();
+    }
+    this->setAllNormals ();
+    this->mesh.bufferData ();
+  }
+
+  // adopts `octree` if it indexes exactly the faces of this mesh: misplaced faces are realigned
+  bool adoptOctree (const DynamicOctree& octree)
+  {
+    if (this->usingBVH || octree.hasRoot () == false ||
+        octree.numElements () != this->numFaces ())
+    {
+      return false;
+    }
+    for (unsigned int i = 0; i < this->faceData.size (); i++)
+    {
+      if (this->isFreeFace (i) == false && octree.hasElement (i) == false)
+      {
+        return false;
+      }
+    }
+    std::vector<FaceBounds> bounds (this->faceData.size ());
+    this->forEachFaceParallel (
+      [this, &bounds](unsigned int i) { bounds[i] = FaceBounds (this->face (i)); });
+
+    this->octree = octree;
+    this->forEachFace ([this, &bounds](unsigned int i) {
+      this->octree.realignElement (i, bounds[i].center, bounds[i].maxDimExtent);
+    });
+    return true;
+  }
+
+  void realignFace (unsigned int i)
+  {
+    assert (this->isFreeFace (i) == false);
+
+    if (i >= this->facePending.size ())
+    {
+      this->facePending.resize (this->faceData.size (), 0);
+    }
+    if (this->facePending[i] == 0)
+    {
+      this->facePending[i] = 1;
+      this->pendingFaces.push_back (i);
+      this->numOctreeChanges++;
+    }
+  }
+
+  void realignPendingFaces () const
+  {
+    std::lock_guard<std::mutex> lock (this->pendingFacesMutex.mutex);
+
+    if (this->pendingFaces.empty ())
+    {
+      return;
+    }
+    std::vector<unsigned int> faces;
+    faces.reserve (this->pendingFaces.size ());
+
+    for (unsigned int i : this->pendingFaces)
+    {
+      this->facePending[i] = 0;
+
+      // faces may have been deleted (or deleted and re-added) since they were queued
+      if (this->isFreeFace (i) == false)
+      {
+        faces.push_back (i);
+      }
+    }
+    this->pendingFaces.clear ();
+
+    const std::vector<FaceBounds> bounds = this->faceBounds (faces);
+
+    for (unsigned int i = 0; i < faces.size (); i++)
+    {
+      if (this->usingBVH)
+      {
+        this->bvh.realignElement (faces[i], bounds[i].minimum, bounds[i].maximum);
+      }
+      else
+      {
+        this->octree.realignElement (faces[i], bounds[i].center, bounds[i].maxDimExtent);
+      }
+    }
+  }
 
-    this->octree.realignElement (i, tri.center (), tri.maxDimExtent ());
+  void dropPendingFaces ()
+  {
+    this->pendingFaces.clear ();
+    this->facePending.clear ();
   }
 
   void realignFaces (const DynamicFaces& faces)
@@ -671,14 +1409,400 @@ struct DynamicMesh::Impl
     this->forEachFace ([this](unsigned int i) { this->realignFace (i); });
   }
 
+  // vertices that do not exist yet are recorded as free vertices
+  DynamicMeshDelta::Vertex vertexImage (unsigned int              i,
+                                        std::vector<unsigned int>& adjacentFaces) const
+  {
+    DynamicMeshDelta::Vertex image;
+    image.index = i;
+    image.firstAdjacentFace = adjacentFaces.size ();
+
+    if (i < this->vertexData.size ())
+    {
+      const DynamicAdjacency::Faces faces = this->adjacency.faces (i);
+
+      image.isFree = this->vertexData[i].isFree;
+      image.position = this->mesh.vertex (i);
+      image.normal = this->mesh.normal (i);
+      image.numAdjacentFaces = faces.size ();
+      adjacentFaces.insert (adjacentFaces.end (), faces.begin (), faces.end ());
+    }
+    else
+    {
+      image.isFree = true;
+      image.position = glm::vec3 (0.0f);
+      image.normal = glm::vec3 (0.0f);
+      image.numAdjacentFaces = 0;
+    }
+    return image;
+  }
+
+  // faces that do not exist yet are recorded as free faces
+  DynamicMeshDelta::Face faceImage (unsigned int i) const
+  {
+    DynamicMeshDelta::Face image;
+    image.index = i;
+    image.isFree = i < this->faceData.size () ? this->faceData[i].isFree : true;
+
+    for (unsigned int k = 0; k < 3; k++)
+    {
+      if (i < this->faceData.size ())
+      {
+        image.vertices[k] = this->mesh.index ((3 * i) + k);
+        image.twins[k] = this->twins[(3 * i) + k];
+      }
+      else
+      {
+        image.vertices[k] = 0;
+        image.twins[k] = Util::invalidIndex ();
+      }
+    }
+    return image;
+  }
+
+  // records the state of a vertex before its first modification
+  void recordVertex (unsigned int i)
+  {
+    if (this->recording == false)
+    {
+      return;
+    }
+    if (this->recordedVertices.contains (i) == false)
+    {
+      this->recordedVertices.insert (i);
+      this->recordedVertices.commit ();
+      DynamicMeshDelta& delta = this->recordedDelta;
+      delta.vertices.push_back (this->vertexImage (i, delta.adjacentFaces));
+    }
+  }
+
+  // records the state of a face before its first modification
+  void recordFace (unsigned int i)
+  {
+    if (this->recording == false)
+    {
+      return;
+    }
+    if (this->recordedFaces.contains (i) == false)
+    {
+      this->recordedFaces.insert (i);
+      this->recordedFaces.commit ();
+      this->recordedDelta.faces.push_back (this->faceImage (i));
+    }
+  }
+
+  void startRecording ()
+  {
+    assert (this->recording == false);
+
+    this->recording = true;
+    this->recordedDelta = DynamicMeshDelta ();
+    this->recordedDelta.numVertexSlots = this->vertexData.size ();
+    this->recordedDelta.numFaceSlots = this->faceData.size ();
+  }
+
+  DynamicMeshDelta stopRecording ()
+  {
+    assert (this->recording);
+
+    // copies of the mesh, e.g., snapshots, should not hold these
+    this->recordedVertices = DynamicFaces ();
+    this->recordedFaces = DynamicFaces ();
+    this->recording = false;
+
+    DynamicMeshDelta recorded (std::move (this->recordedDelta));
+    this->recordedDelta = DynamicMeshDelta ();
+    return recorded;
+  }
+
+  // adds free vertices and faces or removes trailing (free) vertices and faces
+  void resizeElements (unsigned int numVertices, unsigned int numFaces)
+  {
+    while (this->vertexData.size () < numVertices)
+    {
+      this->vertexData.push_back (VertexData ());
+      this->adjacency.addVertex ();
+      this->vertexVisited.push_back (0);
+      this->mesh.addVertex (glm::vec3 (0.0f), glm::vec3 (0.0f));
+    }
+    while (this->faceData.size () < numFaces)
+    {
+      this->faceData.push_back (FaceData ());
+      this->faceVisited.push_back (0);
+      this->mesh.addIndex (0);
+      this->mesh.addIndex (0);
+      this->mesh.addIndex (0);
+    }
+    if (this->vertexData.size () > numVertices)
+    {
+      this->vertexData.resize (numVertices);
+      this->vertexVisited.resize (numVertices);
+      this->adjacency.shrink (numVertices);
+      this->mesh.shrinkVertices (numVertices);
+    }
+    if (this->faceData.size () > numFaces)
+    {
+      this->faceData.resize (numFaces);
+      this->faceVisited.resize (numFaces);
+      this->mesh.shrinkIndices (3 * numFaces);
+    }
+    this->twins.resize (3 * numFaces, Util::invalidIndex ());
+  }
+
+  /* The current state of the recorded vertices and faces is stored in an inverse delta before
+   * their recorded state is restored. Faces of restored vertices are realigned afterwards.
+   */
+  void applyDelta (DynamicMeshDelta& delta)
+  {
+    assert (this->recording == false);
+
+    this->realignPendingFaces ();
+
+    DynamicMeshDelta inverse;
+    inverse.numVertexSlots = this->vertexData.size ();
+    inverse.numFaceSlots = this->faceData.size ();
+    inverse.vertices.reserve (delta.vertices.size ());
+    inverse.faces.reserve (delta.faces.size ());
+
+    for (const DynamicMeshDelta::Vertex& v : delta.vertices)
+    {
+      inverse.vertices.push_back (this->vertexImage (v.index, inverse.adjacentFaces));
+    }
+    for (const DynamicMeshDelta::Face& f : delta.faces)
+    {
+      inverse.faces.push_back (this->faceImage (f.index));
+
+      if (f.index < this->faceData.size () && this->faceData[f.index].isFree == false)
+      {
+        this->deleteFaceFromOctree (f.index);
+      }
+    }
+
+    this->resizeElements (std::max (delta.numVertexSlots, inverse.numVertexSlots),
+                          std::max (delta.numFaceSlots, inverse.numFaceSlots));
+
+    for (const DynamicMeshDelta::Vertex& v : delta.vertices)
+    {
+      this->vertexData.mutableAt (v.index).isFree = v.isFree;
+      this->vertexVisited[v.index] = 0;
+      this->mesh.vertex (v.index, v.position);
+      this->mesh.normal (v.index, v.normal);
+      this->adjacency.reset (v.index);
+
+      for (unsigned int a = 0; a < v.numAdjacentFaces; a++)
+      {
+        this->adjacency.addFace (v.index, delta.adjacentFaces[v.firstAdjacentFace + a]);
+      }
+    }
+    for (const DynamicMeshDelta::Face& f : delta.faces)
+    {
+      this->faceData.mutableAt (f.index).isFree = f.isFree;
+      this->faceVisited[f.index] = 0;
+
+      for (unsigned int k = 0; k < 3; k++)
+      {
+        this->mesh.index ((3 * f.index) + k, f.vertices[k]);
+        this->twins.set ((3 * f.index) + k, f.twins[k]);
+      }
+    }
+
+    this->resizeElements (delta.numVertexSlots, delta.numFaceSlots);
+    updateFreeIndices (this->freeVertexIndices, inverse.vertices, inverse.numVertexSlots,
+                       delta.vertices, delta.numVertexSlots);
+    updateFreeIndices (this->freeFaceIndices, inverse.faces, inverse.numFaceSlots, delta.faces,
+                       delta.numFaceSlots);
+    this->freeFaceIndicesChanged = true;
+
+    for (const DynamicMeshDelta::Face& f : delta.faces)
+    {
+      if (f.index < delta.numFaceSlots && f.isFree == false)
+      {
+        this->addFaceToOctree (f.index);
+      }
+    }
+    for (const DynamicMeshDelta::Vertex& v : delta.vertices)
+    {
+      if (v.index < delta.numVertexSlots && v.isFree == false)
+      {
+        for (unsigned int a : this->adjacency.faces (v.index))
+        {
+          this->realignFace (a);
+        }
+      }
+    }
+    delta = std::move (inverse);
+  }
+
   void sanitize ()
   {
-    this->octree.deleteEmptyChildren ();
-    this->octree.shrinkRoot ();
+    this->realignPendingFaces ();
+
+    if (this->usingBVH)
+    {
+      this->bvh.refit ();
+    }
+    else
+    {
+      this->octree.deleteEmptyChildren ();
+      this->octree.shrinkRoot ();
+      this->maintainOctree ();
+    }
+  }
+
+  bool isSparse () const
+  {
+    const float numVertices = float (this->vertexData.size ());
+    const float numFaces = float (this->faceData.size ());
+
+    return float (this->freeVertexIndices.size ()) > maxFreeElementRatio * numVertices ||
+           float (this->freeFaceIndices.size ()) > maxFreeElementRatio * numFaces;
+  }
+
+  void maintainOctree ()
+  {
+    if (this->isEmpty () ||
+        float (this->numOctreeChanges) < this->octreeCheckInterval * float (this->numFaces ()))
+    {
+      return;
+    }
+    this->numOctreeChanges = 0;
+
+    const DynamicOctree::Statistics stats = this->octree.statistics ();
+
+    glm::vec3 minVertex, maxVertex;
+    this->minMax (minVertex, maxVertex);
+
+    const glm::vec3 delta = maxVertex - minVertex;
+    const float     width = glm::max (glm::max (delta.x, delta.y), delta.z);
+
+    if (stats.rootWidth > maxRelativeOctreeRootWidth * width ||
+        stats.maxElementsPerNode > maxOctreeElementsPerNode)
+    {
+      const DynamicOctree previous (this->octree);
+      const float         costBefore = this->octreeQueryCost ();
+
+      this->resetSpatialIndex ();
+
+      const float costAfter = this->octreeQueryCost ();
+
+      if (costAfter <= (1.0f - minOctreeCostGain) * costBefore)
+      {
+        this->octreeCheckInterval = octreeCheckRatio;
+
+        DILAY_INFO ("rebuilt octree (root width %f, mesh width %f, max elements per node %u): "
+                    "query cost %.1f -> %.1f",
+                    stats.rootWidth, width, stats.maxElementsPerNode, costBefore, costAfter);
+      }
+      else
+      {
+        this->octree = previous;
+        this->octreeCheckInterval *= 2.0f;
+      }
+    }
+  }
+
+  // average number of faces that are tested by a distance query at a face's center
+  float octreeQueryCost () const
+  {
+    const unsigned int stride =
+      glm::max (1u, (unsigned int) (this->faceData.size ()) / numOctreeQueryCostSamples);
+    unsigned int numSamples = 0;
+    unsigned int numTests = 0;
+
+    for (unsigned int i = 0; i < this->faceData.size (); i += stride)
+    {
+      if (this->isFreeFace (i) == false)
+      {
+        const glm::vec3 center = this->face (i).center ();
+
+        this->octree.distanceT (center, [this, &center, &numTests](unsigned int f) {
+          numTests++;
+          return Distance::distance (this->face (f), center);
+        });
+        numSamples++;
+      }
+    }
+    return numSamples == 0 ? 0.0f : float(numTests) / float(numSamples);
+  }
+
+  // moves face `from` into the free slot `to`, which is not taken from the free faces
+  void moveFace (unsigned int from, unsigned int to)
+  {
+    const unsigned int i1 = this->mesh.index ((3 * from) + 0);
+    const unsigned int i2 = this->mesh.index ((3 * from) + 1);
+    const unsigned int i3 = this->mesh.index ((3 * from) + 2);
+
+    this->deleteFace (from);
+    this->freeFaceIndices.push_back (to);
+
+    const unsigned int index = this->addFace (i1, i2, i3);
+    assert (index == to);
+    unused (index);
+  }
+
+  // moves vertex `from` into the free slot `to`, which is not taken from the free vertices
+  void moveVertex (unsigned int from, unsigned int to)
+  {
+    const DynamicAdjacency::Faces   faces = this->adjacency.faces (from);
+    const std::vector<unsigned int> adjacentFaces (faces.begin (), faces.end ());
+
+    const glm::vec3 position = this->mesh.vertex (from);
+    const glm::vec3 normal = this->mesh.normal (from);
+
+    this->recordVertex (from);
+    this->recordVertex (to);
+    this->mesh.vertex (to, position);
+    this->mesh.normal (to, normal);
+    this->vertexData.mutableAt (to).isFree = false;
+    this->vertexVisited[to] = 0;
+
+    for (unsigned int f : adjacentFaces)
+    {
+      this->recordFace (f);
+      for (unsigned int k = 0; k < 3; k++)
+      {
+        if (this->mesh.index ((3 * f) + k) == from)
+        {
+          this->mesh.index ((3 * f) + k, to);
+        }
+      }
+      this->adjacency.addFace (to, f);
+    }
+    this->vertexData.mutableAt (from).reset ();
+    this->adjacency.reset (from);
+    this->vertexVisited[from] = 0;
+    this->freeVertexIndices.push_back (from);
+  }
+
+  /* Unlike `prune`, compacting only moves single vertices and faces, i.e., it can be recorded and
+   * its costs are bounded by `maxMoves`.
+   */
+  void compact (unsigned int maxMoves)
+  {
+    this->realignPendingFaces ();
+
+    const unsigned int numFaces = compactSlots (
+      this->freeFaceIndices, this->faceData.size (), maxMoves,
+      [this](unsigned int i) { return this->faceData[i].isFree; },
+      [this](unsigned int i) { this->recordFace (i); },
+      [this](unsigned int from, unsigned int to) { this->moveFace (from, to); });
+
+    const unsigned int numVertices = compactSlots (
+      this->freeVertexIndices, this->vertexData.size (), maxMoves,
+      [this](unsigned int i) { return this->vertexData[i].isFree; },
+      [this](unsigned int i) { this->recordVertex (i); },
+      [this](unsigned int from, unsigned int to) { this->moveVertex (from, to); });
+
+    this->resizeElements (numVertices, numFaces);
+    this->freeFaceIndicesChanged = true;
   }
 
   void prune (std::vector<unsigned int>* pVertexIndexMap, std::vector<unsigned int>* pFaceIndexMap)
   {
+    assert (this->recording == false);
+
+    this->realignPendingFaces ();
+
     if (this->isPruned () == false)
     {
       std::vector<unsigned int> defaultVertexIndexMap;
@@ -693,23 +1817,13 @@ struct DynamicMesh::Impl
         pFaceIndexMap = &defaultFaceIndexMap;
       }
 
-      Util::prune<VertexData> (this->vertexData, [](const VertexData& d) { return d.isFree; },
-                               pVertexIndexMap);
-      Util::prune<FaceData> (this->faceData, [](const FaceData& d) { return d.isFree; },
-                             pFaceIndexMap);
+      pruneData (this->vertexData, *pVertexIndexMap);
+      pruneData (this->faceData, *pFaceIndexMap);
 
       const unsigned int newNumVertices = this->vertexData.size ();
       const unsigned int newNumFaces = this->faceData.size ();
 
-      for (VertexData& d : this->vertexData)
-      {
-        for (unsigned int& f : d.adjacentFaces)
-        {
-          assert (pFaceIndexMap->at (f) != Util::invalidIndex ());
-
-          f = pFaceIndexMap->at (f);
-        }
-      }
+      this->adjacency.prune (*pVertexIndexMap, *pFaceIndexMap);
 
       for (unsigned int i = 0; i < pVertexIndexMap->size (); i++)
       {
@@ -731,6 +1845,13 @@ struct DynamicMesh::Impl
       this->vertexVisited.resize (newNumVertices);
       assert (this->numVertices () == newNumVertices);
 
+      std::vector<unsigned int> newTwins (3 * newNumFaces, Util::invalidIndex ());
+
+      Parallel::forRanges (pFaceIndexMap->size (), minParallelRangeSize,
+                           [this, pFaceIndexMap, &newTwins](unsigned int begin, unsigned int end) {
+                             this->remapTwins (begin, end, *pFaceIndexMap, newTwins);
+                           });
+
       for (unsigned int i = 0; i < pFaceIndexMap->size (); i++)
       {
         const unsigned int newF = pFaceIndexMap->at (i);
@@ -756,11 +1877,21 @@ struct DynamicMesh::Impl
         }
       }
       this->freeFaceIndices.clear ();
+      this->freeFaceIndicesChanged = true;
+      this->twins.assign (newTwins);
+      this->waitingHalfEdges.clear ();
       this->mesh.shrinkIndices (3 * newNumFaces);
       this->faceVisited.resize (newNumFaces);
       assert (this->numFaces () == newNumFaces);
 
-      this->octree.updateIndices (*pFaceIndexMap);
+      if (this->usingBVH)
+      {
+        this->bvh.updateIndices (*pFaceIndexMap);
+      }
+      else
+      {
+        this->octree.updateIndices (*pFaceIndexMap);
+      }
     }
   }
 
@@ -775,7 +1906,7 @@ struct DynamicMesh::Impl
       {
         if (this->vertexData[i].isFree == false)
         {
-          if (this->vertexData[i].adjacentFaces.empty ())
+          if (this->adjacency.faces (i).empty ())
           {
             DILAY_WARN ("vertex %u is not free but has no adjacent faces", i);
             return false;
@@ -790,9 +1921,42 @@ struct DynamicMesh::Impl
     }
   }
 
+  // checks the non-free vertices and faces like `MeshUtil::checkConsistency` without pruning them
+  bool checkConsistency () const
+  {
+    for (unsigned int i = 0; i < this->vertexData.size (); i++)
+    {
+      if (this->vertexData[i].isFree == false && this->adjacency.faces (i).size () < 3)
+      {
+        DILAY_WARN ("inconsistent vertex %u with %u adjacent faces", i,
+                    this->adjacency.faces (i).size ());
+        return false;
+      }
+    }
+    for (unsigned int h = 0; h < 3 * this->faceData.size (); h++)
+    {
+      if (this->faceData[h / 3].isFree == false)
+      {
+        const unsigned int e1 = this->halfEdgeSource (h);
+        const unsigned int e2 = this->halfEdgeTarget (h);
+        const unsigned int t = this->twin (h);
+
+        // each edge has exactly one half-edge in each direction
+        if (this->vertexData[e1].isFree || this->findHalfEdge (e1, e2) != h ||
+            t == Util::invalidIndex () || this->faceData[t / 3].isFree ||
+            this->halfEdgeSource (t) != e2 || this->halfEdgeTarget (t) != e1)
+        {
+          DILAY_WARN ("inconsistent edge (%u,%u)", e1, e2);
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
   bool mirror (const PrimPlane& plane)
   {
-    assert (this->pruneAndCheckConsistency ());
+    assert (this->checkConsistency ());
 
     const auto inBorder = [this, &plane](unsigned int f) {
       unsigned int i1, i2, i3;
@@ -819,7 +1983,7 @@ struct DynamicMesh::Impl
         break;
       }
     } while (ToolSculptAction::deleteFaces (*this->self, faces));
-    assert (this->pruneAndCheckConsistency ());
+    assert (this->checkConsistency ());
 
     this->prune (nullptr, nullptr);
 
@@ -832,37 +1996,42 @@ struct DynamicMesh::Impl
     else
     {
       this->fromMesh (mirrored);
-      assert (this->pruneAndCheckConsistency ());
+      assert (this->checkConsistency ());
       return true;
     }
   }
 
-  void bufferData ()
+  // draws the runs of faces between free faces: the runs only change with the free faces
+  void updateDrawRanges ()
   {
-    const auto findNonFreeFaceIndex = [this]() -> unsigned int {
-      assert (this->numFaces () > 0);
-
-      for (unsigned int i = 0; i < this->faceData.size (); i++)
-      {
-        if (this->isFreeFace (i) == false)
-        {
-          return i;
-        }
-      }
-      DILAY_IMPOSSIBLE
-    };
+    if (this->freeFaceIndicesChanged == false)
+    {
+      return;
+    }
+    this->freeFaceIndicesChanged = false;
+    this->mesh.resetDrawRanges ();
 
-    if (this->numFaces () > 0 && this->freeFaceIndices.empty () == false)
+    if (this->freeFaceIndices.empty () == false)
     {
-      const unsigned int nonFree = findNonFreeFaceIndex ();
+      std::vector<unsigned int> freeFaces (this->freeFaceIndices);
+      std::sort (freeFaces.begin (), freeFaces.end ());
 
-      for (unsigned int i : this->freeFaceIndices)
+      unsigned int first = 0;
+      for (unsigned int i : freeFaces)
       {
-        this->mesh.index ((3 * i) + 0, this->mesh.index ((3 * nonFree) + 0));
-        this->mesh.index ((3 * i) + 1, this->mesh.index ((3 * nonFree) + 1));
-        this->mesh.index ((3 * i) + 2, this->mesh.index ((3 * nonFree) + 2));
+        if (first < i)
+        {
+          this->mesh.addDrawRange (3 * first, 3 * (i - first));
+        }
+        first = i + 1;
       }
+      this->mesh.addDrawRange (3 * first, 3 * (this->faceData.size () - first));
     }
+  }
+
+  void bufferData ()
+  {
+    this->updateDrawRanges ();
     this->mesh.bufferData ();
   }
 
@@ -874,9 +2043,39 @@ struct DynamicMesh::Impl
 #endif
   }
 
+  template <typename T, typename F> void intersectsSpatialIndex (const T& t, const F& f) const
+  {
+    this->realignPendingFaces ();
+
+    if (this->usingBVH)
+    {
+      this->bvh.intersectsT (t, f);
+    }
+    else
+    {
+      this->octree.intersectsT (t, f);
+    }
+  }
+
+  template <typename F>
+  void intersectsSpatialIndex (const std::vector<PrimRay>& rays, const F& f) const
+  {
+    this->realignPendingFaces ();
+
+    if (this->usingBVH)
+    {
+      this->bvh.intersects (rays, f);
+    }
+    else
+    {
+      this->octree.intersects (rays, f);
+    }
+  }
+
   bool intersects (const PrimRay& ray, Intersection& intersection, bool bothSides) const
   {
-    this->octree.intersects (ray, [this, &ray, &intersection, bothSides](unsigned int i) -> float {
+    this->intersectsSpatialIndex (ray, [this, &ray, &intersection,
+                                        bothSides](unsigned int i) -> float {
       const PrimTriangle tri = this->face (i);
       float              t;
 
@@ -893,9 +2092,34 @@ struct DynamicMesh::Impl
     return intersection.isIntersection ();
   }
 
+  bool intersects (const std::vector<PrimRay>& rays, std::vector<Intersection>& intersections,
+                   bool bothSides) const
+  {
+    assert (rays.size () == intersections.size ());
+
+    bool isIntersection = false;
+
+    this->intersectsSpatialIndex (rays, [&](unsigned int r, unsigned int i) -> float {
+      const PrimTriangle tri = this->face (i);
+      float              t;
+
+      if (IntersectionUtil::intersects (rays[r], tri, bothSides, &t))
+      {
+        intersections[r].update (t, rays[r].pointAt (t), tri.normal ());
+        isIntersection = true;
+        return t;
+      }
+      else
+      {
+        return Util::maxFloat ();
+      }
+    });
+    return isIntersection;
+  }
+
   bool intersects (const PrimRay& ray, DynamicMeshIntersection& intersection)
   {
-    this->octree.intersects (ray, [this, &ray, &intersection](unsigned int i) -> float {
+    this->intersectsSpatialIndex (ray, [this, &ray, &intersection](unsigned int i) -> float {
       const PrimTriangle tri = this->face (i);
       float              t;
 
@@ -915,7 +2139,7 @@ struct DynamicMesh::Impl
   template <typename T, typename... Ts>
   bool intersectsT (const T& t, DynamicFaces& faces, const Ts&... args) const
   {
-    this->octree.intersects (t, [this, &t, &faces, &args...](unsigned int i) {
+    this->intersectsSpatialIndex (t, [this, &t, &faces, &args...](unsigned int i) {
       if (IntersectionUtil::intersects (t, this->face (i), args...))
       {
         faces.insert (i);
@@ -928,7 +2152,7 @@ struct DynamicMesh::Impl
   template <typename T, typename... Ts>
   bool containsOrIntersectsT (const T& t, DynamicFaces& faces, const Ts&... args) const
   {
-    this->octree.intersects (t, [this, &t, &faces, &args...](bool contains, unsigned int i) {
+    this->intersectsSpatialIndex (t, [this, &t, &faces, &args...](bool contains, unsigned int i) {
       if (contains || IntersectionUtil::intersects (t, this->face (i), args...))
       {
         faces.insert (i);
@@ -953,31 +2177,103 @@ struct DynamicMesh::Impl
     return this->containsOrIntersectsT<PrimAABox> (box, faces);
   }
 
-  float unsignedDistance (const glm::vec3& pos) const
+  float unsignedDistance (const glm::vec3& pos, unsigned int* closestFace = nullptr) const
   {
-    return this->octree.distance (
-      pos, [this, &pos](unsigned int i) { return Distance::distance (this->face (i), pos); });
+    const auto getDistance = [this, &pos](unsigned int i) {
+      return Distance::distance (this->face (i), pos);
+    };
+    this->realignPendingFaces ();
+
+    return this->usingBVH ? this->bvh.distanceT (pos, getDistance, closestFace)
+                         : this->octree.distanceT (pos, getDistance, closestFace);
+  }
+
+  unsigned int closestPoint (const glm::vec3& pos, glm::vec3& point, glm::vec3& barycentric) const
+  {
+    unsigned int closestFace;
+    this->unsignedDistance (pos, &closestFace);
+
+    assert (closestFace != Util::invalidIndex ());
+    point = Distance::closestPoint (this->face (closestFace), pos, &barycentric);
+    return closestFace;
+  }
+
+  void resetSpatialIndex ()
+  {
+    this->octree.reset ();
+    this->bvh.reset ();
+    this->dropPendingFaces ();
+
+    if (this->isEmpty () == false)
+    {
+      this->setupSpatialIndexRoot ();
+      this->addAllFacesToSpatialIndex ();
+    }
   }
 
   void normalize ()
   {
+    assert (this->recording == false);
+
     this->mesh.normalize ();
-    this->octree.reset ();
-    this->setupOctreeRoot (this->mesh);
+    this->resetSpatialIndex ();
+  }
 
-    this->forEachFace ([this](unsigned int i) { this->addFaceToOctree (i); });
+  bool usesBVH () const { return this->usingBVH; }
+
+  void useBVH (bool use)
+  {
+    if (use != this->usingBVH)
+    {
+      this->usingBVH = use;
+      this->resetSpatialIndex ();
+    }
   }
 
-  void printStatistics () const { this->octree.printStatistics (); }
+  void printStatistics () const
+  {
+    this->realignPendingFaces ();
+
+    if (this->usingBVH)
+    {
+      this->bvh.printStatistics ();
+    }
+    else
+    {
+      this->octree.printStatistics ();
+    }
+  }
+
+  MemoryUsage memoryUsage () const
+  {
+    const auto bytes = [](const auto& v) { return v.capacity () * sizeof (v[0]); };
+
+    MemoryUsage usage = this->mesh.memoryUsage ();
+    usage.add ("vertex data", this->vertexData.memoryBytes ());
+    usage.add ("face data", this->faceData.memoryBytes ());
+    usage.add ("adjacency", this->adjacency.memoryBytes ());
+    usage.add ("half-edges", this->twins.memoryBytes ());
+    usage.add ("octree", this->octree.memoryBytes ());
+    usage.add ("bvh", this->bvh.memoryBytes ());
+    usage.add ("pending faces", bytes (this->pendingFaces) + bytes (this->facePending));
+    usage.add ("free lists", bytes (this->freeVertexIndices) + bytes (this->freeFaceIndices));
+    usage.add ("visited arrays", bytes (this->vertexVisited) + bytes (this->faceVisited));
+    usage.add ("recorded changes", this->recordedDelta.memoryBytes () +
+                                     bytes (this->recordedVertices.indices ()) +
+                                     bytes (this->recordedFaces.indices ()));
+    return usage;
+  }
 
   void runFromConfig (const Config& config)
   {
     this->mesh.color (config.get<Color> ("editor/mesh/color/normal"));
     this->mesh.wireframeColor (config.get<Color> ("editor/mesh/color/wireframe"));
+    this->useBVH (config.get<bool> ("editor/mesh/use-bvh"));
   }
 };
 
 DELEGATE1_BIG4_COPY_SELF (DynamicMesh, const Mesh&)
+DELEGATE2_CONSTRUCTOR_SELF (DynamicMesh, const Mesh&, const DynamicOctree&)
 DELEGATE_CONST (unsigned int, DynamicMesh, numVertices)
 DELEGATE_CONST (unsigned int, DynamicMesh, numFaces)
 DELEGATE_CONST (bool, DynamicMesh, isEmpty)
@@ -990,7 +2286,10 @@ DELEGATE4_CONST (void, DynamicMesh, vertexIndices, unsigned int, unsigned int&,
 DELEGATE1_CONST (PrimTriangle, DynamicMesh, face, unsigned int)
 DELEGATE1_CONST (const glm::vec3&, DynamicMesh, vertexNormal, unsigned int)
 DELEGATE1_CONST (glm::vec3, DynamicMesh, faceNormal, unsigned int)
-DELEGATE1_CONST (const std::vector<unsigned int>&, DynamicMesh, adjacentFaces, unsigned int)
+DELEGATE1_CONST (unsigned int, DynamicMesh, halfEdgeSource, unsigned int)
+DELEGATE1_CONST (unsigned int, DynamicMesh, halfEdgeTarget, unsigned int)
+DELEGATE1_CONST (unsigned int, DynamicMesh, twin, unsigned int)
+DELEGATE1_CONST (DynamicAdjacency::Faces, DynamicMesh, adjacentFaces, unsigned int)
 GETTER_CONST (const Mesh&, DynamicMesh, mesh)
 DELEGATE1 (void, DynamicMesh, forEachVertex, const std::function<void(unsigned int)>&)
 DELEGATE2 (void, DynamicMesh, forEachVertex, const DynamicFaces&,
@@ -1001,7 +2300,12 @@ DELEGATE2_CONST (void, DynamicMesh, forEachVertexAdjacentToVertex, unsigned int,
                  const std::function<void(unsigned int)>&)
 DELEGATE2_CONST (void, DynamicMesh, forEachVertexAdjacentToFace, unsigned int,
                  const std::function<void(unsigned int)>&)
+DELEGATE2 (void, DynamicMesh, forEachEdge, const DynamicFaces&,
+           const std::function<void(unsigned int)>&)
 DELEGATE1 (void, DynamicMesh, forEachFace, const std::function<void(unsigned int)>&)
+DELEGATE1_CONST (void, DynamicMesh, forEachVertexParallel,
+                 const std::function<void(unsigned int)>&)
+DELEGATE1_CONST (void, DynamicMesh, forEachFaceParallel, const std::function<void(unsigned int)>&)
 DELEGATE2 (void, DynamicMesh, forEachFaceExt, const DynamicFaces&,
            const std::function<void(unsigned int)>&)
 DELEGATE3_CONST (void, DynamicMesh, average, const DynamicFaces&, glm::vec3&, glm::vec3&)
@@ -1011,14 +2315,15 @@ DELEGATE1_CONST (glm::vec3, DynamicMesh, averageNormal, const DynamicFaces&)
 DELEGATE1_CONST (glm::vec3, DynamicMesh, averageNormal, unsigned int)
 DELEGATE1_CONST (float, DynamicMesh, averageEdgeLengthSqr, const DynamicFaces&)
 DELEGATE1_CONST (float, DynamicMesh, averageEdgeLengthSqr, unsigned int)
-DELEGATE (void, DynamicMesh, setupOctreeRoot)
+DELEGATE (void, DynamicMesh, setupSpatialIndexRoot)
 DELEGATE2 (unsigned int, DynamicMesh, addVertex, const glm::vec3&, const glm::vec3&)
 DELEGATE3 (unsigned int, DynamicMesh, addFace, unsigned int, unsigned int, unsigned int)
 DELEGATE1 (void, DynamicMesh, deleteVertex, unsigned int)
 DELEGATE1 (void, DynamicMesh, deleteFace, unsigned int)
-DELEGATE2_MEMBER (void, DynamicMesh, vertex, mesh, unsigned int, const glm::vec3&)
+DELEGATE2 (void, DynamicMesh, vertex, unsigned int, const glm::vec3&)
 DELEGATE2 (void, DynamicMesh, vertexNormal, unsigned int, const glm::vec3&)
 DELEGATE1 (void, DynamicMesh, setVertexNormal, unsigned int)
+DELEGATE1 (void, DynamicMesh, setNormals, const DynamicFaces&)
 DELEGATE (void, DynamicMesh, setAllNormals)
 DELEGATE (void, DynamicMesh, reset)
 DELEGATE1 (void, DynamicMesh, fromMesh, const Mesh&)
@@ -1026,8 +2331,15 @@ DELEGATE1 (void, DynamicMesh, realignFace, unsigned int)
 DELEGATE1 (void, DynamicMesh, realignFaces, const DynamicFaces&)
 DELEGATE (void, DynamicMesh, realignAllFaces)
 DELEGATE (void, DynamicMesh, sanitize)
+DELEGATE_CONST (bool, DynamicMesh, isSparse)
+DELEGATE1 (void, DynamicMesh, compact, unsigned int)
 DELEGATE2 (void, DynamicMesh, prune, std::vector<unsigned int>*, std::vector<unsigned int>*)
 DELEGATE (bool, DynamicMesh, pruneAndCheckConsistency)
+DELEGATE_CONST (bool, DynamicMesh, checkConsistency)
+DELEGATE (void, DynamicMesh, startRecording)
+DELEGATE (DynamicMeshDelta, DynamicMesh, stopRecording)
+GETTER_CONST (bool, DynamicMesh, recording)
+DELEGATE1 (void, DynamicMesh, applyDelta, DynamicMeshDelta&)
 DELEGATE1 (bool, DynamicMesh, mirror, const PrimPlane&)
 DELEGATE (void, DynamicMesh, bufferData)
 DELEGATE1_CONST (void, DynamicMesh, render, Camera&)
@@ -1035,11 +2347,14 @@ DELEGATE_MEMBER_CONST (const RenderMode&, DynamicMesh, renderMode, mesh)
 DELEGATE_MEMBER (RenderMode&, DynamicMesh, renderMode, mesh)
 
 DELEGATE3_CONST (bool, DynamicMesh, intersects, const PrimRay&, Intersection&, bool)
+DELEGATE3_CONST (bool, DynamicMesh, intersects, const std::vector<PrimRay>&,
+                 std::vector<Intersection>&, bool)
 DELEGATE2 (bool, DynamicMesh, intersects, const PrimRay&, DynamicMeshIntersection&)
 DELEGATE2_CONST (bool, DynamicMesh, intersects, const PrimPlane&, DynamicFaces&)
 DELEGATE2_CONST (bool, DynamicMesh, intersects, const PrimSphere&, DynamicFaces&)
 DELEGATE2_CONST (bool, DynamicMesh, intersects, const PrimAABox&, DynamicFaces&)
 DELEGATE1_CONST (float, DynamicMesh, unsignedDistance, const glm::vec3&)
+DELEGATE3_CONST (unsigned int, DynamicMesh, closestPoint, const glm::vec3&, glm::vec3&, glm::vec3&)
 
 DELEGATE (void, DynamicMesh, normalize)
 DELEGATE1_MEMBER (void, DynamicMesh, scale, mesh, const glm::vec3&)
@@ -1065,12 +2380,27 @@ DELEGATE1_MEMBER (void, DynamicMesh, color, mesh, const Color&)
 DELEGATE_MEMBER_CONST (const Color&, DynamicMesh, wireframeColor, mesh)
 DELEGATE1_MEMBER (void, DynamicMesh, wireframeColor, mesh, const Color&)
 
+DELEGATE_CONST (bool, DynamicMesh, usesBVH)
+DELEGATE1 (void, DynamicMesh, useBVH, bool)
 DELEGATE_CONST (void, DynamicMesh, printStatistics)
+DELEGATE_CONST (MemoryUsage, DynamicMesh, memoryUsage)
 DELEGATE1 (void, DynamicMesh, runFromConfig, const Config&)
 
+void DynamicMesh::findAdjacent (unsigned int h, unsigned int& leftFace, unsigned int& leftVertex,
+                                unsigned int& rightFace, unsigned int& rightVertex) const
+{
+  return this->impl->findAdjacent (h, leftFace, leftVertex, rightFace, rightVertex);
+}
+
 void DynamicMesh::findAdjacent (unsigned int e1, unsigned int e2, unsigned int& leftFace,
                                 unsigned int& leftVertex, unsigned int& rightFace,
                                 unsigned int& rightVertex) const
 {
   return this->impl->findAdjacent (e1, e2, leftFace, leftVertex, rightFace, rightVertex);
 }
+
+const DynamicOctree& DynamicMesh::octree () const
+{
+  this->impl->realignPendingFaces ();
+  return this->impl->octree;
+}
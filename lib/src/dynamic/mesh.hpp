@@ -9,13 +9,17 @@
 #include <glm/fwd.hpp>
 #include <vector>
 #include "configurable.hpp"
+#include "dynamic/adjacency.hpp"
 #include "macro.hpp"
 
 class Camera;
 class Color;
 class DynamicFaces;
+class DynamicMeshDelta;
 class DynamicMeshIntersection;
+class DynamicOctree;
 class Intersection;
+class MemoryUsage;
 class Mesh;
 class PrimAABox;
 class PrimPlane;
@@ -27,8 +31,15 @@ class RenderMode;
 class DynamicMesh : public Configurable
 {
 public:
+  /* Copies share vertices, normals, indices, adjacent faces, twins, the per-element data, the
+   * nodes of the octree and the BVH and their element lists until they are modified (see
+   * `CowVector`). Visited and pending flags and free lists are copied.
+   */
   DECLARE_BIG4_EXPLICIT_COPY (DynamicMesh, const Mesh&);
 
+  // adopts the octree if it indexes all faces of the mesh, e.g., when loading a scene
+  DynamicMesh (const Mesh&, const DynamicOctree&);
+
   unsigned int     numVertices () const;
   unsigned int     numFaces () const;
   bool             isEmpty () const;
@@ -40,17 +51,37 @@ public:
   PrimTriangle     face (unsigned int) const;
   const glm::vec3& vertexNormal (unsigned int) const;
   glm::vec3        faceNormal (unsigned int) const;
+
+  /* Half-edge `3 * f + k` of face `f` runs from the face's `k`-th vertex to its `(k + 1) % 3`-th
+   * vertex. Its twin is the opposite half-edge of the adjacent face.
+   */
+  unsigned int halfEdgeSource (unsigned int) const;
+  unsigned int halfEdgeTarget (unsigned int) const;
+  unsigned int twin (unsigned int) const;
+
+  // constant time: the left face holds the half-edge, the right face holds its twin
+  void findAdjacent (unsigned int, unsigned int&, unsigned int&, unsigned int&,
+                     unsigned int&) const;
+  // finds the half-edge from the first to the second vertex among the faces of the first vertex
   void findAdjacent (unsigned int, unsigned int, unsigned int&, unsigned int&, unsigned int&,
                      unsigned int&) const;
 
-  const std::vector<unsigned int>& adjacentFaces (unsigned int) const;
+  DynamicAdjacency::Faces adjacentFaces (unsigned int) const;
 
   void forEachVertex (const std::function<void(unsigned int)>&);
   void forEachVertex (const DynamicFaces&, const std::function<void(unsigned int)>&);
   void forEachVertexExt (const DynamicFaces&, const std::function<void(unsigned int)>&);
   void forEachVertexAdjacentToVertex (unsigned int, const std::function<void(unsigned int)>&) const;
   void forEachVertexAdjacentToFace (unsigned int, const std::function<void(unsigned int)>&) const;
+  // visits one half-edge of each edge of the faces: the faces must not be modified meanwhile
+  void forEachEdge (const DynamicFaces&, const std::function<void(unsigned int)>&);
   void forEachFace (const std::function<void(unsigned int)>&);
+
+  /* Call `f` for each vertex or face in parallel (see `Parallel::forRanges`): `f` must not modify
+   * the mesh and must only write to data of its own vertex or face.
+   */
+  void forEachVertexParallel (const std::function<void(unsigned int)>&) const;
+  void forEachFaceParallel (const std::function<void(unsigned int)>&) const;
   void forEachFaceExt (const DynamicFaces&, const std::function<void(unsigned int)>&);
 
   void      average (const DynamicFaces&, glm::vec3&, glm::vec3&) const;
@@ -62,7 +93,8 @@ public:
   float     averageEdgeLengthSqr (unsigned int) const;
 
   const Mesh&  mesh () const;
-  void         setupOctreeRoot ();
+  // sets up the root of the octree around the mesh (the BVH needs no root)
+  void         setupSpatialIndexRoot ();
   unsigned int addVertex (const glm::vec3&, const glm::vec3&);
   unsigned int addFace (unsigned int, unsigned int, unsigned int);
   void         deleteVertex (unsigned int);
@@ -71,16 +103,33 @@ public:
   void vertex (unsigned int, const glm::vec3&);
   void vertexNormal (unsigned int, const glm::vec3&);
   void setVertexNormal (unsigned int);
+  void setNormals (const DynamicFaces&);
   void setAllNormals ();
 
   void reset ();
   void fromMesh (const Mesh&);
+  // applies pending realignments
+  const DynamicOctree& octree () const;
+  // realignments are queued and applied once by the next (possibly concurrent) query or `sanitize`
   void realignFace (unsigned int);
   void realignFaces (const DynamicFaces&);
   void realignAllFaces ();
   void sanitize ();
+  // many vertices or faces are free, i.e., the mesh should be pruned or compacted
+  bool isSparse () const;
+  // moves at most `maxMoves` vertices and faces into free slots and removes free slots at the end
+  void compact (unsigned int);
   void prune (std::vector<unsigned int>* = nullptr, std::vector<unsigned int>* = nullptr);
   bool pruneAndCheckConsistency ();
+  bool checkConsistency () const;
+
+  // modifications are recorded until `stopRecording`: the mesh must not be pruned, reset or
+  // normalized meanwhile
+  void             startRecording ();
+  DynamicMeshDelta stopRecording ();
+  bool             recording () const;
+  // restores the state recorded by a delta and turns the delta into its inverse
+  void applyDelta (DynamicMeshDelta&);
   bool mirror (const PrimPlane&);
   void bufferData ();
 
@@ -90,12 +139,16 @@ public:
   RenderMode&       renderMode ();
 
   bool  intersects (const PrimRay&, Intersection&, bool = false) const;
+  bool  intersects (const std::vector<PrimRay>&, std::vector<Intersection>&, bool = false) const;
   bool  intersects (const PrimRay&, DynamicMeshIntersection&);
   bool  intersects (const PrimPlane&, DynamicFaces&) const;
   bool  intersects (const PrimSphere&, DynamicFaces&) const;
   bool  intersects (const PrimAABox&, DynamicFaces&) const;
   float unsignedDistance (const glm::vec3&) const;
 
+  // returns the index of the closest face, its closest point and barycentric coordinates
+  unsigned int closestPoint (const glm::vec3&, glm::vec3&, glm::vec3&) const;
+
   void               normalize ();
   void               scale (const glm::vec3&);
   void               scaling (const glm::vec3&);
@@ -120,7 +173,10 @@ public:
   const Color&       wireframeColor () const;
   void               wireframeColor (const Color&);
 
-  void printStatistics () const;
+  bool usesBVH () const;
+  void useBVH (bool);
+  void        printStatistics () const;
+  MemoryUsage memoryUsage () const;
 
 private:
   IMPLEMENTATION
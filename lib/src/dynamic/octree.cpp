@@ -2,17 +2,24 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <QByteArray>
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <cstdint>
 #include <functional>
 #include <glm/glm.hpp>
 #include <iostream>
-#include <unordered_map>
-#include <unordered_set>
+#include <limits>
+#include <mutex>
+#include "binary-util.hpp"
+#include "cow-vector.hpp"
 #include "dynamic/octree.hpp"
 #include "intersection.hpp"
-#include "maybe.hpp"
+#include "parallel.hpp"
 #include "primitive/aabox.hpp"
 #include "primitive/plane.hpp"
+#include "primitive/ray.hpp"
 #include "primitive/sphere.hpp"
 #include "util.hpp"
 
@@ -24,42 +31,43 @@
 
 namespace
 {
-  struct IndexOctreeNode;
-  typedef Maybe<IndexOctreeNode> Child;
-
-  struct IndexOctreeStatistics
-  {
-    typedef std::unordered_map<int, unsigned int> DepthMap;
-
-    unsigned int numNodes;
-    unsigned int numElements;
-    int          minDepth;
-    int          maxDepth;
-    unsigned int maxElementsPerNode;
-    DepthMap     numElementsPerDepth;
-    DepthMap     numNodesPerDepth;
-  };
-
+  /* Nodes are stored in a pool (cf. `DynamicOctree::Impl::nodes`) and refer to their
+   * children by their index in this pool. Copies of an octree share the chunks of the pool, and
+   * with them the elements of their nodes, until they are modified.
+   * Elements of a node are stored contiguously; their positions are tracked by
+   * `DynamicOctree::Impl::elementNodeMap`.
+   */
   struct IndexOctreeNode
   {
-    const glm::vec3                  center;
-    const float                      width;
-    const int                        depth;
-    const PrimAABox                  looseAABox;
-    std::array<Child, 8>             children;
-    std::unordered_set<unsigned int> indices;
+    glm::vec3                   center;
+    float                       width;
+    int                         depth;
+    std::array<unsigned int, 8> children;
+    std::vector<unsigned int>   elements;
 
     static constexpr float relativeMinElementExtent = 0.25f;
 
     IndexOctreeNode (const glm::vec3& c, float w, int d)
-      : center (c)
-      , width (w)
-      , depth (d)
-      , looseAABox (c, 2.0f * w, 2.0f * w, 2.0f * w)
     {
       static_assert (IndexOctreeNode::relativeMinElementExtent < 0.5f,
                      "relativeMinElementExtent must be smaller than 0.5f");
+      this->reset (c, w, d);
+    }
+
+    void reset (const glm::vec3& c, float w, int d)
+    {
       assert (w > 0.0f);
+
+      this->center = c;
+      this->width = w;
+      this->depth = d;
+      this->children.fill (Util::invalidIndex ());
+      this->elements.clear ();
+    }
+
+    PrimAABox looseAABox () const
+    {
+      return PrimAABox (this->center, 2.0f * this->width, 2.0f * this->width, 2.0f * this->width);
     }
 
     bool approxContains (const glm::vec3& position, float maxDimExtent) const
@@ -81,356 +89,272 @@ namespace
      *   (+,+,+) -> 7
      */
     unsigned int childIndex (const glm::vec3& position) const
+    {
+      return IndexOctreeNode::childIndex (this->center, position);
+    }
+
+    static unsigned int childIndex (const glm::vec3& center, const glm::vec3& position)
     {
       unsigned int index = 0;
-      if (this->center.x < position.x)
+      if (center.x < position.x)
       {
         index += 4;
       }
-      if (this->center.y < position.y)
+      if (center.y < position.y)
       {
         index += 2;
       }
-      if (this->center.z < position.z)
+      if (center.z < position.z)
       {
         index += 1;
       }
       return index;
     }
 
-    bool hasChildren () const
+    glm::vec3 childCenter (unsigned int childIndex) const
     {
-      return bool(this->children[0]) || bool(this->children[1]) || bool(this->children[2]) ||
-             bool(this->children[3]) || bool(this->children[4]) || bool(this->children[5]) ||
-             bool(this->children[6]) || bool(this->children[7]);
+      return IndexOctreeNode::childCenter (this->center, this->width, childIndex);
     }
 
-    bool insertIntoChild (float maxDimExtent) const
+    static glm::vec3 childCenter (const glm::vec3& center, float width, unsigned int childIndex)
     {
-      return maxDimExtent <= this->width * IndexOctreeNode::relativeMinElementExtent;
+      const float q = width * 0.25f;
+      return center + glm::vec3 ((childIndex & 4) ? q : -q, (childIndex & 2) ? q : -q,
+                                 (childIndex & 1) ? q : -q);
     }
 
-    IndexOctreeNode& insertIntoChild (unsigned int index, const glm::vec3& position,
-                                      float maxDimExtent)
-    {
-      const unsigned int childIndex = this->childIndex (position);
+    bool hasChild (unsigned int i) const { return this->children[i] != Util::invalidIndex (); }
 
-      if (this->children[childIndex] == false)
+    bool hasChildren () const
+    {
+      for (unsigned int c : this->children)
       {
-        const float q = this->width * 0.25f;
-        const float width = this->width * 0.5f;
-        const int   depth = this->depth + 1;
-
-        switch (childIndex)
+        if (c != Util::invalidIndex ())
         {
-          case 0:
-            this->children[0] = Child::make (this->center + glm::vec3 (-q, -q, -q), width, depth);
-            break;
-          case 1:
-            this->children[1] = Child::make (this->center + glm::vec3 (-q, -q, +q), width, depth);
-            break;
-          case 2:
-            this->children[2] = Child::make (this->center + glm::vec3 (-q, +q, -q), width, depth);
-            break;
-          case 3:
-            this->children[3] = Child::make (this->center + glm::vec3 (-q, +q, +q), width, depth);
-            break;
-          case 4:
-            this->children[4] = Child::make (this->center + glm::vec3 (+q, -q, -q), width, depth);
-            break;
-          case 5:
-            this->children[5] = Child::make (this->center + glm::vec3 (+q, -q, +q), width, depth);
-            break;
-          case 6:
-            this->children[6] = Child::make (this->center + glm::vec3 (+q, +q, -q), width, depth);
-            break;
-          case 7:
-            this->children[7] = Child::make (this->center + glm::vec3 (+q, +q, +q), width, depth);
-            break;
+          return true;
         }
       }
-      return this->children[childIndex]->addElement (index, position, maxDimExtent);
+      return false;
     }
 
-    IndexOctreeNode& addElement (unsigned int index, const glm::vec3& position, float maxDimExtent)
+    bool insertIntoChild (float maxDimExtent) const
     {
-      assert (this->approxContains (position, maxDimExtent));
+      return IndexOctreeNode::insertIntoChild (this->width, maxDimExtent);
+    }
 
-      if (this->insertIntoChild (maxDimExtent))
-      {
-        return this->insertIntoChild (index, position, maxDimExtent);
-      }
-      else
-      {
-        this->indices.insert (index);
-        return *this;
-      }
+    static bool insertIntoChild (float width, float maxDimExtent)
+    {
+      return maxDimExtent <= width * IndexOctreeNode::relativeMinElementExtent;
     }
 
-    bool isEmpty () const { return this->indices.empty () && this->hasChildren () == false; }
+    bool isEmpty () const { return this->elements.empty () && this->hasChildren () == false; }
+
+    unsigned int numElements () const { return this->elements.size (); }
+  };
 
-    void deleteElement (unsigned int index)
+  struct ElementNodeEntry
+  {
+    unsigned int node;
+    unsigned int position;
+
+    ElementNodeEntry ()
+      : node (Util::invalidIndex ())
+      , position (Util::invalidIndex ())
     {
-      unsigned int n = this->indices.erase (index);
-      assert (n > 0);
-      unused (n);
     }
 
-    bool deleteEmptyChildren ()
-    {
-      bool allChildrenEmpty = true;
+    bool isValid () const { return this->node != Util::invalidIndex (); }
+  };
 
-      for (unsigned int i = 0; i < 8; i++)
-      {
-        if (this->children[i])
-        {
-          if (this->children[i]->deleteEmptyChildren ())
-          {
-            this->children[i].reset ();
-          }
-          else
-          {
-            allChildrenEmpty = false;
-          }
-        }
-      }
+  /* An element of a bulk insertion (cf. `DynamicOctree::addElements`).
+   * `key` holds the child indices of the path from the root to the element's node, 3 bits per
+   * level starting at the most significant bits, followed by the depth of the node.
+   * Sorting by `key` groups the elements of each subtree contiguously and puts the elements of a
+   * node before those of its children.
+   */
+  static constexpr unsigned int minBulkElements = 4096;
+  static constexpr unsigned int minBulkRangeSize = 1024;
 
-      if (allChildrenEmpty)
-      {
-        assert (this->hasChildren () == false);
-        return this->indices.empty ();
-      }
-      else
-      {
-        return false;
-      }
-    }
+  struct BulkElement
+  {
+    static constexpr int maxDepth = 19;
+    static constexpr int depthBits = 5;
 
-#ifdef DILAY_RENDER_OCTREE
-    void render (Camera& camera, Mesh& nodeMesh) const
-    {
-      nodeMesh.position (this->center);
-      nodeMesh.scaling (glm::vec3 (this->width * 0.5f));
-      nodeMesh.renderLines (camera);
+    uint64_t     key;
+    unsigned int position;
 
-      for (unsigned int i = 0; i < 8; i++)
-      {
-        if (this->children[i])
-        {
-          this->children[i]->render (camera, nodeMesh);
-        }
-      }
+    BulkElement ()
+      : BulkElement (Util::invalidIndex ())
+    {
     }
-#endif
 
-    template <typename T>
-    void containsOrIntersectsT (const T&                                           t,
-                                const DynamicOctree::ContainsIntersectionCallback& f) const
+    explicit BulkElement (unsigned int p)
+      : key (0)
+      , position (p)
     {
-      const bool contains = t.contains (this->looseAABox);
+    }
 
-      if (contains || IntersectionUtil::intersects (t, this->looseAABox))
-      {
-        for (unsigned int index : this->indices)
-        {
-          f (contains, index);
-        }
-        for (unsigned int i = 0; i < 8; i++)
-        {
-          if (this->children[i])
-          {
-            this->children[i]->containsOrIntersectsT<T> (t, f);
-          }
-        }
-      }
+    static int shift (int level) { return depthBits + (3 * (maxDepth - level - 1)); }
+
+    int depth () const { return int(this->key & ((1 << depthBits) - 1)); }
+
+    bool isTooDeep () const { return this->key == std::numeric_limits<uint64_t>::max (); }
+
+    void setTooDeep () { this->key = std::numeric_limits<uint64_t>::max (); }
+
+    void addChildIndex (unsigned int childIndex)
+    {
+      assert (this->depth () < maxDepth);
+      this->key += (uint64_t (childIndex) << BulkElement::shift (this->depth ())) + 1;
     }
 
-    template <typename T>
-    void intersectsT (const T& t, const DynamicOctree::IntersectionCallback& f) const
+    unsigned int childIndex (int level) const
     {
-      if (IntersectionUtil::intersects (t, this->looseAABox))
-      {
-        for (unsigned int index : this->indices)
-        {
-          f (index);
-        }
-        for (unsigned int i = 0; i < 8; i++)
-        {
-          if (this->children[i])
-          {
-            this->children[i]->intersectsT<T> (t, f);
-          }
-        }
-      }
+      return (this->key >> BulkElement::shift (level)) & 7;
     }
 
-    void intersects (const PrimRay& ray, float& distance,
-                     const DynamicOctree::RayIntersectionCallback& f) const
+    bool operator< (const BulkElement& o) const
     {
-      float t;
-      if (IntersectionUtil::intersects (ray, this->looseAABox, &t) && t < distance)
-      {
-        for (unsigned int index : this->indices)
-        {
-          distance = glm::min (f (index), distance);
-        }
-        for (unsigned int i = 0; i < 8; i++)
-        {
-          if (this->children[i])
-          {
-            this->children[i]->intersects (ray, distance, f);
-          }
-        }
-      }
+      return this->key == o.key ? this->position < o.position : this->key < o.key;
     }
+  };
+
+  // stable LSD radix sort by key: passes whose digit is equal for all elements are skipped
+  void radixSort (std::vector<BulkElement>::iterator begin, std::vector<BulkElement>::iterator end)
+  {
+    const unsigned int       n = end - begin;
+    std::vector<BulkElement> buffer (n);
 
-    void distance (PrimSphere& sphere, const DynamicOctree::DistanceCallback& getDistance) const
+    for (int shift = 0; shift < 64; shift += 8)
     {
-      for (unsigned int i : this->indices)
-      {
-        const float distance = getDistance (i);
-        if (distance < sphere.radius ())
-        {
-          sphere.radius (distance);
-        }
-      }
+      std::array<unsigned int, 257> offsets;
+      offsets.fill (0);
 
-      const unsigned int first = this->childIndex (sphere.center ());
-      const bool         hasFirst = bool(this->children[first]);
-      if (hasFirst && IntersectionUtil::intersects (sphere, this->children[first]->looseAABox))
+      for (auto it = begin; it != end; ++it)
       {
-        this->children[first]->distance (sphere, getDistance);
+        offsets[((it->key >> shift) & 255) + 1]++;
       }
-
-      for (unsigned int i = 0; i < 8; i++)
+      if (std::find (offsets.begin (), offsets.end (), n) != offsets.end ())
       {
-        const bool hasChild = i != first && bool(this->children[i]);
-        if (hasChild && IntersectionUtil::intersects (sphere, this->children[i]->looseAABox))
-        {
-          this->children[i]->distance (sphere, getDistance);
-        }
+        continue;
       }
-    }
-
-    unsigned int numElements () const { return this->indices.size (); }
-
-    void updateIndices (const std::vector<unsigned int>& indexMap)
-    {
-      std::unordered_set<unsigned int> newIndices;
-
-      for (unsigned int i : this->indices)
+      for (unsigned int i = 1; i < offsets.size (); i++)
       {
-        assert (indexMap[i] != Util::invalidIndex ());
-
-        newIndices.insert (indexMap[i]);
+        offsets[i] += offsets[i - 1];
       }
-      this->indices = std::move (newIndices);
-
-      for (unsigned int i = 0; i < 8; i++)
+      for (auto it = begin; it != end; ++it)
       {
-        if (this->children[i])
-        {
-          this->children[i]->updateIndices (indexMap);
-        }
+        buffer[offsets[(it->key >> shift) & 255]++] = *it;
       }
+      std::copy (buffer.begin (), buffer.end (), begin);
     }
+  }
 
-    void updateStatistics (IndexOctreeStatistics& stats) const
+  void parallelSort (std::vector<BulkElement>& elements)
+  {
+    std::vector<unsigned int> bounds;
+    std::mutex                boundsMutex;
+
+    Parallel::forRanges (
+      elements.size (), minBulkRangeSize,
+      [&elements, &bounds, &boundsMutex](unsigned int begin, unsigned int end) {
+        radixSort (elements.begin () + begin, elements.begin () + end);
+
+        std::lock_guard<std::mutex> lock (boundsMutex);
+        bounds.push_back (begin);
+      });
+    bounds.push_back (elements.size ());
+    std::sort (bounds.begin (), bounds.end ());
+
+    // merges neighbouring sorted ranges until a single range is left
+    while (bounds.size () > 2)
     {
-      stats.numNodes += 1;
-      stats.numElements += this->numElements ();
-      stats.minDepth = glm::min (stats.minDepth, this->depth);
-      stats.maxDepth = glm::max (stats.maxDepth, this->depth);
-      stats.maxElementsPerNode = glm::max (stats.maxElementsPerNode, this->numElements ());
+      std::vector<unsigned int> merged;
 
-      auto e = stats.numElementsPerDepth.find (this->depth);
-      if (e == stats.numElementsPerDepth.end ())
-      {
-        stats.numElementsPerDepth.emplace (this->depth, this->numElements ());
-      }
-      else
-      {
-        e->second = e->second + this->numElements ();
-      }
-      e = stats.numNodesPerDepth.find (this->depth);
-      if (e == stats.numNodesPerDepth.end ())
-      {
-        stats.numNodesPerDepth.emplace (this->depth, 1);
-      }
-      else
+      for (unsigned int i = 0; i + 2 < bounds.size (); i += 2)
       {
-        e->second = e->second + 1;
+        std::inplace_merge (elements.begin () + bounds[i], elements.begin () + bounds[i + 1],
+                            elements.begin () + bounds[i + 2]);
+        merged.push_back (bounds[i]);
       }
-      for (unsigned int i = 0; i < 8; i++)
+      if (bounds.size () % 2 == 0)
       {
-        if (this->children[i])
-        {
-          this->children[i]->updateStatistics (stats);
-        }
+        merged.push_back (bounds[bounds.size () - 2]);
       }
+      merged.push_back (bounds.back ());
+      bounds = std::move (merged);
     }
-  };
+  }
 }
 
 struct DynamicOctree::Impl
 {
-  Child                         root;
-  std::vector<IndexOctreeNode*> elementNodeMap;
+  // small chunks: cloning a chunk copies the element lists of its nodes
+  CowVector<IndexOctreeNode, 256> nodes;
+  std::vector<unsigned int>       freeNodeIndices;
+  unsigned int                    root;
+  CowVector<ElementNodeEntry>     elementNodeMap;
+  // elements of all nodes, kept so that `memoryBytes` need not visit the nodes
+  unsigned int                    numElements;
+
+  Impl ()
+    : root (Util::invalidIndex ())
+    , numElements (0)
+  {
+  }
 
-  Impl () {}
+  bool hasRoot () const { return this->root != Util::invalidIndex (); }
 
-  Impl (const Impl& other)
-    : root (other.root)
+  bool hasElement (unsigned int index) const
   {
-    this->makeElementNodeMap ();
+    return index < this->elementNodeMap.size () && this->elementNodeMap[index].isValid ();
   }
 
-  bool hasRoot () const { return bool(this->root); }
-
   void setupRoot (const glm::vec3& position, float width)
   {
     assert (this->hasRoot () == false);
-    this->root = IndexOctreeNode (position, width, 0);
+    this->root = this->makeNode (position, width, 0);
   }
 
-  void makeElementNodeMap ()
+  unsigned int makeNode (const glm::vec3& center, float width, int depth)
   {
-    std::function<void(IndexOctreeNode&)> traverse = [this, &traverse](IndexOctreeNode& node) {
-      for (unsigned i : node.indices)
-      {
-        this->addToElementNodeMap (i, node);
-      }
-      for (unsigned int i = 0; i < 8; i++)
-      {
-        if (node.children[i])
-        {
-          traverse (*node.children[i]);
-        }
-      }
-    };
-    if (this->root)
+    if (this->freeNodeIndices.empty ())
     {
-      traverse (*this->root);
+      this->nodes.push_back (IndexOctreeNode (center, width, depth));
+      return this->nodes.size () - 1;
+    }
+    else
+    {
+      const unsigned int index = this->freeNodeIndices.back ();
+      this->freeNodeIndices.pop_back ();
+      this->nodes.mutableAt (index).reset (center, width, depth);
+      return index;
     }
   }
 
-  void addToElementNodeMap (unsigned int index, IndexOctreeNode& node)
+  void freeNode (unsigned int n)
   {
-    if (index >= this->elementNodeMap.size ())
+    assert (this->nodes[n].elements.empty ());
+
+    for (unsigned int c : this->nodes[n].children)
     {
-      this->elementNodeMap.resize (index + 1, nullptr);
+      if (c != Util::invalidIndex ())
+      {
+        this->freeNode (c);
+      }
     }
-    assert (this->elementNodeMap[index] == nullptr);
-    this->elementNodeMap[index] = &node;
+    this->nodes.mutableAt (n).children.fill (Util::invalidIndex ());
+    this->freeNodeIndices.push_back (n);
   }
 
   void makeParent (const glm::vec3& position)
   {
     assert (this->hasRoot ());
 
-    const glm::vec3 rootCenter = this->root->center;
-    const float     rootWidth = this->root->width;
-    const float     halfRootWidth = this->root->width * 0.5f;
+    const glm::vec3 rootCenter = this->nodes[this->root].center;
+    const float     rootWidth = this->nodes[this->root].width;
+    const float     halfRootWidth = rootWidth * 0.5f;
+    const int       rootDepth = this->nodes[this->root].depth;
     glm::vec3       parentCenter;
     int             index = 0;
 
@@ -456,20 +380,54 @@ struct DynamicOctree::Impl
       index += 1;
     }
 
-    IndexOctreeNode* newRoot =
-      new IndexOctreeNode (parentCenter, rootWidth * 2.0f, this->root->depth - 1);
-    newRoot->children[index] = std::move (this->root);
-    this->root.reset (newRoot);
+    const unsigned int newRoot = this->makeNode (parentCenter, rootWidth * 2.0f, rootDepth - 1);
+    this->nodes.mutableAt (newRoot).children[index] = this->root;
+    this->root = newRoot;
+  }
+
+  void addToElementNodeMap (unsigned int index, unsigned int node, unsigned int position)
+  {
+    if (index >= this->elementNodeMap.size ())
+    {
+      this->elementNodeMap.resize (index + 1);
+    }
+    ElementNodeEntry& entry = this->elementNodeMap.mutableAt (index);
+
+    assert (entry.isValid () == false);
+    entry.node = node;
+    entry.position = position;
   }
 
   void addElement (unsigned int index, const glm::vec3& position, float maxDimExtent)
   {
     assert (this->hasRoot ());
 
-    if (this->root->approxContains (position, maxDimExtent))
+    if (this->nodes[this->root].approxContains (position, maxDimExtent))
     {
-      IndexOctreeNode& node = this->root->addElement (index, position, maxDimExtent);
-      this->addToElementNodeMap (index, node);
+      unsigned int n = this->root;
+
+      while (this->nodes[n].insertIntoChild (maxDimExtent))
+      {
+        assert (this->nodes[n].approxContains (position, maxDimExtent));
+
+        const unsigned int childIndex = this->nodes[n].childIndex (position);
+
+        if (this->nodes[n].hasChild (childIndex) == false)
+        {
+          const glm::vec3    center = this->nodes[n].childCenter (childIndex);
+          const float        width = this->nodes[n].width * 0.5f;
+          const int          depth = this->nodes[n].depth + 1;
+          const unsigned int child = this->makeNode (center, width, depth);
+
+          this->nodes.mutableAt (n).children[childIndex] = child;
+        }
+        n = this->nodes[n].children[childIndex];
+      }
+      assert (this->nodes[n].approxContains (position, maxDimExtent));
+
+      this->nodes.mutableAt (n).elements.push_back (index);
+      this->addToElementNodeMap (index, n, this->nodes[n].elements.size () - 1);
+      this->numElements++;
     }
     else
     {
@@ -478,16 +436,148 @@ struct DynamicOctree::Impl
     }
   }
 
+  /* Inserts elements like successive calls of `addElement` would do: the path of each element is
+   * computed in parallel, the elements are sorted by their paths and each node is then visited
+   * once for all of its new elements.
+   * Elements are inserted in batches that end whenever the root must grow.
+   * On a single core, the additional sorting does not pay off.
+   */
+  void addElements (const std::vector<unsigned int>& indices,
+                    const std::vector<glm::vec3>&    positions,
+                    const std::vector<float>&        maxDimExtents)
+  {
+    assert (this->hasRoot ());
+    assert (indices.size () == positions.size ());
+    assert (indices.size () == maxDimExtents.size ());
+
+    if (Parallel::numThreads () < 2 || indices.size () < minBulkElements)
+    {
+      for (unsigned int i = 0; i < indices.size (); i++)
+      {
+        this->addElement (indices[i], positions[i], maxDimExtents[i]);
+      }
+      return;
+    }
+
+    unsigned int begin = 0;
+    for (unsigned int i = 0; i < indices.size (); i++)
+    {
+      if (this->nodes[this->root].approxContains (positions[i], maxDimExtents[i]) == false)
+      {
+        this->addElementsBelowRoot (begin, i, indices, positions, maxDimExtents);
+        begin = i;
+
+        do
+        {
+          this->makeParent (positions[i]);
+        } while (this->nodes[this->root].approxContains (positions[i], maxDimExtents[i]) == false);
+      }
+    }
+    this->addElementsBelowRoot (begin, indices.size (), indices, positions, maxDimExtents);
+  }
+
+  void addElementsBelowRoot (unsigned int begin, unsigned int end,
+                             const std::vector<unsigned int>& indices,
+                             const std::vector<glm::vec3>&    positions,
+                             const std::vector<float>&        maxDimExtents)
+  {
+    std::vector<BulkElement> bulk (end - begin);
+
+    Parallel::forRanges (end - begin, minBulkRangeSize, [&](unsigned int from, unsigned int to) {
+      for (unsigned int b = from; b < to; b++)
+      {
+        const unsigned int i = begin + b;
+        const glm::vec3&   position = positions[i];
+        const float        maxDimExtent = maxDimExtents[i];
+        BulkElement        e (i);
+        unsigned int       n = this->root;
+        glm::vec3          center = this->nodes[n].center;
+        float              width = this->nodes[n].width;
+
+        // descends like `addElement`: existing nodes are followed, missing ones are simulated
+        while (IndexOctreeNode::insertIntoChild (width, maxDimExtent))
+        {
+          if (e.depth () == BulkElement::maxDepth)
+          {
+            e.setTooDeep ();
+            break;
+          }
+          const unsigned int childIndex = IndexOctreeNode::childIndex (center, position);
+
+          e.addChildIndex (childIndex);
+
+          if (n != Util::invalidIndex () && this->nodes[n].hasChild (childIndex))
+          {
+            n = this->nodes[n].children[childIndex];
+            center = this->nodes[n].center;
+            width = this->nodes[n].width;
+          }
+          else
+          {
+            n = Util::invalidIndex ();
+            center = IndexOctreeNode::childCenter (center, width, childIndex);
+            width = width * 0.5f;
+          }
+        }
+        bulk[b] = e;
+      }
+    });
+    parallelSort (bulk);
+
+    auto tooDeep = std::find_if (bulk.begin (), bulk.end (),
+                                 [](const BulkElement& e) { return e.isTooDeep (); });
+
+    this->addSortedElements (this->root, 0, bulk.begin (), tooDeep, indices);
+
+    for (; tooDeep != bulk.end (); ++tooDeep)
+    {
+      const unsigned int i = tooDeep->position;
+      this->addElement (indices[i], positions[i], maxDimExtents[i]);
+    }
+  }
+
+  void addSortedElements (unsigned int n, int level, std::vector<BulkElement>::const_iterator begin,
+                          std::vector<BulkElement>::const_iterator end,
+                          const std::vector<unsigned int>&         indices)
+  {
+    for (; begin != end && begin->depth () == level; ++begin)
+    {
+      this->nodes.mutableAt (n).elements.push_back (indices[begin->position]);
+      this->addToElementNodeMap (indices[begin->position], n, this->nodes[n].elements.size () - 1);
+      this->numElements++;
+    }
+    while (begin != end)
+    {
+      const unsigned int childIndex = begin->childIndex (level);
+      const auto childEnd = std::find_if (begin, end, [level, childIndex](const BulkElement& e) {
+        return e.childIndex (level) != childIndex;
+      });
+
+      if (this->nodes[n].hasChild (childIndex) == false)
+      {
+        const glm::vec3    center = this->nodes[n].childCenter (childIndex);
+        const float        width = this->nodes[n].width * 0.5f;
+        const int          depth = this->nodes[n].depth + 1;
+        const unsigned int child = this->makeNode (center, width, depth);
+
+        this->nodes.mutableAt (n).children[childIndex] = child;
+      }
+      this->addSortedElements (this->nodes[n].children[childIndex], level + 1, begin, childEnd,
+                               indices);
+      begin = childEnd;
+    }
+  }
+
   void realignElement (unsigned int index, const glm::vec3& position, float maxDimExtent)
   {
     assert (this->hasRoot ());
     assert (index < this->elementNodeMap.size ());
-    assert (this->elementNodeMap[index]);
+    assert (this->elementNodeMap[index].isValid ());
 
-    IndexOctreeNode* node = this->elementNodeMap[index];
+    const IndexOctreeNode& node = this->nodes[this->elementNodeMap[index].node];
 
-    if (node->approxContains (position, maxDimExtent) == false ||
-        node->insertIntoChild (maxDimExtent))
+    if (node.approxContains (position, maxDimExtent) == false ||
+        node.insertIntoChild (maxDimExtent))
     {
       this->deleteElement (index);
       this->addElement (index, position, maxDimExtent);
@@ -497,67 +587,115 @@ struct DynamicOctree::Impl
   void deleteElement (unsigned int index)
   {
     assert (index < this->elementNodeMap.size ());
-    assert (this->elementNodeMap[index]);
+    assert (this->elementNodeMap[index].isValid ());
 
-    this->elementNodeMap[index]->deleteElement (index);
-    this->elementNodeMap[index] = nullptr;
+    const ElementNodeEntry     entry = this->elementNodeMap[index];
+    std::vector<unsigned int>& elements = this->nodes.mutableAt (entry.node).elements;
 
-    if (this->hasRoot ())
+    assert (elements[entry.position] == index);
+
+    elements[entry.position] = elements.back ();
+    this->elementNodeMap.mutableAt (elements.back ()).position = entry.position;
+    elements.pop_back ();
+    this->elementNodeMap.set (index, ElementNodeEntry ());
+    this->numElements--;
+
+    // empty nodes are collected by `deleteEmptyChildren` and `shrinkRoot`, which are called once
+    // per sculpt stroke (see `DynamicMesh::sanitize`)
+    if (this->hasRoot () && this->nodes[this->root].isEmpty ())
     {
-      if (this->root->isEmpty ())
-      {
-        this->root.reset ();
-      }
-      else
+      this->resetNodes ();
+    }
+  }
+
+  bool deleteEmptyChildren (unsigned int n)
+  {
+    bool allChildrenEmpty = true;
+
+    for (unsigned int i = 0; i < 8; i++)
+    {
+      const unsigned int c = this->nodes[n].children[i];
+      if (c != Util::invalidIndex ())
       {
-        this->shrinkRoot ();
+        if (this->deleteEmptyChildren (c))
+        {
+          this->freeNode (c);
+          this->nodes.mutableAt (n).children[i] = Util::invalidIndex ();
+        }
+        else
+        {
+          allChildrenEmpty = false;
+        }
       }
     }
+
+    if (allChildrenEmpty)
+    {
+      assert (this->nodes[n].hasChildren () == false);
+      return this->nodes[n].elements.empty ();
+    }
+    else
+    {
+      return false;
+    }
   }
 
   void deleteEmptyChildren ()
   {
     if (this->hasRoot ())
     {
-      if (this->root->deleteEmptyChildren ())
+      if (this->deleteEmptyChildren (this->root))
       {
-        this->root.reset ();
+        this->resetNodes ();
       }
     }
   }
 
   void updateIndices (const std::vector<unsigned int>& newIndices)
   {
+    unsigned int numSurviving = 0;
     for (unsigned int i = 0; i < newIndices.size (); i++)
     {
       const unsigned int newI = newIndices[i];
+      if (newI != Util::invalidIndex ())
+      {
+        numSurviving = std::max (numSurviving, newI + 1);
+      }
       if (newI != Util::invalidIndex () && newI != i)
       {
         assert (i < this->elementNodeMap.size ());
         assert (newI < this->elementNodeMap.size ());
-        assert (this->elementNodeMap[i]);
-        assert (this->elementNodeMap[newI] == nullptr);
+        assert (this->elementNodeMap[i].isValid ());
+        assert (this->elementNodeMap[newI].isValid () == false);
 
-        this->elementNodeMap[newI] = this->elementNodeMap[i];
-        this->elementNodeMap[i] = nullptr;
+        this->elementNodeMap.set (newI, this->elementNodeMap[i]);
+        this->elementNodeMap.set (i, ElementNodeEntry ());
       }
     }
-    this->elementNodeMap.resize (newIndices.size ());
+    this->elementNodeMap.resize (numSurviving);
 
-    if (this->hasRoot ())
+    for (unsigned int n = 0; n < this->nodes.size (); n++)
     {
-      this->root->updateIndices (newIndices);
+      for (unsigned int& e : this->nodes.mutableAt (n).elements)
+      {
+        assert (newIndices[e] != Util::invalidIndex ());
+
+        e = newIndices[e];
+      }
     }
   }
 
   void shrinkRoot ()
   {
-    if (this->hasRoot () && this->root->indices.empty () && this->root->hasChildren ())
+    if (this->hasRoot () && this->nodes[this->root].elements.empty () &&
+        this->nodes[this->root].hasChildren ())
     {
-      int singleNonEmptyChildIndex = -1;
+      const IndexOctreeNode& rootNode = this->nodes[this->root];
+      int                    singleNonEmptyChildIndex = -1;
+
       for (int i = 0; i < 8; i++)
       {
-        if (this->root->children[i] && this->root->children[i]->isEmpty () == false)
+        if (rootNode.hasChild (i) && this->nodes[rootNode.children[i]].isEmpty () == false)
         {
           if (singleNonEmptyChildIndex == -1)
           {
@@ -571,19 +709,48 @@ struct DynamicOctree::Impl
       }
       if (singleNonEmptyChildIndex != -1)
       {
-        this->root = std::move (this->root->children[singleNonEmptyChildIndex]);
+        const unsigned int oldRoot = this->root;
+
+        this->root = rootNode.children[singleNonEmptyChildIndex];
+        this->nodes.mutableAt (oldRoot).children[singleNonEmptyChildIndex] = Util::invalidIndex ();
+        this->freeNode (oldRoot);
         this->shrinkRoot ();
       }
     }
   }
 
+  void resetNodes ()
+  {
+    this->nodes.clear ();
+    this->freeNodeIndices.clear ();
+    this->root = Util::invalidIndex ();
+    this->numElements = 0;
+  }
+
   void reset ()
   {
-    this->root.reset ();
+    this->resetNodes ();
     this->elementNodeMap.clear ();
   }
 
 #ifdef DILAY_RENDER_OCTREE
+  void render (Camera& camera, Mesh& nodeMesh, unsigned int n) const
+  {
+    const IndexOctreeNode& node = this->nodes[n];
+
+    nodeMesh.position (node.center);
+    nodeMesh.scaling (glm::vec3 (node.width * 0.5f));
+    nodeMesh.renderLines (camera);
+
+    for (unsigned int c : node.children)
+    {
+      if (c != Util::invalidIndex ())
+      {
+        this->render (camera, nodeMesh, c);
+      }
+    }
+  }
+
   void render (Camera& camera) const
   {
     Mesh nodeMesh;
@@ -639,82 +806,566 @@ struct DynamicOctree::Impl
 
     if (this->hasRoot ())
     {
-      this->root->render (camera, nodeMesh);
+      this->render (camera, nodeMesh, this->root);
     }
   }
 #else
   void render (Camera&) const { DILAY_IMPOSSIBLE }
 #endif
 
+  template <typename T>
+  void containsOrIntersectsT (unsigned int n, const T& t,
+                              const DynamicOctree::NodeContainsIntersectionCallback& f) const
+  {
+    const IndexOctreeNode& node = this->nodes[n];
+    const PrimAABox        looseAABox = node.looseAABox ();
+    const bool             contains = t.contains (looseAABox);
+
+    if (contains || IntersectionUtil::intersects (t, looseAABox))
+    {
+      if (node.elements.empty () == false)
+      {
+        f (contains, node.elements);
+      }
+      for (unsigned int c : node.children)
+      {
+        if (c != Util::invalidIndex ())
+        {
+          this->containsOrIntersectsT<T> (c, t, f);
+        }
+      }
+    }
+  }
+
+  template <typename T>
+  void intersectsT (unsigned int n, const T& t,
+                    const DynamicOctree::NodeIntersectionCallback& f) const
+  {
+    const IndexOctreeNode& node = this->nodes[n];
+
+    if (IntersectionUtil::intersects (t, node.looseAABox ()))
+    {
+      if (node.elements.empty () == false)
+      {
+        f (node.elements);
+      }
+      for (unsigned int c : node.children)
+      {
+        if (c != Util::invalidIndex ())
+        {
+          this->intersectsT<T> (c, t, f);
+        }
+      }
+    }
+  }
+
+  // visits children in the order in which they are entered by the ray and stops as soon as no
+  // remaining child can contain an intersection closer than `distance`
+  void intersects (unsigned int n, const PrimRay& ray, float& distance,
+                   const DynamicOctree::NodeRayIntersectionCallback& f) const
+  {
+    typedef std::pair<float, unsigned int> ChildHit;
+
+    const IndexOctreeNode&  node = this->nodes[n];
+    std::array<ChildHit, 8> childHits;
+    unsigned int            numChildHits = 0;
+
+    if (node.elements.empty () == false)
+    {
+      distance = glm::min (f (node.elements), distance);
+    }
+    for (unsigned int c : node.children)
+    {
+      float t;
+      if (c != Util::invalidIndex () &&
+          IntersectionUtil::intersects (ray, this->nodes[c].looseAABox (), &t) && t < distance)
+      {
+        childHits[numChildHits++] = ChildHit (t, c);
+      }
+    }
+    std::sort (childHits.begin (), childHits.begin () + numChildHits);
+
+    for (unsigned int i = 0; i < numChildHits && childHits[i].first < distance; i++)
+    {
+      this->intersects (childHits[i].second, ray, distance, f);
+    }
+  }
+
+  /* Traverses a packet of rays at once: node boxes and element lists are loaded once per packet
+   * and the callback is called with a ray's index in the packet and an element.
+   * `packet` holds pairs of ray indices and the distances at which the rays enter a node;
+   * the rays that enter node `n` are stored in the range [`begin`, `end`) of `packet`.
+   */
+  typedef std::vector<std::pair<unsigned int, float>> RayPacket;
+
+  void intersects (unsigned int n, const std::vector<PrimRay>& rays, RayPacket& packet,
+                   unsigned int begin, unsigned int end, std::vector<float>& distances,
+                   const DynamicOctree::RayPacketIntersectionCallback& f) const
+  {
+    struct ChildHit
+    {
+      float        t;
+      unsigned int child;
+      unsigned int begin;
+      unsigned int end;
+
+      bool operator< (const ChildHit& o) const { return this->t < o.t; }
+    };
+
+    const IndexOctreeNode&  node = this->nodes[n];
+    std::array<ChildHit, 8> childHits;
+    unsigned int            numChildHits = 0;
+    const unsigned int      base = packet.size ();
+
+    for (unsigned int e : node.elements)
+    {
+      for (unsigned int i = begin; i < end; i++)
+      {
+        const unsigned int r = packet[i].first;
+        if (packet[i].second < distances[r])
+        {
+          distances[r] = glm::min (f (r, e), distances[r]);
+        }
+      }
+    }
+    for (unsigned int c : node.children)
+    {
+      if (c != Util::invalidIndex ())
+      {
+        const PrimAABox    looseAABox = this->nodes[c].looseAABox ();
+        const unsigned int childBegin = packet.size ();
+        float              minT = Util::maxFloat ();
+
+        for (unsigned int i = begin; i < end; i++)
+        {
+          const unsigned int r = packet[i].first;
+          float              t;
+
+          if (packet[i].second < distances[r] &&
+              IntersectionUtil::intersects (rays[r], looseAABox, &t) && t < distances[r])
+          {
+            packet.emplace_back (r, t);
+            minT = glm::min (minT, t);
+          }
+        }
+        if (packet.size () > childBegin)
+        {
+          childHits[numChildHits++] = ChildHit{minT, c, childBegin, (unsigned int) packet.size ()};
+        }
+      }
+    }
+    std::sort (childHits.begin (), childHits.begin () + numChildHits);
+
+    for (unsigned int i = 0; i < numChildHits; i++)
+    {
+      this->intersects (childHits[i].child, rays, packet, childHits[i].begin, childHits[i].end,
+                        distances, f);
+    }
+    packet.resize (base);
+  }
+
+  void distance (unsigned int n, PrimSphere& sphere, unsigned int& closest,
+                 const DynamicOctree::NodeDistanceCallback& getDistance) const
+  {
+    const IndexOctreeNode& node = this->nodes[n];
+
+    if (node.elements.empty () == false)
+    {
+      float distance = sphere.radius ();
+      getDistance (node.elements, distance, closest);
+      sphere.radius (distance);
+    }
+
+    const unsigned int first = node.childIndex (sphere.center ());
+    if (node.hasChild (first) &&
+        IntersectionUtil::intersects (sphere, this->nodes[node.children[first]].looseAABox ()))
+    {
+      this->distance (node.children[first], sphere, closest, getDistance);
+    }
+
+    for (unsigned int i = 0; i < 8; i++)
+    {
+      const bool hasChild = i != first && node.hasChild (i);
+      if (hasChild &&
+          IntersectionUtil::intersects (sphere, this->nodes[node.children[i]].looseAABox ()))
+      {
+        this->distance (node.children[i], sphere, closest, getDistance);
+      }
+    }
+  }
+
   void intersects (const PrimRay& ray, const DynamicOctree::RayIntersectionCallback& f) const
+  {
+    this->intersectsNodes (ray, DynamicVisitor::rayIntersection (f));
+  }
+
+  void intersectsNodes (const PrimRay&                                    ray,
+                        const DynamicOctree::NodeRayIntersectionCallback& f) const
   {
     if (this->hasRoot ())
     {
       float distance = Util::maxFloat ();
-      return this->root->intersects (ray, distance, f);
+      if (IntersectionUtil::intersects (ray, this->nodes[this->root].looseAABox (), nullptr))
+      {
+        this->intersects (this->root, ray, distance, f);
+      }
     }
   }
 
-  void intersects (const PrimPlane& plane, const DynamicOctree::IntersectionCallback& f) const
+  void intersects (const std::vector<PrimRay>&                        rays,
+                   const DynamicOctree::RayPacketIntersectionCallback& f) const
   {
     if (this->hasRoot ())
     {
-      return this->root->intersectsT<PrimPlane> (plane, f);
+      const PrimAABox    looseAABox = this->nodes[this->root].looseAABox ();
+      std::vector<float> distances (rays.size (), Util::maxFloat ());
+      RayPacket          packet;
+
+      packet.reserve (2 * rays.size ());
+      for (unsigned int r = 0; r < rays.size (); r++)
+      {
+        float t;
+        if (IntersectionUtil::intersects (rays[r], looseAABox, &t))
+        {
+          packet.emplace_back (r, t);
+        }
+      }
+      if (packet.empty () == false)
+      {
+        this->intersects (this->root, rays, packet, 0, packet.size (), distances, f);
+      }
     }
   }
 
+  void intersects (const PrimPlane& plane, const DynamicOctree::IntersectionCallback& f) const
+  {
+    this->intersectsNodes (plane, DynamicVisitor::intersection (f));
+  }
+
   void intersects (const PrimSphere&                                  sphere,
                    const DynamicOctree::ContainsIntersectionCallback& f) const
+  {
+    this->intersectsNodes (sphere, DynamicVisitor::containsIntersection (f));
+  }
+
+  void intersects (const PrimAABox& box, const DynamicOctree::ContainsIntersectionCallback& f) const
+  {
+    this->intersectsNodes (box, DynamicVisitor::containsIntersection (f));
+  }
+
+  float distance (const glm::vec3& p, const DistanceCallback& getDistance,
+                  unsigned int* closest) const
+  {
+    return this->distanceNodes (p, DynamicVisitor::distance (getDistance), closest);
+  }
+
+  void intersectsNodes (const PrimPlane&                               plane,
+                        const DynamicOctree::NodeIntersectionCallback& f) const
   {
     if (this->hasRoot ())
     {
-      return this->root->containsOrIntersectsT<PrimSphere> (sphere, f);
+      return this->intersectsT<PrimPlane> (this->root, plane, f);
     }
   }
 
-  void intersects (const PrimAABox& box, const DynamicOctree::ContainsIntersectionCallback& f) const
+  void intersectsNodes (const PrimSphere&                                      sphere,
+                        const DynamicOctree::NodeContainsIntersectionCallback& f) const
   {
     if (this->hasRoot ())
     {
-      return this->root->containsOrIntersectsT<PrimAABox> (box, f);
+      return this->containsOrIntersectsT<PrimSphere> (this->root, sphere, f);
     }
   }
 
-  float distance (const glm::vec3& p, const DistanceCallback& getDistance) const
+  void intersectsNodes (const PrimAABox&                                       box,
+                        const DynamicOctree::NodeContainsIntersectionCallback& f) const
+  {
+    if (this->hasRoot ())
+    {
+      return this->containsOrIntersectsT<PrimAABox> (this->root, box, f);
+    }
+  }
+
+  float distanceNodes (const glm::vec3& p, const DynamicOctree::NodeDistanceCallback& getDistance,
+                       unsigned int* closest) const
   {
     assert (this->hasRoot ());
-    PrimSphere sphere (p, Util::maxFloat ());
-    this->root->distance (sphere, getDistance);
+    PrimSphere   sphere (p, Util::maxFloat ());
+    unsigned int closestElement = Util::invalidIndex ();
+
+    this->distance (this->root, sphere, closestElement, getDistance);
+
+    if (closest)
+    {
+      *closest = closestElement;
+    }
     return sphere.radius ();
   }
 
-  void printStatistics () const
+  // returns `true` if the subtree of `n` has no elements
+  bool updateStatistics (unsigned int n, DynamicOctree::Statistics& stats) const
   {
-    IndexOctreeStatistics stats{0,
-                                0,
-                                Util::maxInt (),
-                                Util::minInt (),
-                                0,
-                                IndexOctreeStatistics::DepthMap (),
-                                IndexOctreeStatistics::DepthMap ()};
+    const IndexOctreeNode& node = this->nodes[n];
+    bool                   isEmpty = node.elements.empty ();
+
+    stats.numNodes += 1;
+    stats.numElements += node.numElements ();
+    stats.minDepth = glm::min (stats.minDepth, node.depth);
+    stats.maxDepth = glm::max (stats.maxDepth, node.depth);
+    stats.maxElementsPerNode = glm::max (stats.maxElementsPerNode, node.numElements ());
+    stats.numElementsPerDepth[node.depth] += node.numElements ();
+    stats.numNodesPerDepth[node.depth] += 1;
+
+    for (unsigned int c : node.children)
+    {
+      if (c != Util::invalidIndex ())
+      {
+        isEmpty = this->updateStatistics (c, stats) && isEmpty;
+      }
+    }
+    if (isEmpty)
+    {
+      stats.numEmptyNodes += 1;
+    }
+    return isEmpty;
+  }
+
+  DynamicOctree::Statistics statistics () const
+  {
+    DynamicOctree::Statistics stats{0,
+                                    0,
+                                    0,
+                                    0,
+                                    Util::maxInt (),
+                                    Util::minInt (),
+                                    0.0f,
+                                    DynamicOctree::Statistics::DepthMap (),
+                                    DynamicOctree::Statistics::DepthMap (),
+                                    0};
     if (this->hasRoot ())
     {
-      this->root->updateStatistics (stats);
+      this->updateStatistics (this->root, stats);
+      stats.rootWidth = this->nodes[this->root].width;
     }
+
+    assert (stats.numElements == this->numElements);
+
+    stats.memoryBytes = this->memoryBytes ();
+    return stats;
+  }
+
+  // includes free nodes of the pool, element lists are counted without their spare capacity
+  std::size_t memoryBytes () const
+  {
+    return sizeof (DynamicOctree::Impl) + this->nodes.memoryBytes () +
+           (this->freeNodeIndices.capacity () * sizeof (unsigned int)) +
+           (this->numElements * sizeof (unsigned int)) + this->elementNodeMap.memoryBytes ();
+  }
+
+  void printStatistics () const
+  {
+    const DynamicOctree::Statistics stats = this->statistics ();
+
     std::cout << "octree:"
               << "\n\tnum nodes:\t\t\t" << stats.numNodes << "\n\tnum elements:\t\t\t"
               << stats.numElements << "\n\tmax elements per node:\t\t" << stats.maxElementsPerNode
               << "\n\tmin depth:\t\t\t" << stats.minDepth << "\n\tmax depth:\t\t\t"
-              << stats.maxDepth << "\n\telements per node:\t\t"
-              << float(stats.numElements) / float(stats.numNodes) << std::endl;
+              << stats.maxDepth << "\n\telements per node:\t\t" << stats.elementsPerNode ()
+              << "\n\tempty node ratio:\t\t" << stats.emptyNodeRatio ()
+              << "\n\tmemory (bytes):\t\t\t" << stats.memoryBytes << std::endl;
+
+    for (const auto& d : stats.numNodesPerDepth)
+    {
+      std::cout << "\tdepth " << d.first << ":\t\t\t" << d.second << " nodes, "
+                << stats.numElementsPerDepth.at (d.first) << " elements" << std::endl;
+    }
+  }
+
+  QByteArray toBinary (const std::vector<unsigned int>& indexMap) const
+  {
+    QByteArray data;
+
+    if (this->hasRoot () == false)
+    {
+      return data;
+    }
+    std::vector<unsigned int> preOrder;
+    std::vector<unsigned int> stack = {this->root};
+
+    while (stack.empty () == false)
+    {
+      const unsigned int n = stack.back ();
+      stack.pop_back ();
+      preOrder.push_back (n);
+
+      for (unsigned int i = 8; i-- > 0;)
+      {
+        if (this->nodes[n].hasChild (i))
+        {
+          stack.push_back (this->nodes[n].children[i]);
+        }
+      }
+    }
+
+    const IndexOctreeNode& rootNode = this->nodes[this->root];
+    unsigned int           previousDepth = 0;
+    unsigned int           previousElement = 0;
+
+    BinaryUtil::putFloats (data, {rootNode.center.x, rootNode.center.y, rootNode.center.z,
+                                  rootNode.width});
+    BinaryUtil::putIndex (data, previousDepth, static_cast<unsigned int> (rootNode.depth));
+    BinaryUtil::putVarint (data, preOrder.size ());
+
+    for (unsigned int n : preOrder)
+    {
+      unsigned char childMask = 0;
+      for (unsigned int i = 0; i < 8; i++)
+      {
+        if (this->nodes[n].hasChild (i))
+        {
+          childMask |= 1 << i;
+        }
+      }
+      data.append (char(childMask));
+      BinaryUtil::putVarint (data, this->nodes[n].elements.size ());
+
+      for (unsigned int e : this->nodes[n].elements)
+      {
+        assert (indexMap[e] != Util::invalidIndex ());
+        BinaryUtil::putIndex (data, previousElement, indexMap[e]);
+      }
+    }
+    return data;
+  }
+
+  bool readBinaryNode (BinaryUtil::Reader& reader, unsigned int n, unsigned int numElements,
+                       unsigned int& previousElement, std::vector<unsigned int>& pendingChildren)
+  {
+    const unsigned char childMask = reader.byte ();
+    const unsigned int  numNodeElements = reader.varint ();
+
+    if (reader.failed () || numNodeElements > reader.remaining ())
+    {
+      return false;
+    }
+    for (unsigned int i = 0; i < numNodeElements; i++)
+    {
+      const unsigned int e = reader.index (previousElement);
+
+      if (reader.failed () || e >= numElements || this->elementNodeMap[e].isValid ())
+      {
+        return false;
+      }
+      this->nodes.mutableAt (n).elements.push_back (e);
+      this->addToElementNodeMap (e, n, i);
+    }
+    this->numElements += numNodeElements;
+
+    for (unsigned int i = 8; i-- > 0;)
+    {
+      if (childMask & (1 << i))
+      {
+        pendingChildren.push_back ((n << 3) | i);
+      }
+    }
+    return true;
+  }
+
+  bool readBinary (const QByteArray& data, unsigned int numElements)
+  {
+    BinaryUtil::Reader reader (data);
+    std::vector<float> rootFloats (4);
+    unsigned int       depth = 0;
+    unsigned int       previousElement = 0;
+
+    reader.floats (rootFloats);
+    reader.index (depth);
+
+    const glm::vec3    rootCenter (rootFloats[0], rootFloats[1], rootFloats[2]);
+    const float        rootWidth = rootFloats[3];
+    const unsigned int numNodes = reader.varint ();
+
+    // every node takes at least two bytes, which bounds the node count of corrupt data
+    if (reader.failed () ||
+        std::all_of (rootFloats.begin (), rootFloats.end (),
+                     [](float f) { return std::isfinite (f); }) == false ||
+        rootWidth <= 0.0f || numNodes == 0 || numNodes > reader.remaining () / 2 ||
+        numNodes > Util::invalidIndex () >> 3)
+    {
+      return false;
+    }
+    this->nodes.reserve (numNodes);
+    this->root = this->makeNode (rootCenter, rootWidth, static_cast<int> (depth));
+    this->elementNodeMap.resize (numElements);
+
+    std::vector<unsigned int> pendingChildren;
+    if (this->readBinaryNode (reader, this->root, numElements, previousElement,
+                              pendingChildren) == false)
+    {
+      return false;
+    }
+
+    // children are read depth-first, i.e., in the order they are written
+    for (unsigned int i = 1; i < numNodes; i++)
+    {
+      if (pendingChildren.empty ())
+      {
+        return false;
+      }
+      const unsigned int parent = pendingChildren.back () >> 3;
+      const unsigned int childIndex = pendingChildren.back () & 7;
+      pendingChildren.pop_back ();
+
+      const glm::vec3    center = this->nodes[parent].childCenter (childIndex);
+      const float        width = this->nodes[parent].width * 0.5f;
+      const int          childDepth = this->nodes[parent].depth + 1;
+      const unsigned int child = this->makeNode (center, width, childDepth);
+
+      this->nodes.mutableAt (parent).children[childIndex] = child;
+
+      if (this->readBinaryNode (reader, child, numElements, previousElement,
+                                pendingChildren) == false)
+      {
+        return false;
+      }
+    }
+    return pendingChildren.empty () && reader.done () && this->numElements == numElements;
+  }
+
+  bool fromBinary (const QByteArray& data, unsigned int numElements)
+  {
+    this->reset ();
+
+    if (this->readBinary (data, numElements))
+    {
+      return true;
+    }
+    else
+    {
+      this->reset ();
+      return false;
+    }
   }
 };
 
-DELEGATE_BIG4_COPY (DynamicOctree)
+float DynamicOctree::Statistics::elementsPerNode () const
+{
+  return this->numNodes == 0 ? 0.0f : float(this->numElements) / float(this->numNodes);
+}
+
+float DynamicOctree::Statistics::emptyNodeRatio () const
+{
+  return this->numNodes == 0 ? 0.0f : float(this->numEmptyNodes) / float(this->numNodes);
+}
+
+DELEGATE_BIG6 (DynamicOctree)
 
 DELEGATE_CONST (bool, DynamicOctree, hasRoot)
+DELEGATE1_CONST (bool, DynamicOctree, hasElement, unsigned int)
 DELEGATE2 (void, DynamicOctree, setupRoot, const glm::vec3&, float)
 DELEGATE3 (void, DynamicOctree, addElement, unsigned int, const glm::vec3&, float)
+DELEGATE3 (void, DynamicOctree, addElements, const std::vector<unsigned int>&,
+           const std::vector<glm::vec3>&, const std::vector<float>&)
 DELEGATE3 (void, DynamicOctree, realignElement, unsigned int, const glm::vec3&, float)
 DELEGATE1 (void, DynamicOctree, deleteElement, unsigned int)
 DELEGATE (void, DynamicOctree, deleteEmptyChildren)
@@ -724,12 +1375,29 @@ DELEGATE (void, DynamicOctree, reset)
 DELEGATE1_CONST (void, DynamicOctree, render, Camera&)
 DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimRay&,
                  const DynamicOctree::RayIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicOctree, intersects, const std::vector<PrimRay>&,
+                 const DynamicOctree::RayPacketIntersectionCallback&)
 DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimPlane&,
                  const DynamicOctree::IntersectionCallback&)
 DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimSphere&,
                  const DynamicOctree::ContainsIntersectionCallback&)
 DELEGATE2_CONST (void, DynamicOctree, intersects, const PrimAABox&,
                  const DynamicOctree::ContainsIntersectionCallback&)
-DELEGATE2_CONST (float, DynamicOctree, distance, const glm::vec3&,
-                 const DynamicOctree::DistanceCallback&)
+DELEGATE3_CONST (float, DynamicOctree, distance, const glm::vec3&,
+                 const DynamicOctree::DistanceCallback&, unsigned int*)
+DELEGATE2_CONST (void, DynamicOctree, intersectsNodes, const PrimRay&,
+                 const DynamicOctree::NodeRayIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicOctree, intersectsNodes, const PrimPlane&,
+                 const DynamicOctree::NodeIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicOctree, intersectsNodes, const PrimSphere&,
+                 const DynamicOctree::NodeContainsIntersectionCallback&)
+DELEGATE2_CONST (void, DynamicOctree, intersectsNodes, const PrimAABox&,
+                 const DynamicOctree::NodeContainsIntersectionCallback&)
+DELEGATE3_CONST (float, DynamicOctree, distanceNodes, const glm::vec3&,
+                 const DynamicOctree::NodeDistanceCallback&, unsigned int*)
+DELEGATE_CONST (DynamicOctree::Statistics, DynamicOctree, statistics)
 DELEGATE_CONST (void, DynamicOctree, printStatistics)
+DELEGATE_CONST (std::size_t, DynamicOctree, memoryBytes)
+GETTER_CONST (unsigned int, DynamicOctree, numElements)
+DELEGATE1_CONST (QByteArray, DynamicOctree, toBinary, const std::vector<unsigned int>&)
+DELEGATE2 (bool, DynamicOctree, fromBinary, const QByteArray&, unsigned int)
@@ -5,12 +5,16 @@
 #ifndef DILAY_DYNAMIC_OCTREE
 #define DILAY_DYNAMIC_OCTREE
 
+#include <cstddef>
 #include <functional>
 #include <glm/fwd.hpp>
+#include <map>
 #include <vector>
+#include "dynamic/visitor.hpp"
 #include "macro.hpp"
 
 class Camera;
+class QByteArray;
 class PrimAABox;
 class PrimPlane;
 class PrimRay;
@@ -19,16 +23,46 @@ class PrimSphere;
 class DynamicOctree
 {
 public:
-  DECLARE_BIG4_EXPLICIT_COPY (DynamicOctree)
+  DECLARE_BIG6 (DynamicOctree)
 
-  typedef std::function<void(unsigned int)>       IntersectionCallback;
-  typedef std::function<float(unsigned int)>      RayIntersectionCallback;
-  typedef std::function<void(bool, unsigned int)> ContainsIntersectionCallback;
-  typedef std::function<float(unsigned int)>      DistanceCallback;
+  typedef std::function<void(unsigned int)>                IntersectionCallback;
+  typedef std::function<float(unsigned int)>               RayIntersectionCallback;
+  typedef std::function<float(unsigned int, unsigned int)> RayPacketIntersectionCallback;
+  typedef std::function<void(bool, unsigned int)>          ContainsIntersectionCallback;
+  typedef std::function<float(unsigned int)>               DistanceCallback;
+
+  struct Statistics
+  {
+    typedef std::map<int, unsigned int> DepthMap;
+
+    unsigned int numNodes;
+    unsigned int numEmptyNodes; // nodes without elements in their subtree
+    unsigned int numElements;
+    unsigned int maxElementsPerNode;
+    int          minDepth;
+    int          maxDepth;
+    float        rootWidth;
+    DepthMap     numElementsPerDepth;
+    DepthMap     numNodesPerDepth;
+    std::size_t  memoryBytes;
+
+    float elementsPerNode () const;
+    float emptyNodeRatio () const;
+  };
+
+  typedef std::function<void(const DynamicVisitor::Elements&)>  NodeIntersectionCallback;
+  typedef std::function<float(const DynamicVisitor::Elements&)> NodeRayIntersectionCallback;
+  typedef std::function<void(bool, const DynamicVisitor::Elements&)>
+    NodeContainsIntersectionCallback;
+  typedef std::function<void(const DynamicVisitor::Elements&, float&, unsigned int&)>
+    NodeDistanceCallback;
 
   bool  hasRoot () const;
+  bool  hasElement (unsigned int) const;
   void  setupRoot (const glm::vec3&, float);
   void  addElement (unsigned int, const glm::vec3&, float);
+  void  addElements (const std::vector<unsigned int>&, const std::vector<glm::vec3>&,
+                     const std::vector<float>&);
   void  realignElement (unsigned int, const glm::vec3&, float);
   void  deleteElement (unsigned int);
   void  deleteEmptyChildren ();
@@ -37,11 +71,57 @@ public:
   void  reset ();
   void  render (Camera&) const;
   void  intersects (const PrimRay&, const RayIntersectionCallback&) const;
+  void  intersects (const std::vector<PrimRay>&, const RayPacketIntersectionCallback&) const;
   void  intersects (const PrimPlane&, const IntersectionCallback&) const;
   void  intersects (const PrimSphere&, const ContainsIntersectionCallback&) const;
   void  intersects (const PrimAABox&, const ContainsIntersectionCallback&) const;
-  float distance (const glm::vec3&, const DistanceCallback&) const;
-  void  printStatistics () const;
+  float distance (const glm::vec3&, const DistanceCallback&, unsigned int* = nullptr) const;
+  void  intersectsNodes (const PrimRay&, const NodeRayIntersectionCallback&) const;
+  void  intersectsNodes (const PrimPlane&, const NodeIntersectionCallback&) const;
+  void  intersectsNodes (const PrimSphere&, const NodeContainsIntersectionCallback&) const;
+  void  intersectsNodes (const PrimAABox&, const NodeContainsIntersectionCallback&) const;
+  float distanceNodes (const glm::vec3&, const NodeDistanceCallback&,
+                       unsigned int* = nullptr) const;
+  Statistics   statistics () const;
+  void         printStatistics () const;
+  std::size_t  memoryBytes () const;
+  unsigned int numElements () const;
+
+  /* Compact binary layout (e.g. for serialization): nodes are stored in Morton order, i.e.,
+   * depth-first with children in index order, each with a mask of its children and its elements.
+   * Elements are renumbered by `indexMap`.
+   */
+  QByteArray toBinary (const std::vector<unsigned int>& indexMap) const;
+
+  // fails (and resets the octree) if the data is corrupt or does not hold elements `0` to `n-1`
+  // exactly once
+  bool fromBinary (const QByteArray&, unsigned int n);
+
+  template <typename F> void intersectsT (const PrimRay& ray, const F& f) const
+  {
+    this->intersectsNodes (ray, DynamicVisitor::rayIntersection (f));
+  }
+
+  template <typename F> void intersectsT (const PrimPlane& plane, const F& f) const
+  {
+    this->intersectsNodes (plane, DynamicVisitor::intersection (f));
+  }
+
+  template <typename F> void intersectsT (const PrimSphere& sphere, const F& f) const
+  {
+    this->intersectsNodes (sphere, DynamicVisitor::containsIntersection (f));
+  }
+
+  template <typename F> void intersectsT (const PrimAABox& box, const F& f) const
+  {
+    this->intersectsNodes (box, DynamicVisitor::containsIntersection (f));
+  }
+
+  template <typename F>
+  float distanceT (const glm::vec3& p, const F& f, unsigned int* closest = nullptr) const
+  {
+    return this->distanceNodes (p, DynamicVisitor::distance (f), closest);
+  }
 
 private:
   IMPLEMENTATION
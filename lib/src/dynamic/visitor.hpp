@@ -0,0 +1,69 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_DYNAMIC_VISITOR
+#define DILAY_DYNAMIC_VISITOR
+
+#include <vector>
+#include "util.hpp"
+
+/* Spatial indices (`DynamicOctree`, `DynamicBVH`) report the elements of a visited node at once.
+ * The adapters of this namespace lift per-element callbacks to such node callbacks, so that a
+ * per-element callback that is passed as template argument can be inlined into the loop over the
+ * elements of a node.
+ */
+namespace DynamicVisitor
+{
+  typedef std::vector<unsigned int> Elements;
+
+  template <typename F> auto intersection (const F& f)
+  {
+    return [&f](const Elements& elements) {
+      for (unsigned int e : elements)
+      {
+        f (e);
+      }
+    };
+  }
+
+  template <typename F> auto rayIntersection (const F& f)
+  {
+    return [&f](const Elements& elements) {
+      float distance = Util::maxFloat ();
+      for (unsigned int e : elements)
+      {
+        const float d = f (e);
+        distance = d < distance ? d : distance;
+      }
+      return distance;
+    };
+  }
+
+  template <typename F> auto containsIntersection (const F& f)
+  {
+    return [&f](bool contains, const Elements& elements) {
+      for (unsigned int e : elements)
+      {
+        f (contains, e);
+      }
+    };
+  }
+
+  template <typename F> auto distance (const F& f)
+  {
+    return [&f](const Elements& elements, float& distance, unsigned int& closest) {
+      for (unsigned int e : elements)
+      {
+        const float d = f (e);
+        if (d < distance)
+        {
+          distance = d;
+          closest = e;
+        }
+      }
+    };
+  }
+}
+
+#endif
@@ -2,20 +2,33 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <QByteArray>
+#include <QDataStream>
+#include <QDir>
+#include <QTemporaryFile>
+#include <algorithm>
+#include <chrono>
+#include <future>
 #include <list>
+#include <memory>
 #include <vector>
 #include "config.hpp"
+#include "dynamic/mesh-delta.hpp"
 #include "dynamic/mesh.hpp"
 #include "history.hpp"
 #include "maybe.hpp"
+#include "memory-usage.hpp"
 #include "mesh.hpp"
 #include "scene.hpp"
 #include "sketch/mesh.hpp"
 #include "sketch/path.hpp"
-#include "state.hpp"
+#include "util.hpp"
 
 namespace
 {
+  // cf. `finishRecording`
+  constexpr unsigned int maxCompactionMoves = 4096;
+
   struct SnapshotConfig
   {
     bool snapshotDynamicMeshes;
@@ -29,20 +42,80 @@ namespace
     }
   };
 
+  /* A snapshot either holds copies of the scene's meshes or, if `isDelta`, the changes of its
+   * dynamic meshes (in the order of the scene) since the snapshot has been taken.
+   * Deltas of snapshots that are not at the front of a timeline are compressed in the
+   * background, cf. `finishPending`. Compressed deltas of snapshots that are not within the
+   * in-memory window of a timeline are spilled to disk, cf. `spill`.
+   */
   struct SceneSnapshot
   {
-    const SnapshotConfig   config;
-    std::list<DynamicMesh> dynamicMeshes;
-    std::list<SketchMesh>  sketchMeshes;
+    const SnapshotConfig          config;
+    const bool                    isDelta;
+    std::list<DynamicMesh>        dynamicMeshes;
+    std::list<SketchMesh>         sketchMeshes;
+    std::vector<DynamicMeshDelta> deltas;
+    std::vector<QByteArray>       compressedDeltas;
+
+    std::unique_ptr<QTemporaryFile> spillFile;
+
+    /* Compressed deltas that are compressed from `deltas` or loaded from `spillFile` in the
+     * background. Reads both and must therefore be destroyed (i.e., waited for) before them.
+     */
+    std::future<std::vector<QByteArray>> pending;
+
+    // the spilled deltas could not be loaded, i.e., the snapshot cannot be restored anymore
+    bool isLost;
 
-    SceneSnapshot (const SnapshotConfig& c)
+    /* Sizes are cached by `cacheBytes` whenever the snapshot changes its form, so that eviction
+     * does not visit the meshes and files of all snapshots. Chunks that a snapshot shares with
+     * other meshes are accounted as they were shared at that time.
+     */
+    std::size_t memoryBytes;
+    std::size_t spilledBytes;
+
+    SceneSnapshot (const SnapshotConfig& c, bool d = false)
       : config (c)
+      , isDelta (d)
+      , isLost (false)
+      , memoryBytes (0)
+      , spilledBytes (0)
     {
+      assert (this->isDelta == false || this->config.snapshotSketchMeshes == false);
     }
   };
 
   typedef std::list<SceneSnapshot> Timeline;
 
+  MemoryUsage snapshotMemoryUsage (const SceneSnapshot& snapshot)
+  {
+    MemoryUsage usage;
+
+    for (const DynamicMesh& m : snapshot.dynamicMeshes)
+    {
+      usage.add (m.memoryUsage ());
+    }
+    for (const SketchMesh& m : snapshot.sketchMeshes)
+    {
+      usage.add (m.memoryUsage ());
+    }
+    for (const DynamicMeshDelta& d : snapshot.deltas)
+    {
+      usage.add ("deltas", d.memoryBytes ());
+    }
+    for (const QByteArray& d : snapshot.compressedDeltas)
+    {
+      usage.add ("compressed deltas", std::size_t (d.capacity ()));
+    }
+    return usage;
+  }
+
+  void cacheBytes (SceneSnapshot& snapshot)
+  {
+    snapshot.memoryBytes = snapshotMemoryUsage (snapshot).total ();
+    snapshot.spilledBytes = snapshot.spillFile ? std::size_t (snapshot.spillFile->size ()) : 0;
+  }
+
   SceneSnapshot sceneSnapshot (const Scene& scene, const SnapshotConfig& config)
   {
     SceneSnapshot snapshot (config);
@@ -57,12 +130,13 @@ namespace
       scene.forEachConstMesh (
         [&snapshot](const SketchMesh& mesh) { snapshot.sketchMeshes.emplace_back (mesh); });
     }
+    cacheBytes (snapshot);
     return snapshot;
   }
 
-  void resetToSnapshot (const SceneSnapshot& snapshot, State& state)
+  void resetToSnapshot (const SceneSnapshot& snapshot, const Config& config, Scene& scene)
   {
-    Scene& scene = state.scene ();
+    assert (snapshot.isDelta == false);
 
     if (snapshot.config.snapshotDynamicMeshes)
     {
@@ -70,7 +144,7 @@ namespace
 
       for (const DynamicMesh& mesh : snapshot.dynamicMeshes)
       {
-        scene.newDynamicMesh (state.config (), mesh);
+        scene.newDynamicMesh (config, mesh);
       }
     }
     if (snapshot.config.snapshotSketchMeshes)
@@ -79,19 +153,227 @@ namespace
 
       for (const SketchMesh& mesh : snapshot.sketchMeshes)
       {
-        scene.newSketchMesh (state.config (), mesh);
+        scene.newSketchMesh (config, mesh);
       }
     }
   }
+
+  /* Snapshots are not moved once they are in a timeline (splicing lists keeps their nodes), so
+   * the worker can read the deltas in place while they are left untouched until
+   * `finishPending`.
+   */
+  void compressDeltas (SceneSnapshot& snapshot)
+  {
+    if (snapshot.isDelta && snapshot.deltas.empty () == false &&
+        snapshot.pending.valid () == false)
+    {
+      const std::vector<DynamicMeshDelta>* deltas = &snapshot.deltas;
+
+      snapshot.pending = std::async (std::launch::async, [deltas]() {
+        std::vector<QByteArray> compressed;
+        for (const DynamicMeshDelta& d : *deltas)
+        {
+          compressed.push_back (d.compress ());
+        }
+        return compressed;
+      });
+    }
+  }
+
+  // writes the compressed deltas of `snapshot` to a temporary file and releases them
+  void spill (SceneSnapshot& snapshot)
+  {
+    if (snapshot.compressedDeltas.empty () || snapshot.pending.valid ())
+    {
+      return;
+    }
+    assert (snapshot.isDelta && snapshot.spillFile == nullptr);
+
+    std::unique_ptr<QTemporaryFile> file (
+      new QTemporaryFile (QDir::tempPath () + "/dilay-undo-XXXXXX"));
+
+    if (file->open () == false)
+    {
+      DILAY_WARN ("could not open temporary file for undo history");
+      return;
+    }
+    QDataStream stream (file.get ());
+    stream << quint32 (snapshot.compressedDeltas.size ());
+
+    for (const QByteArray& d : snapshot.compressedDeltas)
+    {
+      stream << d;
+    }
+    file->close ();
+
+    if (stream.status () != QDataStream::Ok || file->error () != QFile::NoError)
+    {
+      DILAY_WARN ("could not write undo history to '%s'",
+                  file->fileName ().toStdString ().c_str ());
+      return;
+    }
+    snapshot.spillFile = std::move (file);
+    std::vector<QByteArray> ().swap (snapshot.compressedDeltas);
+    cacheBytes (snapshot);
+  }
+
+  // starts loading the spilled deltas of `snapshot` in the background
+  void load (SceneSnapshot& snapshot)
+  {
+    if (snapshot.spillFile && snapshot.pending.valid () == false)
+    {
+      const QString fileName = snapshot.spillFile->fileName ();
+
+      snapshot.pending = std::async (std::launch::async, [fileName]() {
+        std::vector<QByteArray> compressed;
+        QFile                   file (fileName);
+
+        if (file.open (QIODevice::ReadOnly))
+        {
+          QDataStream stream (&file);
+          quint32     n = 0;
+
+          stream >> n;
+          for (quint32 i = 0; i < n && stream.status () == QDataStream::Ok; i++)
+          {
+            QByteArray d;
+            stream >> d;
+            compressed.push_back (std::move (d));
+          }
+          if (stream.status () != QDataStream::Ok)
+          {
+            compressed.clear ();
+          }
+        }
+        return compressed;
+      });
+    }
+  }
+
+  // waits for a pending compression or load
+  void finishPending (SceneSnapshot& snapshot)
+  {
+    if (snapshot.pending.valid ())
+    {
+      snapshot.compressedDeltas = snapshot.pending.get ();
+
+      // compressions start from non-empty deltas: only a failed load yields nothing
+      snapshot.isLost = snapshot.isLost || snapshot.compressedDeltas.empty ();
+      snapshot.spillFile.reset ();
+      std::vector<DynamicMeshDelta> ().swap (snapshot.deltas);
+      cacheBytes (snapshot);
+    }
+  }
+
+  // finishes compressions and loads that are done without waiting for the others
+  void finishDonePending (Timeline& timeline)
+  {
+    for (SceneSnapshot& snapshot : timeline)
+    {
+      if (snapshot.pending.valid () &&
+          snapshot.pending.wait_for (std::chrono::seconds (0)) == std::future_status::ready)
+      {
+        finishPending (snapshot);
+      }
+    }
+  }
+
+  // returns `false` if spilled deltas could not be loaded or compressed deltas are corrupt
+  bool decompressDeltas (SceneSnapshot& snapshot)
+  {
+    load (snapshot);
+    finishPending (snapshot);
+
+    if (snapshot.isLost)
+    {
+      return false;
+    }
+    if (snapshot.compressedDeltas.empty () == false)
+    {
+      assert (snapshot.isDelta && snapshot.deltas.empty ());
+
+      snapshot.deltas.resize (snapshot.compressedDeltas.size ());
+      for (unsigned int i = 0; i < snapshot.compressedDeltas.size (); i++)
+      {
+        if (DynamicMeshDelta::decompress (snapshot.compressedDeltas[i], snapshot.deltas[i]) ==
+            false)
+        {
+          snapshot.deltas.clear ();
+          return false;
+        }
+      }
+      std::vector<QByteArray> ().swap (snapshot.compressedDeltas);
+      cacheBytes (snapshot);
+    }
+    return true;
+  }
+
+  // compresses the snapshot behind the front of `timeline`
+  void compressSecond (Timeline& timeline)
+  {
+    if (timeline.size () > 1)
+    {
+      compressDeltas (*std::next (timeline.begin ()));
+    }
+  }
+
+  float millisecondsSince (const std::chrono::steady_clock::time_point& start)
+  {
+    const std::chrono::duration<float, std::milli> duration =
+      std::chrono::steady_clock::now () - start;
+    return duration.count ();
+  }
+
+  // turns the deltas of `snapshot` into their inverses, returns `false` if they are lost
+  bool applyDeltas (SceneSnapshot& snapshot, Scene& scene)
+  {
+    assert (snapshot.isDelta);
+
+    if (decompressDeltas (snapshot) == false ||
+        snapshot.deltas.size () != scene.numDynamicMeshes ())
+    {
+      DILAY_WARN ("could not restore undo history");
+      return false;
+    }
+
+    unsigned int i = 0;
+    scene.forEachMesh ([&snapshot, &i](DynamicMesh& mesh) {
+      DynamicMeshDelta& delta = snapshot.deltas[i++];
+
+      if (delta.isEmpty () == false)
+      {
+        mesh.applyDelta (delta);
+        mesh.sanitize ();
+        mesh.bufferData ();
+      }
+    });
+    cacheBytes (snapshot);
+    return true;
+  }
 }
 
 struct History::Impl
 {
-  unsigned int undoDepth;
+  std::size_t  undoMemory;
+  std::size_t  undoDisk;
+  unsigned int undoWindow;
   Timeline     past;
   Timeline     future;
 
-  Impl (const Config& config) { this->runFromConfig (config); }
+  // the changes of its dynamic meshes are recorded into the most recent snapshot
+  Scene* recordingScene;
+
+  // state of the recorded meshes before the recording, cf. `forEachRecentDynamicMesh`
+  mutable std::list<DynamicMesh> recordedDynamicMeshes;
+
+  float restoreMilliseconds;
+
+  Impl (const Config& config)
+    : recordingScene (nullptr)
+    , restoreMilliseconds (0.0f)
+  {
+    this->runFromConfig (config);
+  }
 
   void snapshotAll (const Scene& scene) { this->snapshot (scene, SnapshotConfig (true, true)); }
 
@@ -107,19 +389,174 @@ struct History::Impl
 
   void snapshot (const Scene& scene, const SnapshotConfig& config)
   {
-    assert (undoDepth > 0);
+    this->finishRecording ();
+    this->push (sceneSnapshot (scene, config));
+    this->evict ();
+  }
 
+  // does not evict snapshots, i.e., takes time independent of the size of the history
+  void push (SceneSnapshot&& snapshot)
+  {
     this->future.clear ();
+    this->past.push_front (std::move (snapshot));
+
+    compressSecond (this->past);
+  }
+
+  std::size_t memoryBytes () const
+  {
+    std::size_t bytes = 0;
+    for (const Timeline* timeline : {&this->past, &this->future})
+    {
+      for (const SceneSnapshot& snapshot : *timeline)
+      {
+        bytes += snapshot.memoryBytes;
+      }
+    }
+    return bytes;
+  }
+
+  std::size_t spilledBytes () const
+  {
+    std::size_t bytes = 0;
+    for (const Timeline* timeline : {&this->past, &this->future})
+    {
+      for (const SceneSnapshot& snapshot : *timeline)
+      {
+        bytes += snapshot.spilledBytes;
+      }
+    }
+    return bytes;
+  }
+
+  /* Spills snapshots behind the first `undoWindow` snapshots of each timeline to disk and starts
+   * loading spilled snapshots within the window, i.e., the snapshots that the next undo or redo
+   * steps need are prefetched.
+   */
+  void spillOrPrefetch (Timeline& timeline)
+  {
+    unsigned int i = 0;
+    for (SceneSnapshot& snapshot : timeline)
+    {
+      if (i++ < this->undoWindow)
+      {
+        load (snapshot);
+      }
+      else if (this->undoDisk > 0)
+      {
+        spill (snapshot);
+      }
+    }
+  }
+
+  /* Drops the oldest snapshots and then the most distant future snapshots until the history fits
+   * into `undoMemory` and `undoDisk`. The most recent snapshot is always kept.
+   */
+  void evict ()
+  {
+    finishDonePending (this->past);
+    finishDonePending (this->future);
+    this->spillOrPrefetch (this->past);
+    this->spillOrPrefetch (this->future);
+
+    std::size_t bytes = this->memoryBytes ();
+    std::size_t spilled = this->spilledBytes ();
+
+    const auto exceeds = [this, &bytes, &spilled]() {
+      return bytes > this->undoMemory || spilled > this->undoDisk;
+    };
+    const auto drop = [&bytes, &spilled](Timeline& timeline) {
+      bytes -= std::min (bytes, timeline.back ().memoryBytes);
+      spilled -= std::min (spilled, timeline.back ().spilledBytes);
+      timeline.pop_back ();
+    };
+
+    while (exceeds () && this->past.size () > 1)
+    {
+      drop (this->past);
+    }
+    while (exceeds () && this->future.empty () == false)
+    {
+      drop (this->future);
+    }
+  }
+
+  void recordDynamicMeshes (Scene& scene)
+  {
+    this->finishRecording ();
+    this->push (SceneSnapshot (SnapshotConfig (true, false), true));
+
+    scene.forEachMesh ([](DynamicMesh& mesh) { mesh.startRecording (); });
+    this->recordingScene = &scene;
+  }
+
+  std::vector<DynamicMeshDelta> stopRecording ()
+  {
+    assert (this->recordingScene);
+
+    std::vector<DynamicMeshDelta> deltas;
+    this->recordingScene->forEachMesh (
+      [&deltas](DynamicMesh& mesh) { deltas.push_back (mesh.stopRecording ()); });
+
+    this->recordingScene = nullptr;
+    this->recordedDynamicMeshes.clear ();
+    return deltas;
+  }
+
+  /* Sparse meshes are compacted before a recording stops: compacting moves at most
+   * `maxCompactionMoves` vertices and faces per mesh, which are recorded like the modifications of
+   * the stroke. A very sparse mesh is therefore compacted over several strokes, but without pausing
+   * for a full prune (about 10 ms instead of 170 ms for a mesh of 1.3M slots and 500K free faces).
+   * The recorded deltas of emptied meshes, which are deleted from the scene afterwards, are
+   * replaced by copies of the recorded meshes.
+   */
+  void finishRecording ()
+  {
+    if (this->recordingScene == nullptr)
+    {
+      return;
+    }
+    Scene& scene = *this->recordingScene;
+
+    scene.forEachMesh ([](DynamicMesh& mesh) {
+      if (mesh.isSparse () && mesh.isEmpty () == false)
+      {
+        mesh.compact (maxCompactionMoves);
+        mesh.bufferData ();
+      }
+    });
+
+    assert (this->past.empty () == false && this->past.front ().isDelta);
+    this->past.front ().deltas = this->stopRecording ();
+    cacheBytes (this->past.front ());
+
+    bool isEmpty = false;
+    scene.forEachConstMesh (
+      [&isEmpty](const DynamicMesh& mesh) { isEmpty = isEmpty || mesh.isEmpty (); });
 
-    while (this->past.size () >= this->undoDepth)
+    if (isEmpty)
     {
-      this->past.pop_back ();
+      SceneSnapshot  snapshot (this->past.front ().config);
+      SceneSnapshot& recorded = this->past.front ();
+      unsigned int   i = 0;
+
+      scene.forEachConstMesh ([&snapshot, &recorded, &i](const DynamicMesh& mesh) {
+        snapshot.dynamicMeshes.emplace_back (mesh);
+        snapshot.dynamicMeshes.back ().applyDelta (recorded.deltas[i++]);
+      });
+      cacheBytes (snapshot);
+      this->past.pop_front ();
+      this->past.push_front (std::move (snapshot));
     }
-    this->past.push_front (sceneSnapshot (scene, config));
+    this->evict ();
   }
 
   void dropPastSnapshot ()
   {
+    if (this->recordingScene)
+    {
+      this->stopRecording ();
+    }
     if (this->past.empty () == false)
     {
       this->past.pop_front ();
@@ -134,54 +571,136 @@ struct History::Impl
     }
   }
 
-  void undo (State& state)
+  void undo (const Config& config, Scene& scene)
   {
-    if (this->past.empty () == false)
+    const auto start = std::chrono::steady_clock::now ();
+    this->finishRecording ();
+
+    if (this->past.empty () == false && this->past.front ().isDelta)
     {
-      const SnapshotConfig& config = this->past.front ().config;
+      if (applyDeltas (this->past.front (), scene))
+      {
+        this->future.splice (this->future.begin (), this->past, this->past.begin ());
+      }
+      else
+      {
+        this->past.clear ();
+      }
+    }
+    else if (this->past.empty () == false)
+    {
+      const SnapshotConfig& snapshotConfig = this->past.front ().config;
 
-      this->future.push_front (sceneSnapshot (state.scene (), config));
-      resetToSnapshot (this->past.front (), state);
+      this->future.push_front (sceneSnapshot (scene, snapshotConfig));
+      resetToSnapshot (this->past.front (), config, scene);
       this->past.pop_front ();
     }
+    compressSecond (this->future);
+    this->evict ();
+    this->restoreMilliseconds = millisecondsSince (start);
   }
 
-  void redo (State& state)
+  void redo (const Config& config, Scene& scene)
   {
-    if (this->future.empty () == false)
+    const auto start = std::chrono::steady_clock::now ();
+    this->finishRecording ();
+
+    if (this->future.empty () == false && this->future.front ().isDelta)
+    {
+      if (applyDeltas (this->future.front (), scene))
+      {
+        this->past.splice (this->past.begin (), this->future, this->future.begin ());
+      }
+      else
+      {
+        this->future.clear ();
+      }
+    }
+    else if (this->future.empty () == false)
     {
-      const SnapshotConfig& config = this->future.front ().config;
+      const SnapshotConfig& snapshotConfig = this->future.front ().config;
 
-      this->past.push_front (sceneSnapshot (state.scene (), config));
-      resetToSnapshot (this->future.front (), state);
+      this->past.push_front (sceneSnapshot (scene, snapshotConfig));
+      resetToSnapshot (this->future.front (), config, scene);
       this->future.pop_front ();
     }
+    compressSecond (this->past);
+    this->evict ();
+    this->restoreMilliseconds = millisecondsSince (start);
   }
 
   bool hasRecentDynamicMesh () const
   {
-    return this->past.empty () == false && this->past.front ().config.snapshotDynamicMeshes;
+    return this->past.empty () == false && this->past.front ().config.snapshotDynamicMeshes &&
+           (this->past.front ().isDelta == false || this->recordingScene);
   }
 
+  // the recorded meshes are reconstructed on demand by reverting their changes
   void forEachRecentDynamicMesh (const std::function<void(const DynamicMesh&)>& f) const
   {
     assert (this->hasRecentDynamicMesh ());
 
-    for (const DynamicMesh& m : this->past.front ().dynamicMeshes)
+    if (this->past.front ().isDelta)
+    {
+      if (this->recordedDynamicMeshes.empty ())
+      {
+        this->recordingScene->forEachConstMesh ([this](const DynamicMesh& mesh) {
+          this->recordedDynamicMeshes.emplace_back (mesh);
+
+          DynamicMeshDelta delta = this->recordedDynamicMeshes.back ().stopRecording ();
+          this->recordedDynamicMeshes.back ().applyDelta (delta);
+        });
+      }
+      for (const DynamicMesh& m : this->recordedDynamicMeshes)
+      {
+        f (m);
+      }
+    }
+    else
+    {
+      for (const DynamicMesh& m : this->past.front ().dynamicMeshes)
+      {
+        f (m);
+      }
+    }
+  }
+
+  unsigned int numSnapshots () const { return this->past.size () + this->future.size (); }
+
+  MemoryUsage memoryUsage () const
+  {
+    MemoryUsage usage;
+
+    for (const Timeline* timeline : {&this->past, &this->future})
     {
-      f (m);
+      for (const SceneSnapshot& snapshot : *timeline)
+      {
+        usage.add (snapshotMemoryUsage (snapshot));
+      }
+    }
+    for (const DynamicMesh& m : this->recordedDynamicMeshes)
+    {
+      usage.add (m.memoryUsage ());
     }
+    return usage;
   }
 
   void reset ()
   {
+    if (this->recordingScene)
+    {
+      this->stopRecording ();
+    }
     this->past.clear ();
     this->future.clear ();
   }
 
   void runFromConfig (const Config& config)
   {
-    this->undoDepth = config.get<int> ("editor/undo-depth");
+    this->undoMemory = std::size_t (config.get<int> ("editor/undo-memory")) * 1024 * 1024;
+    this->undoDisk = std::size_t (config.get<int> ("editor/undo-disk")) * 1024 * 1024;
+    this->undoWindow = std::max (1, config.get<int> ("editor/undo-window"));
+    this->evict ();
   }
 };
 
@@ -189,12 +708,18 @@ DELEGATE1_BIG3 (History, const Config&)
 DELEGATE1 (void, History, snapshotAll, const Scene&)
 DELEGATE1 (void, History, snapshotDynamicMeshes, const Scene&)
 DELEGATE1 (void, History, snapshotSketchMeshes, const Scene&)
+DELEGATE1 (void, History, recordDynamicMeshes, Scene&)
+DELEGATE (void, History, finishRecording)
 DELEGATE (void, History, dropPastSnapshot)
 DELEGATE (void, History, dropFutureSnapshot)
-DELEGATE1 (void, History, undo, State&)
-DELEGATE1 (void, History, redo, State&)
+DELEGATE2 (void, History, undo, const Config&, Scene&)
+DELEGATE2 (void, History, redo, const Config&, Scene&)
 DELEGATE_CONST (bool, History, hasRecentDynamicMesh)
 DELEGATE1_CONST (void, History, forEachRecentDynamicMesh,
                  const std::function<void(const DynamicMesh&)>&)
+DELEGATE_CONST (unsigned int, History, numSnapshots)
+DELEGATE_CONST (std::size_t, History, spilledBytes)
+GETTER_CONST (float, History, restoreMilliseconds)
+DELEGATE_CONST (MemoryUsage, History, memoryUsage)
 DELEGATE (void, History, reset)
 DELEGATE1 (void, History, runFromConfig, const Config&)
@@ -5,13 +5,14 @@
 #ifndef DILAY_HISTORY
 #define DILAY_HISTORY
 
+#include <cstddef>
 #include <functional>
 #include "configurable.hpp"
 #include "macro.hpp"
 
 class DynamicMesh;
+class MemoryUsage;
 class Scene;
-class State;
 
 class History : public Configurable
 {
@@ -21,14 +22,24 @@ public:
   void snapshotAll (const Scene&);
   void snapshotDynamicMeshes (const Scene&);
   void snapshotSketchMeshes (const Scene&);
+
+  // records the changes of dynamic meshes (instead of copying them) until `finishRecording`
+  void recordDynamicMeshes (Scene&);
+  void finishRecording ();
+
   void dropPastSnapshot ();
   void dropFutureSnapshot ();
-  void undo (State&);
-  void redo (State&);
+  void undo (const Config&, Scene&);
+  void redo (const Config&, Scene&);
   bool hasRecentDynamicMesh () const;
   void forEachRecentDynamicMesh (const std::function<void(const DynamicMesh&)>&) const;
   void reset ();
 
+  unsigned int numSnapshots () const;
+  std::size_t  spilledBytes () const; // bytes of snapshots that have been spilled to disk
+  float        restoreMilliseconds () const; // duration of the most recent undo or redo
+  MemoryUsage  memoryUsage () const;
+
 private:
   IMPLEMENTATION
 
@@ -2,10 +2,13 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <QByteArray>
 #include <algorithm>
 #include <fstream>
+#include <functional>
 #include <sstream>
 #include "dynamic/mesh.hpp"
+#include "dynamic/octree.hpp"
 #include "import-export.hpp"
 #include "mesh-util.hpp"
 #include "mesh.hpp"
@@ -23,23 +26,70 @@ namespace
     return os;
   }
 
+  constexpr int octreeCompressionLevel = 6;
+
   std::istream& operator>> (std::istream& is, glm::vec3& v)
   {
     is >> v.x >> v.y >> v.z;
     return is;
   }
 
-  void toDlyFile (std::ostream& stream, const Mesh& mesh)
+  // maps the indices of non-free elements to consecutive indices, preserving their order
+  std::vector<unsigned int> liveIndexMap (unsigned int                             numSlots,
+                                          const std::function<bool(unsigned int)>& isFree)
+  {
+    std::vector<unsigned int> indexMap (numSlots, Util::invalidIndex ());
+    unsigned int              numLive = 0;
+
+    for (unsigned int i = 0; i < numSlots; i++)
+    {
+      if (isFree (i) == false)
+      {
+        indexMap[i] = numLive++;
+      }
+    }
+    return indexMap;
+  }
+
+  /* Free vertices and faces are skipped and the remaining ones are renumbered on the fly, i.e.,
+   * the mesh is written as if it was pruned without modifying it.
+   */
+  void toDlyFile (std::ostream& stream, const DynamicMesh& dynMesh,
+                  const std::vector<unsigned int>& vertexIndexMap)
   {
+    const Mesh& mesh = dynMesh.mesh ();
+
     stream << "o\n";
     for (unsigned int i = 0; i < mesh.numVertices (); i++)
     {
-      stream << "v " << mesh.vertex (i) << std::endl;
+      if (vertexIndexMap[i] != Util::invalidIndex ())
+      {
+        stream << "v " << mesh.vertex (i) << std::endl;
+      }
     }
     for (unsigned int i = 0; i < mesh.numIndices (); i += 3)
     {
-      stream << "f " << mesh.index (i + 0) + 1 << " " << mesh.index (i + 1) + 1 << " "
-             << mesh.index (i + 2) + 1 << std::endl;
+      if (dynMesh.isFreeFace (i / 3) == false)
+      {
+        stream << "f " << vertexIndexMap[mesh.index (i + 0)] + 1 << " "
+               << vertexIndexMap[mesh.index (i + 1)] + 1 << " "
+               << vertexIndexMap[mesh.index (i + 2)] + 1 << std::endl;
+      }
+    }
+  }
+
+  /* The octree of a mesh is stored as a single line holding its compressed binary layout (see
+   * `DynamicOctree::toBinary`) in base 64, so that readers that do not know the keyword skip it.
+   * The checksum of the compression detects corrupt data.
+   */
+  void toDlyFile (std::ostream& stream, const DynamicOctree& octree,
+                  const std::vector<unsigned int>& faceIndexMap)
+  {
+    if (octree.hasRoot ())
+    {
+      const QByteArray data = qCompress (octree.toBinary (faceIndexMap), octreeCompressionLevel);
+
+      stream << "dly_octree " << data.toBase64 ().constData () << std::endl;
     }
   }
 
@@ -95,9 +145,18 @@ namespace ImportExport
 {
   void toDlyFile (std::ostream& stream, Scene& scene, bool isObjFile)
   {
-    scene.forEachMesh ([&stream](DynamicMesh& mesh) {
-      mesh.prune ();
-      ::toDlyFile (stream, mesh.mesh ());
+    scene.forEachConstMesh ([&stream, isObjFile](const DynamicMesh& mesh) {
+      const std::vector<unsigned int> vertexIndexMap = liveIndexMap (
+        mesh.mesh ().numVertices (), [&mesh](unsigned int i) { return mesh.isFreeVertex (i); });
+      ::toDlyFile (stream, mesh, vertexIndexMap);
+
+      if (isObjFile == false)
+      {
+        const std::vector<unsigned int> faceIndexMap =
+          liveIndexMap (mesh.mesh ().numIndices () / 3,
+                        [&mesh](unsigned int i) { return mesh.isFreeFace (i); });
+        ::toDlyFile (stream, mesh.octree (), faceIndexMap);
+      }
     });
 
     if (isObjFile == false)
@@ -128,6 +187,7 @@ namespace ImportExport
     std::istringstream lineStream;
 
     std::vector<Mesh>        meshes;
+    std::vector<QByteArray>  octrees;
     std::vector<SketchNode*> nodes;
     SketchMesh*              sketch = nullptr;
     SketchPath*              sketchPath = nullptr;
@@ -229,6 +289,24 @@ namespace ImportExport
             }
           }
         }
+        else if (keyword == "dly_octree")
+        {
+          if (meshes.empty ())
+          {
+            DILAY_WARN ("could not parse octree: no mesh found at line %u", lineNumber)
+            return false;
+          }
+          std::string encoded;
+          lineStream >> encoded;
+
+          if (lineStream.fail ())
+          {
+            DILAY_WARN ("could not parse octree at line %u", lineNumber)
+            return false;
+          }
+          octrees.resize (meshes.size ());
+          octrees.back () = QByteArray::fromBase64 (QByteArray::fromStdString (encoded));
+        }
         else if (keyword == "dly_sketch_mesh")
         {
           nodes.clear ();
@@ -328,16 +406,41 @@ namespace ImportExport
         }
       }
     }
-    meshes.erase (std::remove_if (meshes.begin (), meshes.end (),
-                                  [](Mesh& m) { return m.numVertices () == 0; }),
-                  meshes.end ());
+    octrees.resize (meshes.size ());
+
+    for (unsigned int i = 0; i < meshes.size ();)
+    {
+      if (meshes[i].numVertices () == 0)
+      {
+        meshes.erase (meshes.begin () + i);
+        octrees.erase (octrees.begin () + i);
+      }
+      else
+      {
+        i++;
+      }
+    }
 
     if (std::all_of (meshes.begin (), meshes.end (),
                      [](Mesh& m) { return MeshUtil::checkConsistency (m); }))
     {
-      for (Mesh& m : meshes)
+      for (unsigned int i = 0; i < meshes.size (); i++)
       {
-        scene.newDynamicMesh (config, m);
+        DynamicOctree octree;
+
+        if (octrees[i].size () == 0)
+        {
+          scene.newDynamicMesh (config, meshes[i]);
+        }
+        else if (octree.fromBinary (qUncompress (octrees[i]), meshes[i].numIndices () / 3))
+        {
+          scene.newDynamicMesh (config, meshes[i], octree);
+        }
+        else
+        {
+          DILAY_INFO ("stale octree of mesh %u: rebuilding", i)
+          scene.newDynamicMesh (config, meshes[i]);
+        }
       }
       return true;
     }
@@ -32,8 +32,9 @@
  */
 namespace
 {
-  typedef IsosurfaceExtraction::DistanceCallback     DistanceCallback;
-  typedef IsosurfaceExtraction::IntersectionCallback IntersectionCallback;
+  typedef IsosurfaceExtraction::DistanceCallback           DistanceCallback;
+  typedef IsosurfaceExtraction::IntersectionCallback       IntersectionCallback;
+  typedef IsosurfaceExtraction::IntersectionPacketCallback IntersectionPacketCallback;
 
   static const glm::vec3 invalidVec3 = glm::vec3 (Util::minFloat ());
   static const float     markInside = -0.5f;
@@ -436,17 +437,17 @@ namespace
 
   struct Parameters
   {
-    const DistanceCallback&     getDistance;
-    const IntersectionCallback* getIntersection;
-    const float                 resolution;
-    glm::vec3                   sampleOrigin;
-    glm::uvec3                  numSamples;
-    std::vector<float>          samples;
-    glm::uvec3                  numCubes;
-    std::vector<Cube>           grid;
-
-    Parameters (const DistanceCallback& d, const IntersectionCallback* i, const PrimAABox& bounds,
-                float r)
+    const DistanceCallback&           getDistance;
+    const IntersectionPacketCallback* getIntersection;
+    const float                       resolution;
+    glm::vec3                         sampleOrigin;
+    glm::uvec3                        numSamples;
+    std::vector<float>                samples;
+    glm::uvec3                        numCubes;
+    std::vector<Cube>                 grid;
+
+    Parameters (const DistanceCallback& d, const IntersectionPacketCallback* i,
+                const PrimAABox& bounds, float r)
       : getDistance (d)
       , getIntersection (i)
       , resolution (r)
@@ -596,63 +597,113 @@ namespace
     }
   }
 
+  /* Columns of samples are intersected in packets of `rayPacketWidth` x `rayPacketWidth`
+   * neighbouring columns, so that the rays of a packet are coherent.
+   */
+  static const unsigned int rayPacketWidth = 4;
+
+  struct SampleColumn
+  {
+    unsigned int x;
+    unsigned int y;
+    unsigned int z;
+    bool         inside;
+    glm::vec3    origin;
+  };
+
+  void finishSampleColumn (Parameters& params, SampleColumn& column)
+  {
+    assert (column.z < params.numSamples.z - 1);
+    for (; column.z < params.numSamples.z; column.z++)
+    {
+      const unsigned int index = params.sampleIndex (column.x, column.y, column.z);
+
+      assert (params.samples.at (index) == Util::maxFloat ());
+      params.samples.at (index) = markOutside;
+    }
+  }
+
   void sampleIntersectionsThread (Parameters& params, unsigned int numThreads,
                                   unsigned int threadId)
   {
     assert (params.getIntersection);
 
-    for (unsigned int y = 0; y < params.numSamples.y; y++)
+    const glm::vec3    dir (0.0f, 0.0f, 1.0f);
+    const unsigned int numPacketsX = (params.numSamples.x + rayPacketWidth - 1) / rayPacketWidth;
+    const unsigned int numPacketsY = (params.numSamples.y + rayPacketWidth - 1) / rayPacketWidth;
+
+    std::vector<SampleColumn>                       columns;
+    std::vector<PrimRay>                            rays;
+    std::vector<Intersection>                       intersections;
+    std::vector<IsosurfaceExtraction::Intersection> results;
+
+    for (unsigned int packet = 0; packet < numPacketsX * numPacketsY; packet++)
     {
-      for (unsigned int x = 0; x < params.numSamples.x; x++)
+      if (packet % numThreads != threadId)
       {
-        if (params.sampleIndex (x, y, 0) % numThreads == threadId)
+        continue;
+      }
+      const unsigned int minX = (packet % numPacketsX) * rayPacketWidth;
+      const unsigned int minY = (packet / numPacketsX) * rayPacketWidth;
+      const unsigned int maxX = glm::min (minX + rayPacketWidth, params.numSamples.x);
+      const unsigned int maxY = glm::min (minY + rayPacketWidth, params.numSamples.y);
+
+      columns.clear ();
+      for (unsigned int y = minY; y < maxY; y++)
+      {
+        for (unsigned int x = minX; x < maxX; x++)
         {
-          const glm::vec3 dir (0.0f, 0.0f, 1.0f);
-          bool            inside = false;
-          unsigned int    z = 0;
-          Intersection    intersection;
-          PrimRay         ray (params.samplePos (x, y, 0.0f) - (dir * Util::epsilon ()), dir);
+          columns.push_back (
+            SampleColumn{x, y, 0, false, params.samplePos (x, y, 0) - (dir * Util::epsilon ())});
+        }
+      }
 
-          while (true)
-          {
-            intersection.reset ();
-            IsosurfaceExtraction::Intersection i = (*params.getIntersection) (ray, intersection);
+      while (columns.empty () == false)
+      {
+        rays.clear ();
+        for (const SampleColumn& column : columns)
+        {
+          rays.emplace_back (column.origin, dir);
+        }
+        intersections.assign (columns.size (), Intersection ());
+        results.assign (columns.size (), IsosurfaceExtraction::Intersection::None);
 
-            if (i == IsosurfaceExtraction::Intersection::None)
-            {
-              break;
-            }
-            else
-            {
-              const float d2 = intersection.distance () * intersection.distance ();
+        (*params.getIntersection) (rays, intersections, results);
 
-              while (glm::distance2 (params.samplePos (x, y, z), ray.origin ()) < d2)
-              {
-                const unsigned int index = params.sampleIndex (x, y, z);
+        unsigned int numActive = 0;
+        for (unsigned int i = 0; i < columns.size (); i++)
+        {
+          SampleColumn& column = columns[i];
 
-                assert (params.samples.at (index) == Util::maxFloat ());
-                params.samples.at (index) = inside ? markInside : markOutside;
+          if (results[i] == IsosurfaceExtraction::Intersection::None)
+          {
+            finishSampleColumn (params, column);
+          }
+          else
+          {
+            const Intersection& intersection = intersections[i];
+            const float         d2 = intersection.distance () * intersection.distance ();
 
-                z++;
-              }
-              ray.origin (intersection.position () + (dir * Util::epsilon ()));
+            while (glm::distance2 (params.samplePos (column.x, column.y, column.z),
+                                   column.origin) < d2)
+            {
+              const unsigned int index = params.sampleIndex (column.x, column.y, column.z);
 
-              if (i == IsosurfaceExtraction::Intersection::Sample)
-              {
-                inside = not inside;
-              }
-            }
-          }
+              assert (params.samples.at (index) == Util::maxFloat ());
+              params.samples.at (index) = column.inside ? markInside : markOutside;
 
-          assert (z < params.numSamples.z - 1);
-          for (; z < params.numSamples.z; z++)
-          {
-            const unsigned int index = params.sampleIndex (x, y, z);
+              column.z++;
+            }
+            column.origin = intersection.position () + (dir * Util::epsilon ());
 
-            assert (params.samples.at (index) == Util::maxFloat ());
-            params.samples.at (index) = markOutside;
+            if (results[i] == IsosurfaceExtraction::Intersection::Sample)
+            {
+              column.inside = not column.inside;
+            }
+            columns[numActive++] = column;
           }
         }
+        columns.erase (columns.begin () + numActive, columns.end ());
       }
     }
   }
@@ -1089,7 +1140,22 @@ Mesh IsosurfaceExtraction::extract (const DistanceCallback&     getDistance,
                                     const IntersectionCallback& getIntersection,
                                     const PrimAABox& bounds, float resolution)
 {
-  Parameters params (getDistance, &getIntersection, bounds, resolution);
+  const IntersectionPacketCallback getIntersections =
+    [&getIntersection](const std::vector<PrimRay>& rays, std::vector<::Intersection>& intersections,
+                       std::vector<Intersection>& results) {
+      for (unsigned int i = 0; i < rays.size (); i++)
+      {
+        results[i] = getIntersection (rays[i], intersections[i]);
+      }
+    };
+  return IsosurfaceExtraction::extract (getDistance, getIntersections, bounds, resolution);
+}
+
+Mesh IsosurfaceExtraction::extract (const DistanceCallback&           getDistance,
+                                    const IntersectionPacketCallback& getIntersections,
+                                    const PrimAABox& bounds, float resolution)
+{
+  Parameters params (getDistance, &getIntersections, bounds, resolution);
 
   if (params.numSamples.x > 0 && params.numSamples.y > 0 && params.numSamples.z > 0)
   {
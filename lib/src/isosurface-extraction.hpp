@@ -7,6 +7,7 @@
 
 #include <functional>
 #include <glm/fwd.hpp>
+#include <vector>
 
 class Intersection;
 class Mesh;
@@ -24,9 +25,14 @@ namespace IsosurfaceExtraction
 
   typedef std::function<float(const glm::vec3&)>                        DistanceCallback;
   typedef std::function<Intersection (const PrimRay&, ::Intersection&)> IntersectionCallback;
+  typedef std::function<void(const std::vector<PrimRay>&, std::vector<::Intersection>&,
+                             std::vector<Intersection>&)>
+    IntersectionPacketCallback;
 
   Mesh extract (const DistanceCallback&, const PrimAABox&, float);
   Mesh extract (const DistanceCallback&, const IntersectionCallback&, const PrimAABox&, float);
+  Mesh extract (const DistanceCallback&, const IntersectionPacketCallback&, const PrimAABox&,
+                float);
 };
 
 #endif
@@ -0,0 +1,58 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <iomanip>
+#include <sstream>
+#include "memory-usage.hpp"
+
+void MemoryUsage::add (const std::string& name, std::size_t bytes)
+{
+  for (Part& part : this->_parts)
+  {
+    if (part.name == name)
+    {
+      part.bytes += bytes;
+      return;
+    }
+  }
+  this->_parts.push_back (Part{name, bytes});
+}
+
+void MemoryUsage::add (const MemoryUsage& other)
+{
+  for (const Part& part : other._parts)
+  {
+    this->add (part.name, part.bytes);
+  }
+}
+
+std::size_t MemoryUsage::total () const
+{
+  std::size_t total = 0;
+  for (const Part& part : this->_parts)
+  {
+    total += part.bytes;
+  }
+  return total;
+}
+
+std::string MemoryUsage::toString (std::size_t bytes)
+{
+  std::stringstream stream;
+
+  if (bytes < 1024)
+  {
+    stream << bytes << " B";
+  }
+  else if (bytes < 1024 * 1024)
+  {
+    stream << std::fixed << std::setprecision (1) << (double(bytes) / 1024.0) << " KiB";
+  }
+  else
+  {
+    stream << std::fixed << std::setprecision (1) << (double(bytes) / (1024.0 * 1024.0))
+           << " MiB";
+  }
+  return stream.str ();
+}
@@ -0,0 +1,38 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_MEMORY_USAGE
+#define DILAY_MEMORY_USAGE
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/* Bytes held by an object, broken down into named parts.
+ * Storage that is shared between copies (cf. `CowVector`) is split evenly between the copies, so
+ * that the memory usages of several objects add up.
+ */
+class MemoryUsage
+{
+public:
+  struct Part
+  {
+    std::string name;
+    std::size_t bytes;
+  };
+
+  const std::vector<Part>& parts () const { return this->_parts; }
+
+  // adds to the part of the same name if it exists
+  void        add (const std::string&, std::size_t);
+  void        add (const MemoryUsage&);
+  std::size_t total () const;
+
+  static std::string toString (std::size_t);
+
+private:
+  std::vector<Part> _parts;
+};
+
+#endif
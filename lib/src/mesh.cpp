@@ -8,6 +8,9 @@
 #include <vector>
 #include "camera.hpp"
 #include "color.hpp"
+#include "cow-vector.hpp"
+#include "dirty-pages.hpp"
+#include "memory-usage.hpp"
 #include "mesh.hpp"
 #include "opengl-buffer-id.hpp"
 #include "opengl.hpp"
@@ -19,60 +22,69 @@ namespace
 {
   static_assert (sizeof (glm::vec3) == 3 * sizeof (float), "Unexpected memory layout");
 
+  Mesh::UploadStatistics currentUploadStatistics = {0, 0};
+  Mesh::UploadStatistics lastUploadStatistics = {0, 0};
+
+  void countUpload (unsigned int size)
+  {
+    currentUploadStatistics.numUploads++;
+    currentUploadStatistics.numBytes += size;
+  }
+
+  /* Changes are tracked per page (see `DirtyPages`) and uploaded by `upload`: adjacent dirty pages
+   * are uploaded with a single call per chunk of `data`, so that scattered changes do not upload
+   * everything in between. Copies share the chunks of `data` until they are modified.
+   */
   template <typename T> struct BufferedData
   {
-    OpenGLBufferId id;
-    std::vector<T> data;
-    unsigned int   dataLowerBound;
-    unsigned int   dataUpperBound;
-    unsigned int   bufferSize;
+    static constexpr unsigned int chunkSize = CowVector<T>::elementsPerChunk * sizeof (T);
+
+    // cf. `upload`
+    mutable OpenGLBufferId id;
+    mutable DirtyPages     dirtyPages;
+    mutable unsigned int   bufferSize;
+    CowVector<T>           data;
 
     BufferedData () { this->reset (); }
 
     void reset ()
     {
       this->id.reset ();
-      this->data.clear ();
-      this->resetBounds ();
+      this->dirtyPages.clear ();
       this->bufferSize = 0;
+      this->data.clear ();
     }
 
-    void resetBounds ()
+    unsigned int numElements () const { return this->data.size (); }
+
+    unsigned int dataSize () const { return this->numElements () * sizeof (T); }
+
+    std::size_t memoryBytes () const
     {
-      this->dataLowerBound = Util::maxUnsignedInt ();
-      this->dataUpperBound = 0;
+      return this->data.memoryBytes () + this->dirtyPages.memoryBytes ();
     }
 
-    unsigned int numElements () const { return this->data.size (); }
-
     void reserve (unsigned int size) { this->data.reserve (size); }
 
     void shrink (unsigned int n)
     {
       assert (n <= this->numElements ());
+      // the buffer keeps its size: data behind `n` is not drawn anymore
       this->data.resize (n);
-      this->dataLowerBound = 0;
-      this->dataUpperBound = n > 0 ? n - 1 : 0;
-    }
-
-    void updateBounds (unsigned int index)
-    {
-      this->dataLowerBound = glm::min (this->dataLowerBound, index);
-      this->dataUpperBound = glm::max (this->dataUpperBound, index);
     }
 
     unsigned int add (const T& value)
     {
       this->data.push_back (value);
-      this->updateBounds (this->numElements () - 1);
+      this->dirtyPages.mark (this->dataSize () - sizeof (T), sizeof (T));
       return this->numElements () - 1;
     }
 
     void set (unsigned int index, const T& value)
     {
       assert (index < this->numElements ());
-      this->data[index] = value;
-      this->updateBounds (index);
+      this->data.set (index, value);
+      this->dirtyPages.mark (index * sizeof (T), sizeof (T));
     }
 
     const T& get (unsigned int index) const
@@ -81,7 +93,7 @@ namespace
       return this->data[index];
     }
 
-    void bufferData (unsigned int target)
+    void upload (unsigned int target) const
     {
       if (this->id.isValid () == false)
       {
@@ -90,29 +102,28 @@ namespace
       }
       OpenGL::glBindBuffer (target, this->id.id ());
 
-      const unsigned int dataSize = this->numElements () * sizeof (T);
+      const unsigned int dataSize = this->dataSize ();
 
-      if (this->bufferSize == 0)
+      if (this->bufferSize == 0 || this->bufferSize < dataSize)
       {
-        OpenGL::glBufferData (target, dataSize, this->data.data (), OpenGL::StaticDraw ());
-        this->bufferSize = dataSize;
-      }
-      else if (this->bufferSize < dataSize)
-      {
-        const unsigned int newBufferSize = this->bufferSize + (100 * (dataSize - this->bufferSize));
+        this->bufferSize = this->bufferSize == 0
+                             ? dataSize
+                             : this->bufferSize + (100 * (dataSize - this->bufferSize));
 
-        OpenGL::glBufferData (target, newBufferSize, nullptr, OpenGL::StaticDraw ());
-        OpenGL::glBufferSubData (target, 0, dataSize, this->data.data ());
-        this->bufferSize = newBufferSize;
+        OpenGL::glBufferData (target, this->bufferSize, nullptr, OpenGL::StaticDraw ());
+        this->dirtyPages.markAll (dataSize);
       }
-      else if (this->dataLowerBound <= this->dataUpperBound)
+
+      for (const DirtyPages::Range& range : this->dirtyPages.ranges (dataSize, chunkSize))
       {
-        const unsigned int size = (this->dataUpperBound - this->dataLowerBound + 1) * sizeof (T);
+        const unsigned int c = range.offset / chunkSize;
+        const char*        bytes = reinterpret_cast<const char*> (this->data.chunk (c).data ());
 
-        OpenGL::glBufferSubData (target, this->dataLowerBound * sizeof (T), size,
-                                 &this->get (this->dataLowerBound));
+        OpenGL::glBufferSubData (target, range.offset, range.size,
+                                 bytes + range.offset - (c * chunkSize));
+        countUpload (range.size);
       }
-      this->resetBounds ();
+      this->dirtyPages.clear ();
     }
   };
 }
@@ -128,6 +139,10 @@ struct Mesh::Impl
   BufferedData<glm::vec3>    normals;
   Color                      color;
   Color                      wireframeColor;
+  bool                       hasDrawRanges;
+  std::vector<int>           drawRangeCounts;
+  std::vector<const void*>   drawRangeOffsets;
+  mutable bool               needsUpload;
 
   RenderMode renderMode;
 
@@ -137,6 +152,8 @@ struct Mesh::Impl
     , translationMatrix (glm::mat4x4 (1.0f))
     , color (Color::White ())
     , wireframeColor (Color::Black ())
+    , hasDrawRanges (false)
+    , needsUpload (false)
   {
     this->renderMode.smoothShading (true);
   }
@@ -165,7 +182,11 @@ struct Mesh::Impl
 
   void reserveIndices (unsigned int n) { this->indices.reserve (n); }
 
-  void shrinkIndices (unsigned int n) { this->indices.shrink (n); }
+  void shrinkIndices (unsigned int n)
+  {
+    this->indices.shrink (n);
+    this->clampDrawRanges ();
+  }
 
   unsigned int addVertex (const glm::vec3& v) { return this->addVertex (v, glm::vec3 (0.0f)); }
 
@@ -205,14 +226,83 @@ struct Mesh::Impl
     this->normals.set (i, n);
   }
 
-  void bufferData ()
+  void resetDrawRanges ()
   {
-    this->vertices.bufferData (OpenGL::ArrayBuffer ());
-    this->indices.bufferData (OpenGL::ElementArrayBuffer ());
-    this->normals.bufferData (OpenGL::ArrayBuffer ());
+    this->hasDrawRanges = false;
+    this->drawRangeCounts.clear ();
+    this->drawRangeOffsets.clear ();
+  }
 
-    OpenGL::glBindBuffer (OpenGL::ElementArrayBuffer (), 0);
-    OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), 0);
+  // drops or shortens draw ranges that reach behind the last index
+  void clampDrawRanges ()
+  {
+    const unsigned int numIndices = this->numIndices ();
+    unsigned int       numRanges = 0;
+
+    for (unsigned int i = 0; i < this->drawRangeCounts.size (); i++)
+    {
+      const unsigned int first =
+        reinterpret_cast<std::size_t> (this->drawRangeOffsets[i]) / sizeof (unsigned int);
+
+      if (first < numIndices)
+      {
+        this->drawRangeCounts[numRanges] =
+          glm::min (this->drawRangeCounts[i], int(numIndices - first));
+        this->drawRangeOffsets[numRanges] = this->drawRangeOffsets[i];
+        numRanges++;
+      }
+    }
+    this->drawRangeCounts.resize (numRanges);
+    this->drawRangeOffsets.resize (numRanges);
+  }
+
+  void addDrawRange (unsigned int first, unsigned int n)
+  {
+    assert (first + n <= this->numIndices ());
+
+    this->hasDrawRanges = true;
+    this->drawRangeCounts.push_back (int(n));
+    this->drawRangeOffsets.push_back (
+      reinterpret_cast<const void*> (std::size_t (first) * sizeof (unsigned int)));
+  }
+
+  void drawTriangles () const
+  {
+    if (this->hasDrawRanges)
+    {
+      OpenGL::glMultiDrawElements (OpenGL::Triangles (), this->drawRangeCounts.data (),
+                                   OpenGL::UnsignedInt (), this->drawRangeOffsets.data (),
+                                   int(this->drawRangeCounts.size ()));
+    }
+    else
+    {
+      OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), OpenGL::UnsignedInt (),
+                              nullptr);
+    }
+  }
+
+  void bufferData () { this->needsUpload = true; }
+
+  void upload () const
+  {
+    if (this->needsUpload)
+    {
+      this->vertices.upload (OpenGL::ArrayBuffer ());
+      this->indices.upload (OpenGL::ElementArrayBuffer ());
+      this->normals.upload (OpenGL::ArrayBuffer ());
+      this->needsUpload = false;
+    }
+  }
+
+  MemoryUsage memoryUsage () const
+  {
+    MemoryUsage usage;
+    usage.add ("vertices", this->vertices.memoryBytes ());
+    usage.add ("normals", this->normals.memoryBytes ());
+    usage.add ("indices", this->indices.memoryBytes ());
+    usage.add ("draw ranges", (this->drawRangeCounts.capacity () * sizeof (int)) +
+                                (this->drawRangeOffsets.capacity () * sizeof (const void*)));
+    return usage;
   }
 
   glm::mat4x4 modelMatrix () const
@@ -247,6 +337,7 @@ struct Mesh::Impl
     camera.renderer ().setWireframeColor (this->wireframeColor);
 
     this->setModelMatrix (camera, this->renderMode.cameraRotationOnly ());
+    this->upload ();
 
     OpenGL::glBindBuffer (OpenGL::ArrayBuffer (), this->vertices.id.id ());
     OpenGL::glEnableVertexAttribArray (OpenGL::PositionIndex);
@@ -280,17 +371,14 @@ struct Mesh::Impl
   void render (Camera& camera) const
   {
     this->renderBegin (camera);
-
-    OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), OpenGL::UnsignedInt (),
-                            nullptr);
+    this->drawTriangles ();
 
     if (this->renderMode.renderWireframe () && OpenGL::hasGeometryShader () == false)
     {
       camera.renderer ().setColor (this->wireframeColor);
       OpenGL::glPolygonMode (OpenGL::FrontAndBack (), OpenGL::Line ());
 
-      OpenGL::glDrawElements (OpenGL::Triangles (), this->numIndices (), OpenGL::UnsignedInt (),
-                              nullptr);
+      this->drawTriangles ();
 
       OpenGL::glPolygonMode (OpenGL::FrontAndBack (), OpenGL::Fill ());
     }
@@ -318,6 +406,7 @@ struct Mesh::Impl
     this->vertices.reset ();
     this->indices.reset ();
     this->normals.reset ();
+    this->resetDrawRanges ();
   }
 
   void scale (const glm::vec3& v) { this->scalingMatrix = glm::scale (this->scalingMatrix, v); }
@@ -429,7 +518,19 @@ DELEGATE2 (void, Mesh, index, unsigned int, unsigned int)
 DELEGATE2 (void, Mesh, vertex, unsigned int, const glm::vec3&)
 DELEGATE2 (void, Mesh, normal, unsigned int, const glm::vec3&)
 
+DELEGATE (void, Mesh, resetDrawRanges)
+DELEGATE2 (void, Mesh, addDrawRange, unsigned int, unsigned int)
 DELEGATE (void, Mesh, bufferData)
+DELEGATE_CONST (MemoryUsage, Mesh, memoryUsage)
+
+Mesh::UploadStatistics Mesh::uploadStatistics () { return lastUploadStatistics; }
+
+void Mesh::finishUploadFrame ()
+{
+  lastUploadStatistics = currentUploadStatistics;
+  currentUploadStatistics = {0, 0};
+}
+
 DELEGATE_CONST (glm::mat4x4, Mesh, modelMatrix)
 DELEGATE_CONST (glm::mat3x3, Mesh, modelNormalMatrix)
 DELEGATE1_CONST (void, Mesh, renderBegin, Camera&)
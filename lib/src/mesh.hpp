@@ -10,6 +10,7 @@
 
 class Camera;
 class Color;
+class MemoryUsage;
 class RenderFlags;
 class RenderMode;
 
@@ -18,6 +19,12 @@ class Mesh
 public:
   DECLARE_BIG6 (Mesh)
 
+  struct UploadStatistics
+  {
+    unsigned int numUploads;
+    unsigned int numBytes;
+  };
+
   unsigned int     numVertices () const;
   unsigned int     numIndices () const;
   const glm::vec3& vertex (unsigned int) const;
@@ -35,7 +42,14 @@ public:
   void             vertex (unsigned int, const glm::vec3&);
   void             normal (unsigned int, const glm::vec3&);
 
+  // `render` only draws the triangles of added draw ranges (first index, number of indices):
+  // `shrinkIndices` clamps them to the remaining indices
+  void resetDrawRanges ();
+  void addDrawRange (unsigned int, unsigned int);
+
+  // changes are uploaded to OpenGL buffers when the mesh is rendered the next time
   void              bufferData ();
+  MemoryUsage       memoryUsage () const;
   glm::mat4x4       modelMatrix () const;
   glm::mat3x3       modelNormalMatrix () const;
   void              renderBegin (Camera&) const;
@@ -47,6 +61,10 @@ public:
   const RenderMode& renderMode () const;
   RenderMode&       renderMode ();
 
+  // uploads to OpenGL buffers of all meshes during the last finished frame
+  static UploadStatistics uploadStatistics ();
+  static void             finishUploadFrame ();
+
   void               scale (const glm::vec3&);
   void               scaling (const glm::vec3&);
   glm::vec3          scaling () const;
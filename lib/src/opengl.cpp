@@ -148,6 +148,8 @@ namespace OpenGL
   DELEGATE2_GL (int, glGetUniformLocation, unsigned int, const char*)
   DELEGATE1_GL (bool, glIsBuffer, unsigned int)
   DELEGATE1_GL (bool, glIsProgram, unsigned int)
+  DELEGATE5_GL (void, glMultiDrawElements, unsigned int, const int*, unsigned int,
+                const void* const*, int)
   DELEGATE2_GL (void, glPolygonMode, unsigned int, unsigned int)
   DELEGATE2_GL (void, glPolygonOffset, float, float)
   DELEGATE3_GL (void, glStencilFunc, unsigned int, int, unsigned int)
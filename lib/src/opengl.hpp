@@ -77,6 +77,7 @@ namespace OpenGL
   int  glGetUniformLocation (unsigned int, const char*);
   bool glIsBuffer (unsigned int);
   bool glIsProgram (unsigned int);
+  void glMultiDrawElements (unsigned int, const int*, unsigned int, const void* const*, int);
   void glPolygonMode (unsigned int, unsigned int);
   void glPolygonOffset (float, float);
   void glStencilFunc (unsigned int, int, unsigned int);
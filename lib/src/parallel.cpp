@@ -0,0 +1,194 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "parallel.hpp"
+
+namespace
+{
+  std::atomic<unsigned int> configuredNumThreads (0);
+
+  // set on workers and on threads that run tasks of the pool, whose nested runs are serial
+  thread_local bool runsTasks = false;
+
+  /* Workers are started on demand and wait for tasks until the program exits. A run hands out the
+   * indices of its tasks to the calling thread and to all workers, and returns once every task is
+   * done and no worker still holds the run's task.
+   */
+  class WorkerPool
+  {
+  public:
+    WorkerPool ()
+      : task (nullptr)
+      , numTasks (0)
+      , nextTask (0)
+      , numDone (0)
+      , numActive (0)
+      , generation (0)
+      , stopping (false)
+    {
+    }
+
+    ~WorkerPool ()
+    {
+      {
+        std::lock_guard<std::mutex> lock (this->mutex);
+        this->stopping = true;
+      }
+      this->wakeUp.notify_all ();
+
+      for (std::thread& worker : this->workers)
+      {
+        worker.join ();
+      }
+    }
+
+    // fails if called from a task or while another thread runs tasks
+    bool run (unsigned int numWorkers, unsigned int n, const std::function<void(unsigned int)>& f)
+    {
+      if (runsTasks)
+      {
+        return false;
+      }
+      std::unique_lock<std::mutex> runLock (this->runMutex, std::try_to_lock);
+
+      if (runLock.owns_lock () == false)
+      {
+        return false;
+      }
+      {
+        std::lock_guard<std::mutex> lock (this->mutex);
+
+        while (this->workers.size () < numWorkers)
+        {
+          const unsigned int seen = this->generation;
+          this->workers.emplace_back ([this, seen]() { this->work (seen); });
+        }
+        this->task = &f;
+        this->numTasks = n;
+        this->nextTask = 0;
+        this->numDone = 0;
+        this->generation++;
+      }
+      this->wakeUp.notify_all ();
+
+      runsTasks = true;
+      const unsigned int numRun = this->runTasks ();
+      runsTasks = false;
+
+      std::unique_lock<std::mutex> lock (this->mutex);
+      this->numDone += numRun;
+      this->finished.wait (lock, [this]() {
+        return this->numDone == this->numTasks && this->numActive == 0;
+      });
+      this->task = nullptr;
+      return true;
+    }
+
+  private:
+    unsigned int runTasks ()
+    {
+      unsigned int numRun = 0;
+
+      for (unsigned int i = this->nextTask++; i < this->numTasks; i = this->nextTask++)
+      {
+        (*this->task) (i);
+        numRun++;
+      }
+      return numRun;
+    }
+
+    void work (unsigned int seen)
+    {
+      runsTasks = true;
+
+      std::unique_lock<std::mutex> lock (this->mutex);
+      while (true)
+      {
+        this->wakeUp.wait (lock, [this, seen]() {
+          return this->stopping || (this->task && this->generation != seen);
+        });
+        if (this->stopping)
+        {
+          return;
+        }
+        seen = this->generation;
+        this->numActive++;
+        lock.unlock ();
+
+        const unsigned int numRun = this->runTasks ();
+
+        lock.lock ();
+        this->numDone += numRun;
+        this->numActive--;
+
+        if (this->numDone == this->numTasks && this->numActive == 0)
+        {
+          this->finished.notify_one ();
+        }
+      }
+    }
+
+    std::mutex                               runMutex;
+    std::mutex                               mutex;
+    std::condition_variable                  wakeUp;
+    std::condition_variable                  finished;
+    std::vector<std::thread>                 workers;
+    const std::function<void(unsigned int)>* task;
+    unsigned int                             numTasks;
+    std::atomic<unsigned int>                nextTask;
+    unsigned int                             numDone;
+    unsigned int                             numActive;
+    unsigned int                             generation;
+    bool                                     stopping;
+  };
+
+  WorkerPool& workerPool ()
+  {
+    static WorkerPool pool;
+    return pool;
+  }
+}
+
+unsigned int Parallel::numThreads ()
+{
+  const unsigned int n = configuredNumThreads;
+  return n > 0 ? n : std::max (1u, std::thread::hardware_concurrency ());
+}
+
+void Parallel::numThreads (unsigned int n) { configuredNumThreads = n; }
+
+void Parallel::forRanges (unsigned int n, unsigned int minRangeSize,
+                          const std::function<void(unsigned int, unsigned int)>& f)
+{
+  const unsigned int maxNumRanges = std::max (1u, n / std::max (1u, minRangeSize));
+  const unsigned int numRanges = std::min (Parallel::numThreads (), maxNumRanges);
+
+  if (numRanges <= 1)
+  {
+    if (n > 0)
+    {
+      f (0, n);
+    }
+    return;
+  }
+
+  const auto range = [n, numRanges, &f](unsigned int r) {
+    const unsigned long long total = n;
+    f ((unsigned int) ((total * r) / numRanges), (unsigned int) ((total * (r + 1)) / numRanges));
+  };
+
+  if (workerPool ().run (numRanges - 1, numRanges, range) == false)
+  {
+    for (unsigned int r = 0; r < numRanges; r++)
+    {
+      range (r);
+    }
+  }
+}
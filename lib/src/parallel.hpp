@@ -0,0 +1,26 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_PARALLEL
+#define DILAY_PARALLEL
+
+#include <functional>
+
+namespace Parallel
+{
+  // defaults to the number of hardware threads
+  unsigned int numThreads ();
+  void         numThreads (unsigned int);
+
+  /* Splits `[0, n)` into contiguous ranges of at least `minRangeSize` elements and calls
+   * `f (begin, end)` for each range on the calling thread and a pool of worker threads, which
+   * persist between calls. The ranges only depend on `n`, `minRangeSize` and `numThreads ()`.
+   * `f` must only write to data of its own range. Calls from within `f` or while another thread
+   * uses the pool run their ranges one after another on the calling thread.
+   */
+  void forRanges (unsigned int n, unsigned int minRangeSize,
+                  const std::function<void(unsigned int, unsigned int)>& f);
+}
+
+#endif
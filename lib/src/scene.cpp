@@ -8,6 +8,7 @@
 #include "dynamic/mesh.hpp"
 #include "import-export.hpp"
 #include "intersection.hpp"
+#include "memory-usage.hpp"
 #include "render-mode.hpp"
 #include "scene.hpp"
 #include "sketch/bone-intersection.hpp"
@@ -47,6 +48,13 @@ struct Scene::Impl
     return this->dynamicMeshes.back ();
   }
 
+  DynamicMesh& newDynamicMesh (const Config& config, const Mesh& mesh, const DynamicOctree& octree)
+  {
+    this->dynamicMeshes.emplace_back (mesh, octree);
+    this->setupMesh (config, this->dynamicMeshes.back ());
+    return this->dynamicMeshes.back ();
+  }
+
   SketchMesh& newSketchMesh (const Config& config, const SketchMesh& other)
   {
     this->sketchMeshes.emplace_back (other);
@@ -203,6 +211,14 @@ struct Scene::Impl
     this->forEachConstMesh ([](const DynamicMesh& mesh) { mesh.printStatistics (); });
   }
 
+  MemoryUsage memoryUsage () const
+  {
+    MemoryUsage usage;
+    this->forEachConstMesh ([&usage](const DynamicMesh& mesh) { usage.add (mesh.memoryUsage ()); });
+    this->forEachConstMesh ([&usage](const SketchMesh& mesh) { usage.add (mesh.memoryUsage ()); });
+    return usage;
+  }
+
   void forEachMesh (const std::function<void(DynamicMesh&)>& f)
   {
     const unsigned int n = this->dynamicMeshes.size ();
@@ -394,6 +410,7 @@ DELEGATE1_BIG3_SELF (Scene, const Config&)
 
 DELEGATE2 (DynamicMesh&, Scene, newDynamicMesh, const Config&, const DynamicMesh&)
 DELEGATE2 (DynamicMesh&, Scene, newDynamicMesh, const Config&, const Mesh&)
+DELEGATE3 (DynamicMesh&, Scene, newDynamicMesh, const Config&, const Mesh&, const DynamicOctree&)
 DELEGATE2 (SketchMesh&, Scene, newSketchMesh, const Config&, const SketchMesh&)
 DELEGATE2 (SketchMesh&, Scene, newSketchMesh, const Config&, const SketchTree&)
 DELEGATE2 (void, Scene, setupMesh, const Config&, DynamicMesh&)
@@ -412,6 +429,7 @@ DELEGATE3 (bool, Scene, intersects, const PrimRay&, SketchMeshIntersection&, uns
 DELEGATE2 (bool, Scene, intersects, const PrimRay&, SketchPathIntersection&)
 DELEGATE2 (bool, Scene, intersects, const PrimRay&, Intersection&)
 DELEGATE_CONST (void, Scene, printStatistics)
+DELEGATE_CONST (MemoryUsage, Scene, memoryUsage)
 DELEGATE1 (void, Scene, forEachMesh, const std::function<void(DynamicMesh&)>&)
 DELEGATE1 (void, Scene, forEachMesh, const std::function<void(SketchMesh&)>&)
 DELEGATE1_CONST (void, Scene, forEachConstMesh, const std::function<void(const DynamicMesh&)>&)
@@ -13,7 +13,9 @@
 class Camera;
 class DynamicMesh;
 class DynamicMeshIntersection;
+class DynamicOctree;
 class Intersection;
+class MemoryUsage;
 class Mesh;
 class PrimRay;
 class RenderMode;
@@ -25,6 +27,7 @@ public:
 
   DynamicMesh&       newDynamicMesh (const Config&, const DynamicMesh&);
   DynamicMesh&       newDynamicMesh (const Config&, const Mesh&);
+  DynamicMesh&       newDynamicMesh (const Config&, const Mesh&, const DynamicOctree&);
   SketchMesh&        newSketchMesh (const Config&, const SketchMesh&);
   SketchMesh&        newSketchMesh (const Config&, const SketchTree&);
   void               setupMesh (const Config&, DynamicMesh&);
@@ -43,6 +46,7 @@ public:
   bool               intersects (const PrimRay&, SketchPathIntersection&);
   bool               intersects (const PrimRay&, Intersection&);
   void               printStatistics () const;
+  MemoryUsage        memoryUsage () const;
   void               forEachMesh (const std::function<void(DynamicMesh&)>&);
   void               forEachMesh (const std::function<void(SketchMesh&)>&);
   void               forEachConstMesh (const std::function<void(const DynamicMesh&)>&) const;
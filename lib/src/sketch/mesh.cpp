@@ -9,6 +9,7 @@
 #include "config.hpp"
 #include "dimension.hpp"
 #include "distance.hpp"
+#include "memory-usage.hpp"
 #include "mesh-util.hpp"
 #include "primitive/aabox.hpp"
 #include "primitive/cone-sphere.hpp"
@@ -912,6 +913,28 @@ struct SketchMesh::Impl
     }
   }
 
+  MemoryUsage memoryUsage () const
+  {
+    MemoryUsage usage;
+
+    if (this->tree.hasRoot ())
+    {
+      // each node of a tree is an element of its parent's `std::list`
+      usage.add ("sketch nodes",
+                 this->tree.root ().numNodes () * (sizeof (SketchNode) + (2 * sizeof (void*))));
+    }
+
+    std::size_t pathBytes = this->paths.capacity () * sizeof (SketchPath);
+    for (const SketchPath& p : this->paths)
+    {
+      pathBytes += p.spheres ().capacity () * sizeof (PrimSphere);
+    }
+    usage.add ("sketch paths", pathBytes);
+    usage.add (this->sphereMesh.memoryUsage ());
+    usage.add (this->boneMesh.memoryUsage ());
+    return usage;
+  }
+
   void runFromConfig (const Config& config)
   {
     this->renderConfig.nodeColor = config.get<Color> ("editor/sketch/node/color");
@@ -953,4 +976,5 @@ DELEGATE2_CONST (void, SketchMesh, minMax, glm::vec3&, glm::vec3&)
 DELEGATE5 (void, SketchMesh, smoothPath, SketchPath&, const PrimSphere&, unsigned int,
            SketchPathSmoothEffect, const Dimension*)
 DELEGATE (void, SketchMesh, optimizePaths)
+DELEGATE_CONST (MemoryUsage, SketchMesh, memoryUsage)
 DELEGATE1 (void, SketchMesh, runFromConfig, const Config&)
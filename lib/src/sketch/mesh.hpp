@@ -11,6 +11,7 @@
 #include "sketch/fwd.hpp"
 
 class Camera;
+class MemoryUsage;
 enum class Dimension;
 class PrimPlane;
 class PrimRay;
@@ -48,6 +49,7 @@ public:
   void               rebalance (SketchNode&);
   SketchNode&        snap (SketchNode&, Dimension);
   void               minMax (glm::vec3&, glm::vec3&) const;
+  MemoryUsage        memoryUsage () const;
   void smoothPath (SketchPath&, const PrimSphere&, unsigned int, SketchPathSmoothEffect,
                    const Dimension*);
   void optimizePaths ();
@@ -251,7 +251,7 @@ struct State::Impl
     {
       this->handleToolResponse (this->toolPtr->commit ());
     }
-    this->history.undo (*this->self);
+    this->history.undo (this->config, this->scene);
     this->mainWindow.infoPane ().scene ().updateInfo ();
     this->mainWindow.update ();
   }
@@ -262,7 +262,7 @@ struct State::Impl
     {
       this->handleToolResponse (this->toolPtr->commit ());
     }
-    this->history.redo (*this->self);
+    this->history.redo (this->config, this->scene);
     this->mainWindow.infoPane ().scene ().updateInfo ();
     this->mainWindow.update ();
   }
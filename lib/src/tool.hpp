@@ -57,6 +57,7 @@ protected:
   void               snapshotAll ();
   void               snapshotDynamicMeshes ();
   void               snapshotSketchMeshes ();
+  void               recordDynamicMeshes ();
   bool               intersectsRecentDynamicMesh (const PrimRay&, Intersection&) const;
   bool               intersectsRecentDynamicMesh (const glm::ivec2&, Intersection&) const;
   bool               hasMirror () const;
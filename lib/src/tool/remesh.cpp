@@ -99,15 +99,16 @@ struct ToolRemesh::Impl
     glm::vec3 min, max;
     mesh.mesh ().minMax (min, max);
 
-    const IsosurfaceExtraction::IntersectionCallback getIntersection =
-      [&mesh](const PrimRay& ray, Intersection& intersection) {
-        if (mesh.intersects (ray, intersection, true))
-        {
-          return IsosurfaceExtraction::Intersection::Sample;
-        }
-        else
+    const IsosurfaceExtraction::IntersectionPacketCallback getIntersections =
+      [&mesh](const std::vector<PrimRay>& rays, std::vector<Intersection>& intersections,
+              std::vector<IsosurfaceExtraction::Intersection>& results) {
+        mesh.intersects (rays, intersections, true);
+
+        for (unsigned int i = 0; i < rays.size (); i++)
         {
-          return IsosurfaceExtraction::Intersection::None;
+          results[i] = intersections[i].isIntersection ()
+                         ? IsosurfaceExtraction::Intersection::Sample
+                         : IsosurfaceExtraction::Intersection::None;
         }
       };
 
@@ -117,7 +118,8 @@ struct ToolRemesh::Impl
 
     const float     resolution = this->maxResolution + this->minResolution - this->resolution;
     const PrimAABox bounds (min, max);
-    Mesh newMesh = IsosurfaceExtraction::extract (getDistance, getIntersection, bounds, resolution);
+    Mesh newMesh =
+      IsosurfaceExtraction::extract (getDistance, getIntersections, bounds, resolution);
 
     State& state = this->self->state ();
     state.scene ().deleteMesh (mesh);
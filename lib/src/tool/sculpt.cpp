@@ -186,7 +186,7 @@ struct ToolSculpt::Impl
     }
     else if (e.pressEvent () && e.leftButton ())
     {
-      this->self->snapshotDynamicMeshes ();
+      this->self->recordDynamicMeshes ();
       this->sculptState = SculptState::Started;
     }
 
@@ -253,6 +253,10 @@ struct ToolSculpt::Impl
     {
       this->self->state ().history ().dropPastSnapshot ();
     }
+    else if (this->sculptState == SculptState::Sculpted)
+    {
+      this->self->state ().history ().finishRecording ();
+    }
     this->sculptState = SculptState::None;
     return ToolResponse::None;
   }
@@ -299,6 +303,8 @@ struct ToolSculpt::Impl
 
     if (this->brush.mesh ().isEmpty ())
     {
+      // deleting a mesh invalidates the recorded changes, i.e., they are turned into a snapshot
+      this->self->state ().history ().finishRecording ();
       this->self->state ().scene ().deleteEmptyMeshes ();
       this->brush.resetPointOfAction ();
     }
@@ -5,9 +5,11 @@
 #include <functional>
 #include <glm/glm.hpp>
 #include <glm/gtx/norm.hpp>
+#include <unordered_set>
 #include "dynamic/faces.hpp"
 #include "dynamic/mesh.hpp"
 #include "intersection.hpp"
+#include "parallel.hpp"
 #include "primitive/sphere.hpp"
 #include "primitive/triangle.hpp"
 #include "tool/sculpt/util/action.hpp"
@@ -17,7 +19,8 @@
 
 namespace
 {
-  constexpr float minEdgeLength = 0.001f;
+  constexpr float        minEdgeLength = 0.001f;
+  constexpr unsigned int minParallelSmoothRangeSize = 1024;
 
   struct NewFaces
   {
@@ -50,7 +53,7 @@ namespace
 
       if (mesh.isEmpty ())
       {
-        mesh.setupOctreeRoot ();
+        mesh.setupSpatialIndexRoot ();
       }
 
       for (unsigned int i = 0; i < this->vertexIndices.size (); i += 3)
@@ -73,7 +76,7 @@ namespace
     const DynamicMesh& mesh = brush.mesh ();
     const PrimSphere   sphere = brush.sphere ();
 
-    std::unordered_set<unsigned int> frontier;
+    DynamicFaces::Container frontier;
 
     faces.filter ([&mesh, &sphere, &frontier](unsigned int i) {
       const PrimTriangle face = mesh.face (i);
@@ -84,31 +87,27 @@ namespace
       }
       else if (sphere.contains (face) == false)
       {
-        frontier.insert (i);
+        frontier.push_back (i);
       }
       return true;
     });
 
     for (unsigned int ring = 0; ring < numRings; ring++)
     {
-      std::unordered_set<unsigned int> extendedFrontier;
-
       for (unsigned int i : frontier)
       {
-        mesh.forEachVertexAdjacentToFace (
-          i, [&mesh, &faces, &frontier, &extendedFrontier](unsigned int v) {
-            for (unsigned int a : mesh.adjacentFaces (v))
+        mesh.forEachVertexAdjacentToFace (i, [&mesh, &faces](unsigned int v) {
+          for (unsigned int a : mesh.adjacentFaces (v))
+          {
+            if (faces.contains (a) == false)
             {
-              if (faces.contains (a) == false && frontier.find (a) == frontier.end ())
-              {
-                faces.insert (a);
-                extendedFrontier.insert (a);
-              }
+              faces.insert (a);
             }
-          });
+          }
+        });
       }
+      frontier = faces.uncommitted ();
       faces.commit ();
-      frontier = std::move (extendedFrontier);
     }
   }
 
@@ -182,42 +181,23 @@ namespace
   {
     assert (faces.hasUncomitted () == false);
 
-    const auto split = [&mesh, &newE, maxLength](unsigned int i1, unsigned int i2) {
+    // faces that split one of their edges, their neighbours are retriangulated too
+    DynamicFaces splitFaces;
+
+    mesh.forEachEdge (faces, [&mesh, &newE, &splitFaces, maxLength](unsigned int h) {
+      const unsigned int i1 = mesh.halfEdgeSource (h);
+      const unsigned int i2 = mesh.halfEdgeTarget (h);
+
       if (glm::distance2 (mesh.vertex (i1), mesh.vertex (i2)) > maxLength * maxLength)
       {
         const glm::vec3 normal = glm::normalize (mesh.vertexNormal (i1) + mesh.vertexNormal (i2));
         const unsigned int i3 = mesh.addVertex (getSplitPosition (mesh, i1, i2), normal);
         newE.insert (i1, i2, i3);
-        return true;
-      }
-      else
-      {
-        return false;
-      }
-    };
-
-    faces.filter ([&mesh, &newE, &split](unsigned int f) {
-      bool wasSplit = false;
-
-      unsigned int i1, i2, i3;
-      mesh.vertexIndices (f, i1, i2, i3);
-
-      if (newE.contains (i1, i2) == false)
-      {
-        wasSplit = split (i1, i2) || wasSplit;
-      }
-
-      if (newE.contains (i1, i3) == false)
-      {
-        wasSplit = split (i1, i3) || wasSplit;
-      }
-
-      if (newE.contains (i2, i3) == false)
-      {
-        wasSplit = split (i2, i3) || wasSplit;
+        splitFaces.insert (h / 3);
       }
-      return wasSplit;
     });
+    splitFaces.commit ();
+    faces.filter ([&splitFaces](unsigned int f) { return splitFaces.contains (f); });
   }
 
   void triangulate (DynamicMesh& mesh, const ToolSculptEdgeMap& newE, DynamicFaces& faces)
@@ -350,19 +330,31 @@ namespace
       return (vE1 > 3) && (vE2 > 3) && (post < pre);
     };
 
-    ToolSculptEdgeSet edgeSet;
-    mesh.forEachVertex (faces, [&mesh, &edgeSet](unsigned int i) {
-      if (mesh.valence (i) > 6)
+    // edges are stored with their vertices: flips rewrite the half-edges of both of their faces
+    std::vector<std::pair<unsigned int, ui_pair>> edges;
+    mesh.forEachEdge (faces, [&mesh, &edges](unsigned int h) {
+      const ui_pair edge (mesh.halfEdgeSource (h), mesh.halfEdgeTarget (h));
+
+      if (mesh.valence (edge.first) > 6 || mesh.valence (edge.second) > 6)
       {
-        mesh.forEachVertexAdjacentToVertex (
-          i, [i, &edgeSet](unsigned int j) { edgeSet.insert (i, j); });
+        edges.emplace_back (h, edge);
       }
     });
 
-    for (const ui_pair& edge : edgeSet)
+    for (const std::pair<unsigned int, ui_pair>& e : edges)
     {
+      const unsigned int h = e.first;
+      const ui_pair&     edge = e.second;
+
       unsigned int leftFace, leftVertex, rightFace, rightVertex;
-      mesh.findAdjacent (edge.first, edge.second, leftFace, leftVertex, rightFace, rightVertex);
+      if (mesh.halfEdgeSource (h) == edge.first && mesh.halfEdgeTarget (h) == edge.second)
+      {
+        mesh.findAdjacent (h, leftFace, leftVertex, rightFace, rightVertex);
+      }
+      else
+      {
+        mesh.findAdjacent (edge.first, edge.second, leftFace, leftVertex, rightFace, rightVertex);
+      }
 
       if (isRelaxable (edge, leftVertex, rightVertex))
       {
@@ -380,65 +372,85 @@ namespace
     }
   }
 
-  void smooth (DynamicMesh& mesh, DynamicFaces& faces)
+  // only reads the mesh, i.e., can be called for several vertices in parallel
+  glm::vec3 smoothPosition (const DynamicMesh& mesh, unsigned int i)
   {
-    std::unordered_map<unsigned int, glm::vec3> newPosition;
+    const glm::vec3  avgPos = mesh.averagePosition (i);
+    const glm::vec3& normal = mesh.vertexNormal (i);
+    const glm::vec3  delta = avgPos - mesh.vertex (i);
+    const glm::vec3  tangentialPos = avgPos - (normal * glm::dot (normal, delta));
 
-    mesh.forEachVertex (faces, [&mesh, &newPosition](unsigned int i) {
-      const glm::vec3  avgPos = mesh.averagePosition (i);
-      const glm::vec3& normal = mesh.vertexNormal (i);
-      const glm::vec3  delta = avgPos - mesh.vertex (i);
-      const glm::vec3  tangentialPos = avgPos - (normal * glm::dot (normal, delta));
+    constexpr float lo = -Util::epsilon ();
+    constexpr float hi = 1.0f + Util::epsilon ();
 
-      constexpr float lo = -Util::epsilon ();
-      constexpr float hi = 1.0f + Util::epsilon ();
+    float     minDistance = Util::maxFloat ();
+    glm::vec3 projectedPos (0.0f);
 
-      float     minDistance = Util::maxFloat ();
-      glm::vec3 projectedPos (0.0f);
+    for (unsigned int a : mesh.adjacentFaces (i))
+    {
+      unsigned int i1, i2, i3;
+      mesh.vertexIndices (a, i1, i2, i3);
 
-      for (unsigned int a : mesh.adjacentFaces (i))
-      {
-        unsigned int i1, i2, i3;
-        mesh.vertexIndices (a, i1, i2, i3);
+      const glm::vec3& p1 = mesh.vertex (i1);
+      const glm::vec3& p2 = mesh.vertex (i2);
+      const glm::vec3& p3 = mesh.vertex (i3);
 
-        const glm::vec3& p1 = mesh.vertex (i1);
-        const glm::vec3& p2 = mesh.vertex (i2);
-        const glm::vec3& p3 = mesh.vertex (i3);
+      const glm::vec3 u = p2 - p1;
+      const glm::vec3 v = p3 - p1;
+      const glm::vec3 w = tangentialPos - p1;
+      const glm::vec3 n = glm::cross (u, v);
 
-        const glm::vec3 u = p2 - p1;
-        const glm::vec3 v = p3 - p1;
-        const glm::vec3 w = tangentialPos - p1;
-        const glm::vec3 n = glm::cross (u, v);
+      const float b1 = glm::dot (glm::cross (u, w), n) / (glm::dot (n, n));
+      const float b2 = glm::dot (glm::cross (w, v), n) / (glm::dot (n, n));
+      const float b3 = 1.0f - b1 - b2;
 
-        const float b1 = glm::dot (glm::cross (u, w), n) / (glm::dot (n, n));
-        const float b2 = glm::dot (glm::cross (w, v), n) / (glm::dot (n, n));
-        const float b3 = 1.0f - b1 - b2;
+      if (lo < b1 && b1 < hi && lo < b2 && b2 < hi && lo < b3 && b3 < hi)
+      {
+        const glm::vec3 proj = (b3 * p1) + (b2 * p2) + (b1 * p3);
+        const float     d = glm::distance2 (tangentialPos, proj);
 
-        if (lo < b1 && b1 < hi && lo < b2 && b2 < hi && lo < b3 && b3 < hi)
+        if (d < minDistance)
         {
-          const glm::vec3 proj = (b3 * p1) + (b2 * p2) + (b1 * p3);
-          const float     d = glm::distance2 (tangentialPos, proj);
-
-          if (d < minDistance)
-          {
-            minDistance = d;
-            projectedPos = proj;
-          }
+          minDistance = d;
+          projectedPos = proj;
         }
       }
-      if (minDistance != Util::maxFloat ())
-      {
-        newPosition.emplace (i, projectedPos);
-      }
-      else
-      {
-        newPosition.emplace (i, tangentialPos);
-      }
-    });
+    }
+    return minDistance != Util::maxFloat () ? projectedPos : tangentialPos;
+  }
+
+  /* Scratch space of `smooth` that is reused across brush steps, i.e., smoothing does not
+   * allocate once its capacity suffices.
+   */
+  struct SmoothScratch
+  {
+    std::vector<unsigned int> vertices;
+    std::vector<glm::vec3>    positions;
+  };
 
-    for (const auto& it : newPosition)
+  void smooth (DynamicMesh& mesh, DynamicFaces& faces)
+  {
+    thread_local SmoothScratch scratch;
+
+    std::vector<unsigned int>& vertices = scratch.vertices;
+    std::vector<glm::vec3>&    positions = scratch.positions;
+
+    vertices.clear ();
+    mesh.forEachVertex (faces, [&vertices](unsigned int i) { vertices.push_back (i); });
+    positions.resize (vertices.size ());
+
+    const DynamicMesh& constMesh = mesh;
+    Parallel::forRanges (vertices.size (), minParallelSmoothRangeSize,
+                         [&constMesh, &vertices, &positions](unsigned int begin, unsigned int end) {
+                           for (unsigned int i = begin; i < end; i++)
+                           {
+                             positions[i] = smoothPosition (constMesh, vertices[i]);
+                           }
+                         });
+
+    for (unsigned int i = 0; i < vertices.size (); i++)
     {
-      mesh.vertex (it.first, it.second);
+      mesh.vertex (vertices[i], positions[i]);
     }
   }
 
@@ -516,8 +528,10 @@ namespace
     }
   };
 
-  bool collapseEdge (DynamicMesh& mesh, unsigned int i1, unsigned int i2, DynamicFaces faces)
+  bool collapseEdge (DynamicMesh& mesh, unsigned int h, DynamicFaces faces)
   {
+    const unsigned int i1 = mesh.halfEdgeSource (h);
+    const unsigned int i2 = mesh.halfEdgeTarget (h);
     const unsigned int v1 = mesh.valence (i1);
     const unsigned int v2 = mesh.valence (i2);
 
@@ -646,7 +660,7 @@ namespace
     }
 
     unsigned int leftFace, leftVertex, rightFace, rightVertex;
-    mesh.findAdjacent (i1, i2, leftFace, leftVertex, rightFace, rightVertex);
+    mesh.findAdjacent (h, leftFace, leftVertex, rightFace, rightVertex);
 
     const unsigned int vLeftVertex = mesh.valence (leftVertex);
     const unsigned int vRightVertex = mesh.valence (rightVertex);
@@ -708,17 +722,18 @@ namespace
           unsigned int i1, i2, i3;
           mesh.vertexIndices (i, i1, i2, i3);
 
+          // half-edges `3 * i`, `3 * i + 1` and `3 * i + 2` run from i1 to i2, i2 to i3 and i3 to i1
           if (doCollapse (i1, i2))
           {
-            collapsed = collapseEdge (mesh, i1, i2, current) || collapsed;
+            collapsed = collapseEdge (mesh, 3 * i, current) || collapsed;
           }
           else if (doCollapse (i1, i3))
           {
-            collapsed = collapseEdge (mesh, i1, i3, current) || collapsed;
+            collapsed = collapseEdge (mesh, mesh.twin ((3 * i) + 2), current) || collapsed;
           }
           else if (doCollapse (i2, i3))
           {
-            collapsed = collapseEdge (mesh, i2, i3, current) || collapsed;
+            collapsed = collapseEdge (mesh, (3 * i) + 1, current) || collapsed;
           }
         }
       }
@@ -747,7 +762,7 @@ namespace
 
   void finalize (DynamicMesh& mesh, const DynamicFaces& faces)
   {
-    mesh.forEachVertex (faces, [&mesh](unsigned int i) { mesh.setVertexNormal (i); });
+    mesh.setNormals (faces);
 
     for (unsigned int i : faces)
     {
@@ -774,7 +789,11 @@ namespace ToolSculptAction
 
         if (mesh.isEmpty ())
         {
-          mesh.reset ();
+          // a recording mesh keeps its free elements, cf. `History::finishRecording`
+          if (mesh.recording () == false)
+          {
+            mesh.reset ();
+          }
           return;
         }
         else
@@ -783,7 +802,7 @@ namespace ToolSculptAction
           smooth (mesh, faces);
           finalize (mesh, faces);
         }
-        assert (mesh.pruneAndCheckConsistency ());
+        assert (mesh.checkConsistency ());
       }
       else
       {
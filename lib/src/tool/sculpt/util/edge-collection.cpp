@@ -36,17 +36,3 @@ bool ToolSculptEdgeMap::contains (unsigned int i1, unsigned int i2) const
 bool ToolSculptEdgeMap::isEmpty () const { return this->map.empty (); }
 
 void ToolSculptEdgeMap::reset () { this->map.clear (); }
-
-void ToolSculptEdgeSet::insert (unsigned int i1, unsigned int i2)
-{
-  this->set.emplace (makeUiKey (i1, i2));
-}
-
-bool ToolSculptEdgeSet::contains (unsigned int i1, unsigned int i2) const
-{
-  return this->set.find (makeUiKey (i1, i2)) != this->set.end ();
-}
-
-bool ToolSculptEdgeSet::isEmpty () const { return this->set.empty (); }
-
-void ToolSculptEdgeSet::reset () { this->set.clear (); }
@@ -6,7 +6,6 @@
 #define DILAY_TOOL_SCULPT_EDGE_COLLECTION
 
 #include <unordered_map>
-#include <unordered_set>
 #include "hash.hpp"
 
 class ToolSculptEdgeMap
@@ -24,21 +23,4 @@ private:
   Map map;
 };
 
-class ToolSculptEdgeSet
-{
-public:
-  typedef std::unordered_set<std::pair<unsigned int, unsigned int>> Set;
-
-  void insert (unsigned int, unsigned int);
-  bool contains (unsigned int, unsigned int) const;
-  bool isEmpty () const;
-  void reset ();
-
-  Set::const_iterator begin () const { return this->set.begin (); }
-  Set::const_iterator end () const { return this->set.end (); }
-
-private:
-  Set set;
-};
-
 #endif
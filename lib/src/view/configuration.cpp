@@ -214,7 +214,12 @@ namespace
   {
     ViewTwoColumnGrid* grid = new ViewTwoColumnGrid;
 
-    addIntEdit (data, *grid, "editor/undo-depth", QObject::tr ("Undo depth"), 1, Util::maxInt ());
+    addIntEdit (data, *grid, "editor/undo-memory", QObject::tr ("Undo memory (MiB)"), 1,
+                Util::maxInt ());
+    addIntEdit (data, *grid, "editor/undo-disk", QObject::tr ("Undo disk space (MiB)"), 0,
+                Util::maxInt ());
+    addIntEdit (data, *grid, "editor/undo-window", QObject::tr ("Undo steps in memory"), 1,
+                Util::maxInt ());
     addIntEdit (data, *grid, "window/initial-width", QObject::tr ("Initial window width"), 1,
                 Util::maxInt ());
     addIntEdit (data, *grid, "window/initial-height", QObject::tr ("Initial window height"), 1,
@@ -230,6 +235,8 @@ namespace
                   QObject::tr ("Table pressure intensity"), Util::epsilon (), 10.0f);
 
     addBoolEdit (data, *grid, "editor/use-geometry-shader", QObject::tr ("Use geometry shader"));
+    addBoolEdit (data, *grid, "editor/mesh/use-bvh",
+                 QObject::tr ("Use bounding volume hierarchy for meshes"));
 
     grid->addStretcher ();
 
@@ -152,6 +152,7 @@ struct ViewGlWidget::Impl
     {
       this->state ().tool ().paint (painter);
     }
+    Mesh::finishUploadFrame ();
   }
 
   void resizeGL (int w, int h) { this->state ().camera ().updateResolution (glm::uvec2 (w, h)); }
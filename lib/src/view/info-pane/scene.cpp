@@ -6,6 +6,9 @@
 #include <QVBoxLayout>
 #include "../../scene.hpp"
 #include "dynamic/mesh.hpp"
+#include "history.hpp"
+#include "memory-usage.hpp"
+#include "mesh.hpp"
 #include "sketch/mesh.hpp"
 #include "sketch/path.hpp"
 #include "state.hpp"
@@ -29,6 +32,11 @@ struct ViewInfoPaneScene::Impl
     this->tree->setRootIsDecorated (false);
   }
 
+  static QString toString (std::size_t bytes)
+  {
+    return QString::fromStdString (MemoryUsage::toString (bytes));
+  }
+
   void updateInfo ()
   {
     const auto showMesh = [this](const DynamicMesh& mesh) {
@@ -36,6 +44,16 @@ struct ViewInfoPaneScene::Impl
 
       new QTreeWidgetItem (item, {QObject::tr ("Faces"), QString::number (mesh.numFaces ())});
       new QTreeWidgetItem (item, {QObject::tr ("Vertices"), QString::number (mesh.numVertices ())});
+      new QTreeWidgetItem (item, {QObject::tr ("Memory"), toString (mesh.memoryUsage ().total ())});
+    };
+
+    const auto showMemory = [this](const QString& name, const MemoryUsage& usage) {
+      QTreeWidgetItem* item = new QTreeWidgetItem (this->tree, {name, toString (usage.total ())});
+
+      for (const MemoryUsage::Part& part : usage.parts ())
+      {
+        new QTreeWidgetItem (item, {QString::fromStdString (part.name), toString (part.bytes)});
+      }
     };
 
     const auto showSketch = [this](const SketchMesh& sketch) {
@@ -50,9 +68,33 @@ struct ViewInfoPaneScene::Impl
       }
     };
 
+    const auto showHistory = [this](const History& history) {
+      QTreeWidgetItem* item = new QTreeWidgetItem (this->tree, {QObject::tr ("Undo history")});
+      const QString    steps = QString::number (history.numSnapshots ());
+      const QString    restore =
+        QString::number (history.restoreMilliseconds (), 'f', 1) + QObject::tr (" ms");
+
+      new QTreeWidgetItem (item, {QObject::tr ("Steps"), steps});
+      new QTreeWidgetItem (item, {QObject::tr ("Last undo/redo"), restore});
+      new QTreeWidgetItem (item, {QObject::tr ("On disk"), toString (history.spilledBytes ())});
+    };
+
+    const auto showUploads = [this]() {
+      QTreeWidgetItem* item = new QTreeWidgetItem (this->tree, {QObject::tr ("Last frame")});
+
+      const Mesh::UploadStatistics stats = Mesh::uploadStatistics ();
+      new QTreeWidgetItem (item, {QObject::tr ("Uploads"), QString::number (stats.numUploads)});
+      new QTreeWidgetItem (item, {QObject::tr ("Uploaded"), toString (stats.numBytes)});
+    };
+
     this->tree->clear ();
     this->glWidget.state ().scene ().forEachConstMesh (showMesh);
     this->glWidget.state ().scene ().forEachConstMesh (showSketch);
+    showHistory (this->glWidget.state ().history ());
+    showUploads ();
+    showMemory (QObject::tr ("Memory (scene)"), this->glWidget.state ().scene ().memoryUsage ());
+    showMemory (QObject::tr ("Memory (undo history)"),
+                this->glWidget.state ().history ().memoryUsage ());
     this->tree->expandAll ();
     this->tree->setItemsExpandable (false);
 
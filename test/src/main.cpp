@@ -4,12 +4,22 @@
  */
 #include <QCoreApplication>
 #include <iostream>
+#include "test-adjacency.hpp"
 #include "test-bitset.hpp"
+#include "test-bvh.hpp"
+#include "test-cow-vector.hpp"
+#include "test-dirty-pages.hpp"
 #include "test-distance.hpp"
+#include "test-faces.hpp"
+#include "test-history.hpp"
+#include "test-import-export.hpp"
 #include "test-intersection.hpp"
 #include "test-maybe.hpp"
+#include "test-mesh-delta.hpp"
 #include "test-misc.hpp"
+#include "test-normals.hpp"
 #include "test-octree.hpp"
+#include "test-parallel.hpp"
 #include "test-prune.hpp"
 #include "test-tree.hpp"
 
@@ -23,12 +33,24 @@ int main ()
   TestMaybe::test2 ();
   TestMaybe::test3 ();
   TestOctree::test ();
+  TestBVH::test ();
   TestBitset::test ();
   TestTree::test1 ();
   TestTree::test2 ();
   TestMisc::test ();
   TestDistance::test ();
   TestPrune::test ();
+  TestAdjacency::test1 ();
+  TestAdjacency::test2 ();
+  TestAdjacency::test3 ();
+  TestNormals::test ();
+  TestParallel::test ();
+  TestFaces::test ();
+  TestCowVector::test ();
+  TestMeshDelta::test ();
+  TestDirtyPages::test ();
+  TestImportExport::test ();
+  TestHistory::test ();
 
   std::cout << "all tests run successfully\n";
   return 0;
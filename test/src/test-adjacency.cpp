@@ -0,0 +1,187 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include "dynamic/adjacency.hpp"
+#include "dynamic/faces.hpp"
+#include "dynamic/mesh.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "primitive/triangle.hpp"
+#include "test-adjacency.hpp"
+
+namespace
+{
+  bool equals (const DynamicAdjacency::Faces& faces, const std::vector<unsigned int>& vec)
+  {
+    return std::equal (faces.begin (), faces.end (), vec.begin (), vec.end ());
+  }
+
+  // checks that the faces adjacent to each edge agree from both sides of the edge
+  void checkEdge (const DynamicMesh& mesh, unsigned int e1, unsigned int e2)
+  {
+    unsigned int leftFace, leftVertex, rightFace, rightVertex;
+    mesh.findAdjacent (e1, e2, leftFace, leftVertex, rightFace, rightVertex);
+
+    unsigned int i1, i2, i3;
+    mesh.vertexIndices (leftFace, i1, i2, i3);
+    assert ((i1 == e1 && i2 == e2 && i3 == leftVertex) ||
+            (i2 == e1 && i3 == e2 && i1 == leftVertex) ||
+            (i3 == e1 && i1 == e2 && i2 == leftVertex));
+
+    mesh.vertexIndices (rightFace, i1, i2, i3);
+    assert ((i1 == e2 && i2 == e1 && i3 == rightVertex) ||
+            (i2 == e2 && i3 == e1 && i1 == rightVertex) ||
+            (i3 == e2 && i1 == e1 && i2 == rightVertex));
+
+    unsigned int twinLeftFace, twinLeftVertex, twinRightFace, twinRightVertex;
+    mesh.findAdjacent (e2, e1, twinLeftFace, twinLeftVertex, twinRightFace, twinRightVertex);
+    assert (twinLeftFace == rightFace && twinLeftVertex == rightVertex);
+    assert (twinRightFace == leftFace && twinRightVertex == leftVertex);
+  }
+
+  void checkEdges (DynamicMesh& mesh)
+  {
+    mesh.forEachFace ([&mesh](unsigned int f) {
+      unsigned int i1, i2, i3;
+      mesh.vertexIndices (f, i1, i2, i3);
+
+      checkEdge (mesh, i1, i2);
+      checkEdge (mesh, i2, i3);
+      checkEdge (mesh, i3, i1);
+    });
+  }
+}
+
+void TestAdjacency::test1 ()
+{
+  const unsigned int x = Util::invalidIndex ();
+  const unsigned int n = 2 * DynamicAdjacency::inlineCapacity;
+
+  DynamicAdjacency          adjacency;
+  std::vector<unsigned int> faces;
+
+  adjacency.addVertex ();
+  adjacency.addVertex ();
+  adjacency.addVertex ();
+
+  // exceeds the inline capacity of vertex 1
+  for (unsigned int i = 0; i < n; i++)
+  {
+    adjacency.addFace (1, i);
+    faces.push_back (i);
+    assert (equals (adjacency.faces (1), faces));
+  }
+  adjacency.addFace (0, 3);
+  adjacency.addFace (2, 5);
+  adjacency.addFace (2, 4);
+
+  // moves back inline
+  for (unsigned int i = 0; i < n; i += 2)
+  {
+    adjacency.deleteFace (1, i);
+    faces.erase (std::find (faces.begin (), faces.end (), i));
+    assert (equals (adjacency.faces (1), faces));
+  }
+  adjacency.deleteFace (0, 3);
+  adjacency.reset (0);
+  assert (adjacency.faces (0).empty ());
+
+  adjacency.prune ({x, 1, 0}, {x, 0, x, 1, 8, 2, x, 3, x, 4, x, 5, x, 6, x, 7});
+  assert (adjacency.numVertices () == 2);
+  assert (equals (adjacency.faces (0), {2, 8}));
+  assert (equals (adjacency.faces (1), {0, 1, 2, 3, 4, 5, 6, 7}));
+
+  unused (equals);
+}
+
+void TestAdjacency::test2 ()
+{
+  DynamicMesh mesh (MeshUtil::icosphere (2));
+  checkEdges (mesh);
+
+  // flips an edge and reuses the deleted faces
+  unsigned int i1, i2, i3;
+  mesh.vertexIndices (0, i1, i2, i3);
+
+  unsigned int leftFace, leftVertex, rightFace, rightVertex;
+  mesh.findAdjacent (i1, i2, leftFace, leftVertex, rightFace, rightVertex);
+  mesh.deleteFace (leftFace);
+  mesh.deleteFace (rightFace);
+  mesh.addFace (leftVertex, i1, rightVertex);
+  mesh.addFace (rightVertex, i2, leftVertex);
+  checkEdges (mesh);
+
+  // splits face 0 into three faces and merges them again, so that pruning moves faces
+  mesh.vertexIndices (0, i1, i2, i3);
+  const unsigned int n = mesh.numFaces ();
+  const unsigned int v = mesh.addVertex (mesh.face (0).center (), mesh.faceNormal (0));
+  mesh.deleteFace (0);
+  mesh.addFace (i1, i2, v);
+  mesh.addFace (i2, i3, v);
+  mesh.addFace (i3, i1, v);
+  checkEdges (mesh);
+
+  mesh.deleteFace (0);
+  mesh.deleteFace (n + 1);
+  mesh.deleteFace (n);
+  mesh.deleteVertex (v);
+  const unsigned int f = mesh.addFace (i1, i2, i3);
+  assert (f == n);
+  unused (f);
+  mesh.prune ();
+  assert (mesh.numFaces () == n);
+  checkEdges (mesh);
+}
+
+void TestAdjacency::test3 ()
+{
+  DynamicMesh  mesh (MeshUtil::icosphere (2));
+  DynamicFaces faces;
+  mesh.forEachFace ([&faces](unsigned int f) { faces.insert (f); });
+  faces.commit ();
+
+  // visits each edge once, the twin of its half-edge belongs to the adjacent face
+  unsigned int numEdges = 0;
+  mesh.forEachEdge (faces, [&mesh, &numEdges](unsigned int h) {
+    const unsigned int t = mesh.twin (h);
+    assert (mesh.halfEdgeSource (t) == mesh.halfEdgeTarget (h));
+    assert (mesh.halfEdgeTarget (t) == mesh.halfEdgeSource (h));
+
+    unsigned int leftFace, leftVertex, rightFace, rightVertex;
+    mesh.findAdjacent (h, leftFace, leftVertex, rightFace, rightVertex);
+    assert (leftFace == h / 3);
+    assert (rightFace == t / 3);
+    unused (t);
+    numEdges++;
+  });
+  assert (2 * numEdges == 3 * mesh.numFaces ());
+
+  DynamicFaces singleFace;
+  singleFace.insert (0);
+  singleFace.commit ();
+
+  numEdges = 0;
+  mesh.forEachEdge (singleFace, [&numEdges](unsigned int h) {
+    assert (h / 3 == 0);
+    unused (h);
+    numEdges++;
+  });
+  assert (numEdges == 3);
+
+  // flips an edge but adds the new faces before deleting the old ones: until then, half-edges of
+  // the new faces run along edges of two other faces and are linked once the old faces are deleted
+  const unsigned int i1 = mesh.halfEdgeSource (0);
+  const unsigned int i2 = mesh.halfEdgeTarget (0);
+
+  unsigned int leftFace, leftVertex, rightFace, rightVertex;
+  mesh.findAdjacent (0, leftFace, leftVertex, rightFace, rightVertex);
+  mesh.addFace (leftVertex, i1, rightVertex);
+  mesh.addFace (rightVertex, i2, leftVertex);
+  mesh.deleteFace (leftFace);
+  mesh.deleteFace (rightFace);
+  assert (mesh.checkConsistency ());
+  checkEdges (mesh);
+  unused (numEdges);
+}
@@ -0,0 +1,230 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <limits>
+#include <random>
+#include <unordered_set>
+#include "distance.hpp"
+#include "dynamic/bvh.hpp"
+#include "intersection.hpp"
+#include "primitive/ray.hpp"
+#include "primitive/sphere.hpp"
+#include "primitive/triangle.hpp"
+#include "test-bvh.hpp"
+#include "util.hpp"
+
+namespace
+{
+  PrimTriangle triangle (const std::vector<glm::vec3>& vertices, unsigned int i)
+  {
+    return PrimTriangle (vertices[(3 * i) + 0], vertices[(3 * i) + 1], vertices[(3 * i) + 2]);
+  }
+
+  bool isDeleted (const std::vector<glm::vec3>& vertices, unsigned int i)
+  {
+    return Util::isNaN (vertices[3 * i]);
+  }
+
+  float closestIntersection (const DynamicBVH& bvh, const std::vector<glm::vec3>& vertices,
+                             const PrimRay& ray)
+  {
+    float closest = Util::maxFloat ();
+    bvh.intersects (ray, [&vertices, &ray, &closest](unsigned int i) {
+      float t;
+      if (IntersectionUtil::intersects (ray, triangle (vertices, i), false, &t))
+      {
+        closest = glm::min (closest, t);
+        return t;
+      }
+      return Util::maxFloat ();
+    });
+    return closest;
+  }
+
+  float bruteForceClosestIntersection (const std::vector<glm::vec3>& vertices, const PrimRay& ray)
+  {
+    float closest = Util::maxFloat ();
+    for (unsigned int i = 0; i < vertices.size () / 3; i++)
+    {
+      float t;
+      if (isDeleted (vertices, i) == false &&
+          IntersectionUtil::intersects (ray, triangle (vertices, i), false, &t))
+      {
+        closest = glm::min (closest, t);
+      }
+    }
+    return closest;
+  }
+
+  bool checkQueries (const DynamicBVH& bvh, const std::vector<glm::vec3>& vertices,
+                     std::default_random_engine& gen)
+  {
+    std::uniform_real_distribution<float> posD (-10.0f, 10.0f);
+    std::uniform_real_distribution<float> radiusD (0.1f, 3.0f);
+
+    for (unsigned int i = 0; i < 50; i++)
+    {
+      const PrimRay ray (glm::vec3 (posD (gen), posD (gen), posD (gen)),
+                         glm::normalize (glm::vec3 (posD (gen), posD (gen), posD (gen))));
+
+      if (closestIntersection (bvh, vertices, ray) !=
+          bruteForceClosestIntersection (vertices, ray))
+      {
+        return false;
+      }
+    }
+
+    for (unsigned int i = 0; i < 10; i++)
+    {
+      const glm::vec3 p (posD (gen), posD (gen), posD (gen));
+      float           minDistance = Util::maxFloat ();
+
+      for (unsigned int j = 0; j < vertices.size () / 3; j++)
+      {
+        if (isDeleted (vertices, j) == false)
+        {
+          minDistance = glm::min (minDistance, Distance::distance (triangle (vertices, j), p));
+        }
+      }
+      const float distance = bvh.distance (p, [&vertices, &p](unsigned int j) {
+        return Distance::distance (triangle (vertices, j), p);
+      });
+
+      if (distance != minDistance)
+      {
+        return false;
+      }
+    }
+
+    for (unsigned int i = 0; i < 10; i++)
+    {
+      const PrimSphere                 sphere (glm::vec3 (posD (gen), posD (gen), posD (gen)),
+                                               radiusD (gen));
+      std::unordered_set<unsigned int> found;
+
+      bvh.intersects (sphere, [&found](bool, unsigned int j) { found.insert (j); });
+
+      for (unsigned int j = 0; j < vertices.size () / 3; j++)
+      {
+        if (isDeleted (vertices, j) == false &&
+            IntersectionUtil::intersects (sphere, triangle (vertices, j)) && found.count (j) == 0)
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+}
+
+void TestBVH::test ()
+{
+  const unsigned int numSamples = 5000;
+
+  std::default_random_engine            gen;
+  std::uniform_real_distribution<float> posD (-10.0f, 10.0f);
+  std::uniform_real_distribution<float> offsetD (-0.5f, 0.5f);
+  std::uniform_real_distribution<float> moveD (-2.0f, 2.0f);
+  std::vector<glm::vec3>                vertices;
+  DynamicBVH                            bvh;
+
+  for (unsigned int i = 0; i < numSamples; i++)
+  {
+    const glm::vec3 p (posD (gen), posD (gen), posD (gen));
+
+    vertices.push_back (p + glm::vec3 (offsetD (gen), offsetD (gen), offsetD (gen)));
+    vertices.push_back (p + glm::vec3 (offsetD (gen), offsetD (gen), offsetD (gen)));
+    vertices.push_back (p + glm::vec3 (offsetD (gen), offsetD (gen), offsetD (gen)));
+
+    const PrimTriangle tri = triangle (vertices, i);
+    bvh.addElement (i, tri.minimum (), tri.maximum ());
+  }
+  assert (checkQueries (bvh, vertices, gen));
+
+  bvh.rebuild ();
+  assert (checkQueries (bvh, vertices, gen));
+
+  for (unsigned int i = 0; i < numSamples; i += 2)
+  {
+    const glm::vec3 move (moveD (gen), moveD (gen), moveD (gen));
+
+    vertices[(3 * i) + 0] += move;
+    vertices[(3 * i) + 1] += move;
+    vertices[(3 * i) + 2] += move;
+
+    const PrimTriangle tri = triangle (vertices, i);
+    bvh.realignElement (i, tri.minimum (), tri.maximum ());
+  }
+  assert (checkQueries (bvh, vertices, gen));
+
+  bvh.refit ();
+  assert (checkQueries (bvh, vertices, gen));
+
+  // copies share their nodes until they are modified: changing a copy leaves the original intact
+  {
+    const std::size_t      bytes = bvh.memoryBytes ();
+    DynamicBVH             copy (bvh);
+    std::vector<glm::vec3> copyVertices (vertices);
+    assert (bvh.memoryBytes () < bytes);
+
+    for (unsigned int i = 1; i < numSamples; i += 4)
+    {
+      copy.deleteElement (i);
+      copyVertices[3 * i] = glm::vec3 (std::numeric_limits<float>::quiet_NaN ());
+    }
+    copy.refit ();
+    assert (checkQueries (copy, copyVertices, gen));
+    assert (checkQueries (bvh, vertices, gen));
+    unused (bytes);
+  }
+
+  for (unsigned int i = 0; i < numSamples; i += 3)
+  {
+    bvh.deleteElement (i);
+    vertices[3 * i] = glm::vec3 (std::numeric_limits<float>::quiet_NaN ());
+  }
+  bvh.refit ();
+  assert (checkQueries (bvh, vertices, gen));
+
+  std::vector<unsigned int> newIndices;
+  std::vector<glm::vec3>    newVertices;
+  for (unsigned int i = 0; i < numSamples; i++)
+  {
+    if (isDeleted (vertices, i))
+    {
+      newIndices.push_back (Util::invalidIndex ());
+    }
+    else
+    {
+      newIndices.push_back (newVertices.size () / 3);
+      newVertices.push_back (vertices[(3 * i) + 0]);
+      newVertices.push_back (vertices[(3 * i) + 1]);
+      newVertices.push_back (vertices[(3 * i) + 2]);
+    }
+  }
+  const std::size_t uncompactedBytes = bvh.memoryBytes ();
+  bvh.updateIndices (newIndices);
+  assert (bvh.memoryBytes () < uncompactedBytes);
+  assert (checkQueries (bvh, newVertices, gen));
+
+  // empty leaves are deleted right away: only the leaf of the last element remains
+  const unsigned int numNewSamples = newVertices.size () / 3;
+  for (unsigned int i = 0; i + 1 < numNewSamples; i++)
+  {
+    bvh.deleteElement (i);
+    newVertices[3 * i] = glm::vec3 (std::numeric_limits<float>::quiet_NaN ());
+  }
+  assert (bvh.numNodes () == 1);
+  assert (checkQueries (bvh, newVertices, gen));
+
+  bvh.refit ();
+  assert (checkQueries (bvh, newVertices, gen));
+
+  bvh.deleteElement (numNewSamples - 1);
+  assert (bvh.isEmpty ());
+  assert (bvh.numNodes () == 0);
+  unused (uncompactedBytes);
+  unused (checkQueries);
+}
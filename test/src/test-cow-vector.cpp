@@ -0,0 +1,76 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cassert>
+#include <vector>
+#include "cow-vector.hpp"
+#include "test-cow-vector.hpp"
+#include "util.hpp"
+
+namespace
+{
+  typedef CowVector<unsigned int, 4> Vector;
+
+  bool equals (const Vector& v, const std::vector<unsigned int>& w)
+  {
+    if (v.size () != w.size ())
+    {
+      return false;
+    }
+    for (unsigned int i = 0; i < w.size (); i++)
+    {
+      if (v[i] != w[i])
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+void TestCowVector::test ()
+{
+  Vector v;
+  assert (v.empty ());
+
+  for (unsigned int i = 0; i < 10; i++)
+  {
+    v.push_back (i);
+  }
+  assert (equals (v, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  assert (v.numChunks () == 3);
+  assert (v.chunk (2).size () == 2);
+
+  // copies share all chunks until they are modified
+  const std::size_t bytes = v.memoryBytes ();
+  Vector            copy (v);
+  assert (v.numSharedChunks () == 3);
+  assert (v.memoryBytes () < bytes);
+
+  copy.set (5, 50);
+  assert (equals (v, {0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+  assert (equals (copy, {0, 1, 2, 3, 4, 50, 6, 7, 8, 9}));
+  assert (v.numSharedChunks () == 2);
+
+  copy.pop_back ();
+  copy.pop_back ();
+  assert (copy.numChunks () == 2);
+  assert (v.numSharedChunks () == 1);
+  assert (v.back () == 9);
+
+  v.resize (6);
+  assert (equals (v, {0, 1, 2, 3, 4, 5}));
+  v.resize (9, 7);
+  assert (equals (v, {0, 1, 2, 3, 4, 5, 7, 7, 7}));
+
+  v.assign ({3, 2, 1});
+  assert (equals (v, {3, 2, 1}));
+  assert (equals (copy, {0, 1, 2, 3, 4, 50, 6, 7}));
+
+  v.clear ();
+  assert (v.empty () && v.numChunks () == 0);
+  assert (copy.numSharedChunks () == 0);
+
+  unused (equals);
+}
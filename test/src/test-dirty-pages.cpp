@@ -0,0 +1,84 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cassert>
+#include <glm/glm.hpp>
+#include <vector>
+#include "dirty-pages.hpp"
+#include "test-dirty-pages.hpp"
+#include "util.hpp"
+
+namespace
+{
+  constexpr unsigned int pageSize = DirtyPages::pageSize;
+  constexpr unsigned int chunkSize = 64 * pageSize;
+
+  unsigned int numBytes (const std::vector<DirtyPages::Range>& ranges)
+  {
+    unsigned int n = 0;
+    for (const DirtyPages::Range& r : ranges)
+    {
+      n += r.size;
+    }
+    return n;
+  }
+}
+
+void TestDirtyPages::test ()
+{
+  const unsigned int n = 10000;
+  const unsigned int dataSize = n * sizeof (glm::vec3);
+  const unsigned int lastPageBytes = dataSize - (((dataSize - 1) / pageSize) * pageSize);
+
+  DirtyPages pages;
+  assert (pages.isDirty () == false);
+  assert (pages.ranges (dataSize, chunkSize).empty ());
+
+  // everything is split at chunk borders
+  pages.markAll (dataSize);
+  std::vector<DirtyPages::Range> ranges = pages.ranges (dataSize, chunkSize);
+  assert (pages.isDirty ());
+  assert (ranges.size () == 1 && ranges[0].offset == 0 && ranges[0].size == dataSize);
+
+  ranges = pages.ranges (dataSize, 2 * pageSize);
+  assert (ranges.size () == (dataSize + (2 * pageSize) - 1) / (2 * pageSize));
+  assert (ranges[1].offset == 2 * pageSize && ranges[1].size == 2 * pageSize);
+  assert (numBytes (ranges) == dataSize);
+
+  pages.clear ();
+  assert (pages.isDirty () == false);
+  assert (pages.ranges (dataSize, chunkSize).empty ());
+
+  // a change at the start and one at the end mark two pages, not everything in between
+  pages.mark (0, sizeof (glm::vec3));
+  pages.mark ((n - 1) * sizeof (glm::vec3), sizeof (glm::vec3));
+  ranges = pages.ranges (dataSize, chunkSize);
+  assert (ranges.size () == 2);
+  assert (ranges[0].offset == 0 && ranges[0].size == pageSize);
+  assert (ranges[1].size == lastPageBytes && ranges[1].offset + ranges[1].size == dataSize);
+  pages.clear ();
+
+  // adjacent dirty pages form one range
+  pages.mark (pageSize + 12, sizeof (glm::vec3));
+  pages.mark ((2 * pageSize) + 12, sizeof (glm::vec3));
+  ranges = pages.ranges (dataSize, chunkSize);
+  assert (ranges.size () == 1);
+  assert (ranges[0].offset == pageSize && ranges[0].size == 2 * pageSize);
+  pages.clear ();
+
+  // an element that straddles two pages marks both
+  pages.mark (pageSize - 4, sizeof (glm::vec3));
+  ranges = pages.ranges (dataSize, chunkSize);
+  assert (ranges.size () == 1);
+  assert (ranges[0].offset == 0 && ranges[0].size == 2 * pageSize);
+  pages.clear ();
+
+  // pages behind the end of the data are ignored
+  pages.mark (dataSize + pageSize, sizeof (glm::vec3));
+  assert (pages.isDirty ());
+  assert (pages.ranges (dataSize, chunkSize).empty ());
+
+  unused (lastPageBytes);
+  unused (ranges);
+}
@@ -0,0 +1,13 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#ifndef DILAY_TEST_DIRTY_PAGES
+#define DILAY_TEST_DIRTY_PAGES
+
+namespace TestDirtyPages
+{
+  void test ();
+}
+
+#endif
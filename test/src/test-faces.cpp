@@ -0,0 +1,79 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cassert>
+#include "dynamic/faces.hpp"
+#include "test-faces.hpp"
+
+void TestFaces::test ()
+{
+  // runs twice, so that the second run reuses recycled stamps
+  for (unsigned int run = 0; run < 2; run++)
+  {
+    DynamicFaces faces;
+    assert (faces.isEmpty ());
+
+    faces.insert (5);
+    faces.insert (3);
+    faces.insert (5);
+    assert (faces.uncommitted ().size () == 2);
+    assert (faces.contains (5) == false);
+
+    faces.commit ();
+    assert (faces.contains (3) && faces.contains (5));
+    assert (faces.numElements () == 2);
+
+    // inserting a committed face adds it to the uncommitted faces again
+    faces.insert (100);
+    faces.insert (3);
+    faces.insert (3);
+    assert (faces.uncommitted ().size () == 2);
+
+    DynamicFaces copy (faces);
+    assert (copy.contains (3) && copy.contains (100) == false);
+    assert (copy.uncommitted ().size () == 2);
+
+    faces.filter ([](unsigned int i) { return i != 3; });
+    assert (faces.contains (3) == false);
+    assert (faces.numElements () == 1);
+    assert (faces.uncommitted ().size () == 1);
+    assert (copy.contains (3));
+
+    // committing does not duplicate committed faces
+    copy.commit ();
+    assert (copy.numElements () == 3);
+    assert (copy.contains (3) && copy.contains (5) && copy.contains (100));
+
+    copy.insert (5);
+    copy.resetCommitted ();
+    assert (copy.contains (5) == false && copy.uncommitted ().size () == 1);
+    copy.commit ();
+    assert (copy.numElements () == 1 && copy.contains (5));
+    copy.insert (3);
+    copy.insert (100);
+    copy.commit ();
+
+    faces.insert (3);
+    faces.commit ();
+    assert (faces.contains (3) && faces.contains (100));
+
+    faces.resetCommitted ();
+    assert (faces.isEmpty ());
+    assert (faces.contains (3) == false);
+
+    faces.insert (7);
+    faces.commit ();
+    faces.reset ();
+    assert (faces.isEmpty ());
+    assert (faces.contains (7) == false);
+
+    DynamicFaces moved (std::move (copy));
+    assert (copy.isEmpty () && copy.contains (3) == false);
+    assert (moved.contains (3));
+
+    copy = moved;
+    moved.reset ();
+    assert (copy.contains (3) && moved.contains (3) == false);
+  }
+}
@@ -0,0 +1,514 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <glm/glm.hpp>
+#include <thread>
+#include <vector>
+#include "config.hpp"
+#include "dynamic/mesh.hpp"
+#include "history.hpp"
+#include "memory-usage.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "scene.hpp"
+#include "test-history.hpp"
+#include "util.hpp"
+
+namespace
+{
+  DynamicMesh& theMesh (Scene& scene)
+  {
+    assert (scene.numDynamicMeshes () == 1);
+
+    DynamicMesh* mesh = nullptr;
+    scene.forEachMesh ([&mesh](DynamicMesh& m) { mesh = &m; });
+    return *mesh;
+  }
+
+  // compares the slots of both meshes, i.e., restored meshes must not have been pruned
+  bool equals (Scene& scene, const DynamicMesh& b)
+  {
+    const DynamicMesh& a = theMesh (scene);
+
+    if (a.mesh ().numVertices () != b.mesh ().numVertices () ||
+        a.mesh ().numIndices () != b.mesh ().numIndices () || a.numFaces () != b.numFaces ())
+    {
+      return false;
+    }
+    for (unsigned int i = 0; i < a.mesh ().numVertices (); i++)
+    {
+      if (a.isFreeVertex (i) != b.isFreeVertex (i) ||
+          (a.isFreeVertex (i) == false && a.vertex (i) != b.vertex (i)))
+      {
+        return false;
+      }
+    }
+    for (unsigned int i = 0; i < a.mesh ().numIndices (); i++)
+    {
+      if (a.isFreeFace (i / 3) != b.isFreeFace (i / 3) ||
+          (a.isFreeFace (i / 3) == false && a.mesh ().index (i) != b.mesh ().index (i)))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // the sorted positions of the faces' vertices, i.e., independent of their slots
+  std::vector<std::vector<float>> triangles (const DynamicMesh& mesh)
+  {
+    std::vector<std::vector<float>> result;
+
+    for (unsigned int i = 0; i < mesh.mesh ().numIndices () / 3; i++)
+    {
+      if (mesh.isFreeFace (i) == false)
+      {
+        std::vector<float> triangle;
+        for (unsigned int k = 0; k < 3; k++)
+        {
+          const glm::vec3& v = mesh.vertex (mesh.mesh ().index ((3 * i) + k));
+          triangle.insert (triangle.end (), {v.x, v.y, v.z});
+        }
+        result.push_back (triangle);
+      }
+    }
+    std::sort (result.begin (), result.end ());
+    return result;
+  }
+
+  void move (Scene& scene, float factor)
+  {
+    DynamicMesh& mesh = theMesh (scene);
+
+    for (unsigned int i = 0; i < mesh.numVertices (); i += 3)
+    {
+      mesh.vertex (i, factor * mesh.vertex (i));
+    }
+    mesh.setAllNormals ();
+    mesh.sanitize ();
+  }
+
+  // deletes every other vertex: more than a quarter of the faces become free
+  void thin (Scene& scene)
+  {
+    DynamicMesh& mesh = theMesh (scene);
+
+    for (unsigned int i = 0; i < mesh.mesh ().numVertices (); i += 2)
+    {
+      mesh.deleteVertex (i);
+    }
+    mesh.sanitize ();
+  }
+
+  void testDeltas (const Config& config)
+  {
+    Scene   scene (config);
+    History history (config);
+
+    scene.newDynamicMesh (config, MeshUtil::icosphere (2));
+    const DynamicMesh original (theMesh (scene));
+
+    history.recordDynamicMeshes (scene);
+    move (scene, 1.1f);
+    history.finishRecording ();
+    const DynamicMesh moved (theMesh (scene));
+
+    assert (history.numSnapshots () == 1);
+    assert (equals (scene, original) == false);
+
+    history.undo (config, scene);
+    assert (equals (scene, original));
+    history.redo (config, scene);
+    assert (equals (scene, moved));
+    history.undo (config, scene);
+    assert (equals (scene, original));
+    assert (history.numSnapshots () == 1);
+  }
+
+  void testSparse (const Config& config)
+  {
+    Scene   scene (config);
+    History history (config);
+
+    scene.newDynamicMesh (config, MeshUtil::icosphere (2));
+    const DynamicMesh original (theMesh (scene));
+
+    history.recordDynamicMeshes (scene);
+    thin (scene);
+    assert (theMesh (scene).isSparse ());
+    history.finishRecording ();
+
+    // the sparse mesh is compacted while it is recorded
+    const DynamicMesh thinned (theMesh (scene));
+    assert (thinned.isSparse () == false);
+    assert (thinned.mesh ().numVertices () == thinned.numVertices ());
+
+    history.undo (config, scene);
+    assert (equals (scene, original));
+    history.redo (config, scene);
+    assert (equals (scene, thinned));
+  }
+
+  // a very sparse mesh is compacted over several recordings, which are undone one by one
+  void testCompaction (const Config& config)
+  {
+    Scene   scene (config);
+    History history (config);
+
+    scene.newDynamicMesh (config, MeshUtil::icosphere (6));
+
+    std::vector<DynamicMesh> states;
+    states.emplace_back (theMesh (scene));
+
+    history.recordDynamicMeshes (scene);
+    thin (scene);
+    history.finishRecording ();
+    states.emplace_back (theMesh (scene));
+    assert (theMesh (scene).isSparse ());
+
+    while (theMesh (scene).isSparse ())
+    {
+      history.recordDynamicMeshes (scene);
+      history.finishRecording ();
+      states.emplace_back (theMesh (scene));
+      assert (triangles (states.back ()) == triangles (states[1]));
+    }
+    assert (states.size () > 2);
+    assert (states.back ().mesh ().numVertices () < states[1].mesh ().numVertices ());
+
+    for (unsigned int i = states.size () - 1; i > 0; i--)
+    {
+      history.undo (config, scene);
+      assert (equals (scene, states[i - 1]));
+    }
+    for (unsigned int i = 1; i < states.size (); i++)
+    {
+      history.redo (config, scene);
+      assert (equals (scene, states[i]));
+    }
+  }
+
+  // cf. `ToolSculptAction::sculpt`: a mesh that is emptied while recording is deleted
+  void testEmptied (const Config& config)
+  {
+    Scene   scene (config);
+    History history (config);
+
+    scene.newDynamicMesh (config, MeshUtil::icosphere (1));
+    const DynamicMesh original (theMesh (scene));
+
+    history.recordDynamicMeshes (scene);
+    DynamicMesh& mesh = theMesh (scene);
+    for (unsigned int i = 0; i < mesh.mesh ().numVertices (); i++)
+    {
+      mesh.deleteVertex (i);
+    }
+    assert (mesh.isEmpty ());
+    history.finishRecording ();
+    scene.deleteEmptyMeshes ();
+    assert (scene.numDynamicMeshes () == 0);
+
+    history.undo (config, scene);
+    assert (equals (scene, original));
+    history.redo (config, scene);
+    assert (scene.numDynamicMeshes () == 0);
+  }
+
+  void testMixed (const Config& config)
+  {
+    Scene   scene (config);
+    History history (config);
+
+    scene.newDynamicMesh (config, MeshUtil::icosphere (2));
+
+    std::vector<DynamicMesh> states;
+    states.emplace_back (theMesh (scene));
+
+    for (unsigned int i = 0; i < 4; i++)
+    {
+      if (i % 2 == 0)
+      {
+        history.snapshotDynamicMeshes (scene);
+        move (scene, 1.1f);
+      }
+      else
+      {
+        history.recordDynamicMeshes (scene);
+        move (scene, 0.95f);
+        history.finishRecording ();
+      }
+      states.emplace_back (theMesh (scene));
+    }
+    assert (history.numSnapshots () == 4);
+
+    for (unsigned int i = 4; i > 0; i--)
+    {
+      history.undo (config, scene);
+      assert (equals (scene, states[i - 1]));
+    }
+    for (unsigned int i = 1; i <= 4; i++)
+    {
+      history.redo (config, scene);
+      assert (equals (scene, states[i]));
+    }
+
+    // a new recording drops the undone snapshots
+    history.undo (config, scene);
+    history.undo (config, scene);
+    history.recordDynamicMeshes (scene);
+    move (scene, 1.2f);
+    history.finishRecording ();
+    assert (history.numSnapshots () == 3);
+
+    history.undo (config, scene);
+    assert (equals (scene, states[2]));
+    history.redo (config, scene);
+    history.redo (config, scene);
+    assert (history.numSnapshots () == 3);
+  }
+
+  // deltas behind the front of a timeline are compressed: undo and redo must restore them exactly
+  void testCompressedDeltas (const Config& config)
+  {
+    Scene   scene (config);
+    History history (config);
+
+    scene.newDynamicMesh (config, MeshUtil::icosphere (3));
+
+    std::vector<DynamicMesh> states;
+    states.emplace_back (theMesh (scene));
+
+    for (unsigned int i = 0; i < 4; i++)
+    {
+      history.recordDynamicMeshes (scene);
+      move (scene, 1.0f + (0.01f * float (i + 1)));
+      theMesh (scene).deleteVertex (7 * (i + 1));
+      history.finishRecording ();
+      states.emplace_back (theMesh (scene));
+    }
+    assert (history.numSnapshots () == 4);
+
+    for (unsigned int i = 4; i > 0; i--)
+    {
+      history.undo (config, scene);
+      assert (equals (scene, states[i - 1]));
+    }
+    for (unsigned int i = 1; i <= 4; i++)
+    {
+      history.redo (config, scene);
+      assert (equals (scene, states[i]));
+    }
+  }
+
+  // compressions and loads run in the background: `fromConfig` finishes those that are done
+  void waitFor (History& history, const Config& config, const std::function<bool()>& condition)
+  {
+    while (condition () == false)
+    {
+      std::this_thread::sleep_for (std::chrono::milliseconds (1));
+      history.fromConfig (config);
+    }
+  }
+
+  // snapshots behind the undo window are spilled to disk and loaded again when they are needed
+  void testSpilling (Config& config)
+  {
+    const unsigned int numSteps = 6;
+    const int          window = config.get<int> ("editor/undo-window");
+
+    Scene   scene (config);
+    History history (config);
+
+    scene.newDynamicMesh (config, MeshUtil::icosphere (3));
+
+    std::vector<DynamicMesh> states;
+    states.emplace_back (theMesh (scene));
+
+    config.set<int> ("editor/undo-window", 1);
+    history.fromConfig (config);
+
+    for (unsigned int i = 0; i < numSteps; i++)
+    {
+      history.recordDynamicMeshes (scene);
+      move (scene, 1.0f + (0.01f * float (i + 1)));
+      theMesh (scene).deleteVertex (5 * (i + 1));
+      history.finishRecording ();
+      states.emplace_back (theMesh (scene));
+    }
+    waitFor (history, config, [&history]() { return history.spilledBytes () > 0; });
+    assert (history.numSnapshots () == numSteps);
+
+    // undo and redo load the spilled snapshots
+    for (unsigned int i = numSteps; i > numSteps / 2; i--)
+    {
+      history.undo (config, scene);
+      assert (equals (scene, states[i - 1]));
+    }
+    for (unsigned int i = (numSteps / 2) + 1; i <= numSteps; i++)
+    {
+      history.redo (config, scene);
+      assert (equals (scene, states[i]));
+    }
+
+    // widening the window prefetches all snapshots
+    config.set<int> ("editor/undo-window", int(numSteps));
+    history.fromConfig (config);
+    waitFor (history, config, [&history]() { return history.spilledBytes () == 0; });
+
+    for (unsigned int i = numSteps; i > 0; i--)
+    {
+      history.undo (config, scene);
+      assert (equals (scene, states[i - 1]));
+    }
+    assert (history.numSnapshots () == numSteps);
+
+    config.set<int> ("editor/undo-window", window);
+  }
+
+  // names of the files that snapshots are spilled to, cf. `History`
+  QStringList spillFiles ()
+  {
+    return QDir (QDir::tempPath ()).entryList (QStringList ("dilay-undo-*"), QDir::Files);
+  }
+
+  // a snapshot whose spill file is lost cannot be undone: it is dropped and the scene is kept
+  void testLostSpillFiles (Config& config)
+  {
+    const unsigned int numSteps = 4;
+    const int          window = config.get<int> ("editor/undo-window");
+    const QStringList  otherFiles = spillFiles ();
+
+    Scene   scene (config);
+    History history (config);
+
+    scene.newDynamicMesh (config, MeshUtil::icosphere (3));
+
+    std::vector<DynamicMesh> states;
+    states.emplace_back (theMesh (scene));
+
+    config.set<int> ("editor/undo-window", 1);
+    history.fromConfig (config);
+
+    for (unsigned int i = 0; i < numSteps; i++)
+    {
+      history.recordDynamicMeshes (scene);
+      move (scene, 1.0f + (0.01f * float (i + 1)));
+      history.finishRecording ();
+      states.emplace_back (theMesh (scene));
+    }
+    waitFor (history, config, [&history]() { return history.spilledBytes () > 0; });
+
+    const QDir tempDir (QDir::tempPath ());
+    for (const QString& name : spillFiles ())
+    {
+      if (otherFiles.contains (name) == false)
+      {
+        QFile::remove (tempDir.filePath (name));
+      }
+    }
+
+    // widening the window loads the spilled snapshots in the background
+    config.set<int> ("editor/undo-window", int(numSteps));
+    history.fromConfig (config);
+    waitFor (history, config, [&history]() { return history.spilledBytes () == 0; });
+
+    unsigned int numUndone = 0;
+    while (history.numSnapshots () == numSteps && numUndone < numSteps)
+    {
+      history.undo (config, scene);
+      if (history.numSnapshots () == numSteps)
+      {
+        numUndone++;
+      }
+      assert (equals (scene, states[numSteps - numUndone]));
+    }
+    assert (numUndone < numSteps);
+    assert (history.numSnapshots () == numUndone);
+
+    for (unsigned int i = numUndone; i > 0; i--)
+    {
+      history.redo (config, scene);
+      assert (equals (scene, states[numSteps - i + 1]));
+    }
+    config.set<int> ("editor/undo-window", window);
+  }
+
+  void testEviction (Config& config)
+  {
+    const unsigned int numSteps = 6;
+    const std::size_t  mebibyte = 1024 * 1024;
+
+    Scene   scene (config);
+    History history (config);
+
+    scene.newDynamicMesh (config, MeshUtil::icosphere (6));
+
+    std::vector<DynamicMesh> states;
+    states.emplace_back (theMesh (scene));
+
+    for (unsigned int i = 0; i < numSteps; i++)
+    {
+      history.snapshotDynamicMeshes (scene);
+      move (scene, 1.01f);
+      states.emplace_back (theMesh (scene));
+    }
+    assert (history.numSnapshots () == numSteps);
+
+    // a budget for about half of the snapshots
+    const int budget = int(history.memoryUsage ().total () / (2 * mebibyte));
+    assert (budget > 0);
+
+    config.set<int> ("editor/undo-memory", budget);
+    history.fromConfig (config);
+
+    const unsigned int numKept = history.numSnapshots ();
+    assert (numKept > 1 && numKept < numSteps);
+
+    // the oldest snapshots have been dropped
+    for (unsigned int i = numSteps; i > numSteps - numKept; i--)
+    {
+      history.undo (config, scene);
+      assert (equals (scene, states[i - 1]));
+    }
+    history.undo (config, scene);
+    assert (equals (scene, states[numSteps - numKept]));
+
+    // undo steps may have dropped distant redo snapshots, but not the next one
+    history.redo (config, scene);
+    assert (equals (scene, states[numSteps - numKept + 1]));
+
+    // the most recent snapshot is always kept
+    config.set<int> ("editor/undo-memory", 0);
+    history.fromConfig (config);
+    assert (history.numSnapshots () == 1);
+
+    history.undo (config, scene);
+    assert (equals (scene, states[numSteps - numKept]));
+  }
+}
+
+void TestHistory::test ()
+{
+  Config config;
+
+  testDeltas (config);
+  testSparse (config);
+  testCompaction (config);
+  testEmptied (config);
+  testMixed (config);
+  testCompressedDeltas (config);
+  testSpilling (config);
+  testLostSpillFiles (config);
+  testEviction (config);
+
+  unused (equals);
+  unused (triangles);
+}
@@ -0,0 +1,155 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <cassert>
+#include <functional>
+#include <glm/glm.hpp>
+#include <sstream>
+#include <string>
+#include "config.hpp"
+#include "dynamic/mesh.hpp"
+#include "import-export.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "scene.hpp"
+#include "test-import-export.hpp"
+#include "util.hpp"
+
+namespace
+{
+  // splits a face into three faces around a new vertex: the mesh stays closed
+  unsigned int splitFace (DynamicMesh& mesh, unsigned int f)
+  {
+    unsigned int i1, i2, i3;
+    mesh.vertexIndices (f, i1, i2, i3);
+
+    const glm::vec3    center = (mesh.vertex (i1) + mesh.vertex (i2) + mesh.vertex (i3)) / 3.0f;
+    const unsigned int c = mesh.addVertex (center, mesh.faceNormal (f));
+
+    mesh.deleteFace (f);
+    mesh.addFace (i1, i2, c);
+    mesh.addFace (i2, i3, c);
+    mesh.addFace (i3, i1, c);
+    return c;
+  }
+
+  // reverts `splitFace`: frees the new vertex and two of the three face slots
+  void joinFaces (DynamicMesh& mesh, unsigned int c)
+  {
+    const DynamicAdjacency::Faces faces = mesh.adjacentFaces (c);
+    unsigned int                  corners[3] = {Util::invalidIndex (), Util::invalidIndex (),
+                                                Util::invalidIndex ()};
+
+    assert (faces.size () == 3);
+    for (unsigned int k = 0; k < 3; k++)
+    {
+      unsigned int i[3];
+      mesh.vertexIndices (faces[k], i[0], i[1], i[2]);
+
+      const unsigned int ci = i[0] == c ? 0 : (i[1] == c ? 1 : 2);
+
+      // the corners follow `c` in the orientation of the split face
+      if (k == 0)
+      {
+        corners[0] = i[(ci + 1) % 3];
+        corners[1] = i[(ci + 2) % 3];
+      }
+      else if (i[(ci + 1) % 3] == corners[1])
+      {
+        corners[2] = i[(ci + 2) % 3];
+      }
+    }
+    assert (corners[2] != Util::invalidIndex ());
+
+    // also deletes the adjacent faces
+    mesh.deleteVertex (c);
+    mesh.addFace (corners[0], corners[1], corners[2]);
+  }
+
+  unsigned int numFree (unsigned int numSlots, const std::function<bool(unsigned int)>& isFree)
+  {
+    unsigned int n = 0;
+    for (unsigned int i = 0; i < numSlots; i++)
+    {
+      n += isFree (i) ? 1 : 0;
+    }
+    return n;
+  }
+}
+
+void TestImportExport::test ()
+{
+  const Config config;
+  Scene        scene (config);
+  DynamicMesh& mesh = scene.newDynamicMesh (config, MeshUtil::icosphere (2));
+
+  const unsigned int c1 = splitFace (mesh, 3);
+  splitFace (mesh, 17);
+  const unsigned int c2 = splitFace (mesh, 29);
+  splitFace (mesh, 41);
+  joinFaces (mesh, c1);
+  joinFaces (mesh, c2);
+
+  const unsigned int numVertexSlots = mesh.mesh ().numVertices ();
+  const unsigned int numFaceSlots = mesh.mesh ().numIndices () / 3;
+  const unsigned int numFreeVertices =
+    numFree (numVertexSlots, [&mesh](unsigned int i) { return mesh.isFreeVertex (i); });
+  const unsigned int numFreeFaces =
+    numFree (numFaceSlots, [&mesh](unsigned int i) { return mesh.isFreeFace (i); });
+
+  assert (numFreeVertices == 2);
+  assert (numFreeFaces == 4);
+  assert (mesh.checkConsistency ());
+
+  std::ostringstream written;
+  ImportExport::toDlyFile (written, scene, false);
+
+  // writing does not prune the scene's mesh
+  assert (mesh.mesh ().numVertices () == numVertexSlots);
+  assert (mesh.mesh ().numIndices () == 3 * numFaceSlots);
+
+  const Config       loadConfig;
+  Scene              loaded (loadConfig);
+  std::istringstream input (written.str ());
+
+  const bool success = ImportExport::fromDlyFile (input, loadConfig, loaded);
+  assert (success);
+  assert (loaded.numDynamicMeshes () == 1);
+
+  loaded.forEachConstMesh ([&](const DynamicMesh& l) {
+    assert (l.numVertices () == numVertexSlots - numFreeVertices);
+    assert (l.numFaces () == numFaceSlots - numFreeFaces);
+    assert (l.mesh ().numVertices () == l.numVertices ());
+    assert (l.mesh ().numIndices () == 3 * l.numFaces ());
+    unused (l);
+  });
+
+  // the loaded mesh is written exactly like the mesh with free vertices and faces
+  std::ostringstream rewritten;
+  ImportExport::toDlyFile (rewritten, loaded, false);
+  assert (rewritten.str () == written.str ());
+
+  // a corrupt octree is rebuilt
+  std::string       corrupt = written.str ();
+  const std::size_t octreePos = corrupt.find ("dly_octree ");
+  assert (octreePos != std::string::npos);
+  corrupt.replace (corrupt.find (' ', octreePos) + 1, 4, "AAAA");
+
+  Scene              rebuilt (loadConfig);
+  std::istringstream corruptInput (corrupt);
+  const bool         isRebuilt = ImportExport::fromDlyFile (corruptInput, loadConfig, rebuilt);
+
+  assert (isRebuilt);
+  assert (rebuilt.numDynamicMeshes () == 1);
+  rebuilt.forEachConstMesh ([&](const DynamicMesh& r) {
+    assert (r.numFaces () == numFaceSlots - numFreeFaces);
+    assert (r.checkConsistency ());
+    unused (r);
+  });
+  unused (success);
+  unused (isRebuilt);
+
+  unused (numFreeVertices);
+  unused (numFreeFaces);
+}
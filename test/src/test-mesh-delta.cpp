@@ -0,0 +1,276 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <QByteArray>
+#include <algorithm>
+#include <cassert>
+#include <glm/glm.hpp>
+#include "dynamic/mesh-delta.hpp"
+#include "dynamic/mesh.hpp"
+#include "dynamic/octree.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "test-mesh-delta.hpp"
+#include "util.hpp"
+
+namespace
+{
+  bool isBorder (const DynamicMesh& mesh, unsigned int e1, unsigned int e2)
+  {
+    for (unsigned int f : mesh.adjacentFaces (e1))
+    {
+      unsigned int i1, i2, i3;
+      mesh.vertexIndices (f, i1, i2, i3);
+
+      if ((i1 == e2 && i2 == e1) || (i2 == e2 && i3 == e1) || (i3 == e2 && i1 == e1))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // compares the faces adjacent to an edge: both meshes have the same faces at this point
+  bool equalsAdjacent (const DynamicMesh& a, const DynamicMesh& b, unsigned int e1,
+                       unsigned int e2)
+  {
+    if (isBorder (a, e1, e2))
+    {
+      return true;
+    }
+    unsigned int aLeftFace, aLeftVertex, aRightFace, aRightVertex;
+    unsigned int bLeftFace, bLeftVertex, bRightFace, bRightVertex;
+
+    a.findAdjacent (e1, e2, aLeftFace, aLeftVertex, aRightFace, aRightVertex);
+    b.findAdjacent (e1, e2, bLeftFace, bLeftVertex, bRightFace, bRightVertex);
+
+    return aLeftFace == bLeftFace && aLeftVertex == bLeftVertex && aRightFace == bRightFace &&
+           aRightVertex == bRightVertex;
+  }
+
+  bool equals (const DynamicMesh& a, const DynamicMesh& b)
+  {
+    if (a.numVertices () != b.numVertices () || a.numFaces () != b.numFaces () ||
+        a.mesh ().numVertices () != b.mesh ().numVertices () ||
+        a.mesh ().numIndices () != b.mesh ().numIndices () ||
+        a.octree ().statistics ().numElements != b.numFaces ())
+    {
+      return false;
+    }
+    for (unsigned int i = 0; i < a.mesh ().numVertices (); i++)
+    {
+      if (a.isFreeVertex (i) != b.isFreeVertex (i))
+      {
+        return false;
+      }
+      else if (a.isFreeVertex (i) == false)
+      {
+        const DynamicAdjacency::Faces fa = a.adjacentFaces (i);
+        const DynamicAdjacency::Faces fb = b.adjacentFaces (i);
+
+        if (a.vertex (i) != b.vertex (i) || a.vertexNormal (i) != b.vertexNormal (i) ||
+            std::equal (fa.begin (), fa.end (), fb.begin (), fb.end ()) == false)
+        {
+          return false;
+        }
+      }
+    }
+    for (unsigned int i = 0; i < a.mesh ().numIndices () / 3; i++)
+    {
+      if (a.isFreeFace (i) != b.isFreeFace (i))
+      {
+        return false;
+      }
+      else if (a.isFreeFace (i) == false)
+      {
+        unsigned int a1, a2, a3, b1, b2, b3;
+        a.vertexIndices (i, a1, a2, a3);
+        b.vertexIndices (i, b1, b2, b3);
+
+        if (a1 != b1 || a2 != b2 || a3 != b3 || equalsAdjacent (a, b, a1, a2) == false ||
+            equalsAdjacent (a, b, a2, a3) == false || equalsAdjacent (a, b, a3, a1) == false)
+        {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  bool equalDeltas (const DynamicMeshDelta& a, const DynamicMeshDelta& b)
+  {
+    const auto equalVertices = [](const DynamicMeshDelta::Vertex& v,
+                                  const DynamicMeshDelta::Vertex& w) {
+      return v.index == w.index && v.isFree == w.isFree && v.position == w.position &&
+             v.normal == w.normal && v.firstAdjacentFace == w.firstAdjacentFace &&
+             v.numAdjacentFaces == w.numAdjacentFaces;
+    };
+    const auto equalFaces = [](const DynamicMeshDelta::Face& f, const DynamicMeshDelta::Face& g) {
+      return f.index == g.index && f.isFree == g.isFree &&
+             std::equal (f.vertices, f.vertices + 3, g.vertices) &&
+             std::equal (f.twins, f.twins + 3, g.twins);
+    };
+    return a.numVertexSlots == b.numVertexSlots && a.numFaceSlots == b.numFaceSlots &&
+           std::equal (a.vertices.begin (), a.vertices.end (), b.vertices.begin (),
+                       b.vertices.end (), equalVertices) &&
+           a.adjacentFaces == b.adjacentFaces &&
+           std::equal (a.faces.begin (), a.faces.end (), b.faces.begin (), b.faces.end (),
+                       equalFaces);
+  }
+
+  bool roundTrips (const DynamicMeshDelta& delta)
+  {
+    DynamicMeshDelta decompressed;
+    return DynamicMeshDelta::decompress (delta.compress (), decompressed) &&
+           equalDeltas (decompressed, delta);
+  }
+
+  // returns the position behind the varint at `position`
+  int skipVarint (const QByteArray& data, int position)
+  {
+    while (static_cast<unsigned char> (data[position]) & 0x80)
+    {
+      position++;
+    }
+    return position + 1;
+  }
+
+  // corrupt data is rejected and leaves the delta untouched
+  void testCorruption (const DynamicMeshDelta& delta)
+  {
+    const QByteArray data = qUncompress (delta.compress ());
+
+    const auto rejects = [&delta](const QByteArray& compressed) {
+      DynamicMeshDelta decompressed (delta);
+      return DynamicMeshDelta::decompress (compressed, decompressed) == false &&
+             equalDeltas (decompressed, delta);
+    };
+
+    assert (rejects (QByteArray ()));
+    assert (rejects (QByteArray ("not compressed")));
+    assert (rejects (qCompress (QByteArray ())));
+
+    // every truncation and an appended byte
+    for (int n = 0; n < data.size (); n++)
+    {
+      assert (rejects (qCompress (data.left (n))));
+    }
+    assert (rejects (qCompress (data + QByteArray (1, 0))));
+
+    // a varint exceeding 32 bits
+    assert (rejects (qCompress (QByteArray (5, char(0xff)) + data)));
+
+    // a number of vertices exceeding the data
+    const int numVertices = skipVarint (data, skipVarint (data, 0));
+    assert (rejects (qCompress (data.left (numVertices) + QByteArray ("\xff\xff\xff\x0f") +
+                                data.mid (skipVarint (data, numVertices)))));
+
+    // an invalid flag of the first vertex
+    if (delta.vertices.empty () == false)
+    {
+      int position = numVertices;
+      for (unsigned int i = 0; i < 5; i++)
+      {
+        position = skipVarint (data, position);
+      }
+      QByteArray flag (data);
+      flag[position] = char(2);
+      assert (rejects (qCompress (flag)));
+    }
+    unused (rejects);
+  }
+
+  // round trips deltas with edge cases of the encoding
+  void testCompression ()
+  {
+    const unsigned int x = Util::invalidIndex ();
+    DynamicMeshDelta   empty;
+
+    empty.numVertexSlots = 3;
+    empty.numFaceSlots = 1;
+    assert (roundTrips (empty));
+    testCorruption (empty);
+
+    // indices jump back and forth, twins may be invalid, floats may be negative zero or huge
+    DynamicMeshDelta delta;
+    delta.numVertexSlots = 1u << 20;
+    delta.numFaceSlots = 1u << 21;
+    delta.vertices.push_back ({(1u << 20) - 1, false, glm::vec3 (-0.0f, 1e30f, -1e-30f),
+                               glm::vec3 (0.0f, 0.0f, 1.0f), 0, 2});
+    delta.vertices.push_back ({0, true, glm::vec3 (0.0f), glm::vec3 (0.0f), 2, 0});
+    delta.vertices.push_back ({7, false, glm::vec3 (0.1f, 0.2f, 0.3f),
+                               glm::vec3 (-1.0f, 0.0f, 0.0f), 2, 1});
+    delta.adjacentFaces = {(1u << 21) - 1, 0, 5};
+    delta.faces.push_back ({(1u << 21) - 1, false, {7, 0, (1u << 20) - 1}, {x, 3, x}});
+    delta.faces.push_back ({0, true, {0, 0, 0}, {x, x, x}});
+    delta.faces.push_back ({5, false, {1, 2, 3}, {0, (3u << 21) - 1, 4}});
+
+    assert (roundTrips (delta));
+    testCorruption (delta);
+  }
+}
+
+void TestMeshDelta::test ()
+{
+  DynamicMesh mesh (MeshUtil::icosphere (2));
+
+  mesh.deleteFace (1);
+  mesh.deleteVertex (3);
+  mesh.prune ();
+
+  const DynamicMesh pruned (mesh);
+
+  mesh.startRecording ();
+  for (unsigned int i = 0; i < mesh.numVertices (); i += 5)
+  {
+    mesh.vertex (i, 1.1f * mesh.vertex (i));
+  }
+  mesh.setAllNormals ();
+  mesh.deleteFace (7);
+  mesh.deleteVertex (11);
+
+  // reuses free vertices and faces before adding new ones
+  for (unsigned int i = 0; i < 16; i++)
+  {
+    const glm::vec3    p (float (i), 2.0f, 0.0f);
+    const glm::vec3    n (0.0f, 0.0f, 1.0f);
+    const unsigned int i1 = mesh.addVertex (p, n);
+    const unsigned int i2 = mesh.addVertex (p + glm::vec3 (1.0f, 0.0f, 0.0f), n);
+    const unsigned int i3 = mesh.addVertex (p + glm::vec3 (0.0f, 1.0f, 0.0f), n);
+
+    mesh.addFace (i1, i2, i3);
+  }
+
+  DynamicMeshDelta  delta = mesh.stopRecording ();
+  const DynamicMesh modified (mesh);
+
+  assert (delta.isEmpty () == false);
+  assert (equals (mesh, pruned) == false);
+
+  mesh.applyDelta (delta);
+  assert (equals (mesh, pruned));
+
+  mesh.applyDelta (delta);
+  assert (equals (mesh, modified));
+
+  mesh.applyDelta (delta);
+  assert (equals (mesh, pruned));
+  assert (mesh.isSparse () == false);
+
+  const QByteArray compressed = delta.compress ();
+  DynamicMeshDelta decompressed;
+  const bool       isDecompressed = DynamicMeshDelta::decompress (compressed, decompressed);
+
+  assert (isDecompressed);
+  assert (std::size_t (compressed.size ()) < delta.memoryBytes ());
+  mesh.applyDelta (decompressed);
+  assert (equals (mesh, modified));
+
+  testCompression ();
+  testCorruption (delta);
+
+  unused (isDecompressed);
+  unused (equals);
+  unused (roundTrips);
+}
@@ -4,6 +4,7 @@
  */
 #include <cassert>
 #include <limits>
+#include "memory-usage.hpp"
 #include "test-misc.hpp"
 #include "util.hpp"
 
@@ -19,4 +20,18 @@ void TestMisc::test ()
   assert (Util::countOnes (256) == 1);
 
   assert (Util::countOnes (std::numeric_limits<unsigned int>::max ()) == sizeof (unsigned int) * 8);
+
+  MemoryUsage usage;
+  usage.add ("a", 10);
+  usage.add ("b", 20);
+
+  MemoryUsage other;
+  other.add ("b", 5);
+  other.add ("c", 1);
+
+  usage.add (other);
+  assert (usage.parts ().size () == 3);
+  assert (usage.parts ()[1].bytes == 25);
+  assert (usage.total () == 36);
+  assert (MemoryUsage::toString (2048) == "2.0 KiB");
 }
@@ -0,0 +1,68 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <glm/glm.hpp>
+#include <random>
+#include <vector>
+#include "dynamic/faces.hpp"
+#include "dynamic/mesh.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "test-normals.hpp"
+
+namespace
+{
+  // compares the batched normals with the normals computed vertex by vertex
+  bool matchesAverageNormal (const DynamicMesh& mesh, unsigned int i)
+  {
+    return glm::distance (mesh.vertexNormal (i), mesh.averageNormal (i)) < 1.0e-5f;
+  }
+}
+
+void TestNormals::test ()
+{
+  DynamicMesh                           mesh (MeshUtil::icosphere (3));
+  std::default_random_engine            gen;
+  std::uniform_real_distribution<float> noise (-0.01f, 0.01f);
+
+  for (unsigned int i = 0; i < mesh.numVertices (); i++)
+  {
+    mesh.vertex (i, mesh.vertex (i) + glm::vec3 (noise (gen), noise (gen), noise (gen)));
+  }
+  mesh.setAllNormals ();
+
+  for (unsigned int i = 0; i < mesh.numVertices (); i++)
+  {
+    assert (matchesAverageNormal (mesh, i));
+  }
+
+  DynamicFaces faces;
+  for (unsigned int i = 0; i < mesh.numFaces (); i += 7)
+  {
+    faces.insert (i);
+  }
+  faces.commit ();
+
+  std::vector<bool> inFaces (mesh.numVertices (), false);
+  mesh.forEachVertex (faces, [&mesh, &inFaces](unsigned int i) {
+    mesh.vertex (i, 1.1f * mesh.vertex (i));
+    inFaces[i] = true;
+  });
+
+  const std::vector<glm::vec3> normals = [&mesh]() {
+    std::vector<glm::vec3> n;
+    for (unsigned int i = 0; i < mesh.numVertices (); i++)
+    {
+      n.push_back (mesh.vertexNormal (i));
+    }
+    return n;
+  }();
+  mesh.setNormals (faces);
+
+  for (unsigned int i = 0; i < mesh.numVertices (); i++)
+  {
+    assert (inFaces[i] ? matchesAverageNormal (mesh, i) : mesh.vertexNormal (i) == normals[i]);
+  }
+  unused (matchesAverageNormal);
+}
@@ -2,13 +2,83 @@
  * Copyright © 2015-2018 Alexander Bau
  * Use and redistribute under the terms of the GNU General Public License
  */
+#include <QByteArray>
 #include <glm/glm.hpp>
 #include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <random>
+#include "distance.hpp"
 #include "dynamic/octree.hpp"
+#include "intersection.hpp"
+#include "parallel.hpp"
+#include "primitive/ray.hpp"
+#include "primitive/sphere.hpp"
 #include "primitive/triangle.hpp"
 #include "test-octree.hpp"
+#include "util.hpp"
+
+namespace
+{
+  unsigned int numElements (const DynamicOctree& octree)
+  {
+    unsigned int n = 0;
+    octree.intersects (PrimSphere (glm::vec3 (0.0f), Util::maxFloat ()),
+                       [&n](bool, unsigned int) { n++; });
+    return n;
+  }
+
+  PrimTriangle triangle (const std::vector<glm::vec3>& vertices, unsigned int i)
+  {
+    return PrimTriangle (vertices[(3 * i) + 0], vertices[(3 * i) + 1], vertices[(3 * i) + 2]);
+  }
+
+  float closestIntersection (const DynamicOctree& octree, const std::vector<glm::vec3>& vertices,
+                             const PrimRay& ray)
+  {
+    float closest = Util::maxFloat ();
+    octree.intersects (ray, [&vertices, &ray, &closest](unsigned int i) {
+      float t;
+      if (IntersectionUtil::intersects (ray, triangle (vertices, i), false, &t))
+      {
+        closest = glm::min (closest, t);
+        return t;
+      }
+      return Util::maxFloat ();
+    });
+    return closest;
+  }
+
+  std::vector<float> closestIntersections (const DynamicOctree&          octree,
+                                           const std::vector<glm::vec3>& vertices,
+                                           const std::vector<PrimRay>&   rays)
+  {
+    std::vector<float> closest (rays.size (), Util::maxFloat ());
+    octree.intersects (rays, [&vertices, &rays, &closest](unsigned int r, unsigned int i) {
+      float t;
+      if (IntersectionUtil::intersects (rays[r], triangle (vertices, i), false, &t))
+      {
+        closest[r] = glm::min (closest[r], t);
+        return t;
+      }
+      return Util::maxFloat ();
+    });
+    return closest;
+  }
+
+  float bruteForceClosestIntersection (const std::vector<glm::vec3>& vertices, const PrimRay& ray)
+  {
+    float closest = Util::maxFloat ();
+    for (unsigned int i = 0; i < vertices.size () / 3; i++)
+    {
+      float t;
+      if (IntersectionUtil::intersects (ray, triangle (vertices, i), false, &t))
+      {
+        closest = glm::min (closest, t);
+      }
+    }
+    return closest;
+  }
+}
 
 void TestOctree::test ()
 {
@@ -22,6 +92,7 @@ void TestOctree::test ()
   std::uniform_real_distribution<float> posD (-10.0f, 10.0f);
   std::uniform_real_distribution<float> scaleD (0.00001f, 10.0f);
   std::uniform_real_distribution<float> twoPiD (0.0f, 2.0f * glm::pi<float> ());
+  std::vector<glm::vec3>                vertices;
 
   for (unsigned int i = 0; i < numSamples; i++)
   {
@@ -46,9 +117,168 @@ void TestOctree::test ()
     const PrimTriangle tri = PrimTriangle (w1, w2, w3);
 
     octree.addElement (i, tri.center (), tri.maxDimExtent ());
+    vertices.push_back (w1);
+    vertices.push_back (w2);
+    vertices.push_back (w3);
+  }
+  assert (numElements (octree) == numSamples);
+
+  {
+    std::vector<unsigned int> indices;
+    std::vector<glm::vec3>    positions;
+    std::vector<float>        maxDimExtents;
+
+    for (unsigned int i = 0; i < numSamples; i++)
+    {
+      indices.push_back (i);
+      positions.push_back (triangle (vertices, i).center ());
+      maxDimExtents.push_back (triangle (vertices, i).maxDimExtent ());
+    }
+
+    // bulk insertion falls back to `addElement` on a single thread
+    DynamicOctree bulk;
+    bulk.setupRoot (glm::vec3 (0.0f), 10.0f);
+    Parallel::numThreads (3);
+    bulk.addElements (indices, positions, maxDimExtents);
+    Parallel::numThreads (0);
+
+    const QByteArray binary = octree.toBinary (indices);
+    DynamicOctree    restored, invalid;
+
+    const bool isRestored = restored.fromBinary (binary, numSamples);
+    assert (isRestored);
+    assert (restored.numElements () == numSamples);
+    assert (restored.toBinary (indices) == binary);
+
+    // corrupt data and stale element counts are rejected and leave an empty octree
+    const bool isInvalid = invalid.fromBinary (binary, numSamples + 1) ||
+                           invalid.fromBinary (binary, numSamples - 1) ||
+                           invalid.fromBinary (binary.left (binary.size () - 1), numSamples) ||
+                           invalid.fromBinary (binary + QByteArray (1, '\0'), numSamples) ||
+                           invalid.fromBinary (QByteArray (), numSamples);
+    assert (isInvalid == false);
+    assert (invalid.hasRoot () == false);
+    assert (invalid.numElements () == 0);
+
+    std::vector<unsigned int> duplicateIndices (indices);
+    duplicateIndices[1] = duplicateIndices[0];
+
+    const bool isDuplicate = invalid.fromBinary (octree.toBinary (duplicateIndices), numSamples);
+    assert (isDuplicate == false);
+    unused (isRestored);
+    unused (isInvalid);
+    unused (isDuplicate);
+
+    // bulk insertion and restoring from the binary representation must yield the same tree: nodes
+    // and elements are visited in the same order
+    for (unsigned int i = 0; i < 10; i++)
+    {
+      const PrimSphere sphere (glm::vec3 (posD (gen), posD (gen), posD (gen)), scaleD (gen));
+      std::vector<std::pair<bool, unsigned int>> visited, bulkVisited, restoredVisited;
+
+      octree.intersects (sphere, [&visited](bool c, unsigned int e) { visited.emplace_back (c, e); });
+      bulk.intersects (sphere,
+                       [&bulkVisited](bool c, unsigned int e) { bulkVisited.emplace_back (c, e); });
+      restored.intersects (sphere, [&restoredVisited](bool c, unsigned int e) {
+        restoredVisited.emplace_back (c, e);
+      });
+      assert (visited == bulkVisited);
+      assert (visited == restoredVisited);
+    }
+  }
+
+  for (unsigned int i = 0; i < 100; i++)
+  {
+    const glm::vec3 origin (posD (gen), posD (gen), posD (gen));
+    const glm::vec3 direction (posD (gen), posD (gen), posD (gen));
+    const PrimRay   ray (origin, glm::normalize (direction));
+
+    assert (closestIntersection (octree, vertices, ray) ==
+            bruteForceClosestIntersection (vertices, ray));
+  }
+
+  for (unsigned int i = 0; i < 10; i++)
+  {
+    const glm::vec3      origin (posD (gen), posD (gen), posD (gen));
+    const glm::vec3      direction (posD (gen), posD (gen), posD (gen));
+    std::vector<PrimRay> rays;
+
+    for (unsigned int j = 0; j < 16; j++)
+    {
+      rays.emplace_back (origin + glm::vec3 (float(j % 4), float(j / 4), 0.0f),
+                         glm::normalize (direction));
+    }
+    const std::vector<float> closest = closestIntersections (octree, vertices, rays);
+
+    for (unsigned int j = 0; j < rays.size (); j++)
+    {
+      assert (closest[j] == bruteForceClosestIntersection (vertices, rays[j]));
+    }
+  }
+
+  for (unsigned int i = 0; i < 10; i++)
+  {
+    const glm::vec3 p (posD (gen), posD (gen), posD (gen));
+    float           minDistance = Util::maxFloat ();
+
+    for (unsigned int j = 0; j < numSamples; j++)
+    {
+      minDistance = glm::min (minDistance, Distance::distance (triangle (vertices, j), p));
+    }
+    unsigned int closest;
+    const float  distance = octree.distance (
+      p, [&vertices, &p](unsigned int j) { return Distance::distance (triangle (vertices, j), p); },
+      &closest);
+    assert (distance == minDistance);
+
+    glm::vec3       b;
+    const glm::vec3 c = Distance::closestPoint (triangle (vertices, closest), p, &b);
+
+    assert (glm::distance (p, c) == distance);
+    assert (Util::almostEqual (b.x + b.y + b.z, 1.0f));
+    assert (glm::distance (c, (b.x * vertices[3 * closest]) + (b.y * vertices[(3 * closest) + 1]) +
+                                (b.z * vertices[(3 * closest) + 2])) <
+            Util::epsilon () * glm::max (1.0f, glm::length (c)));
+    unused (distance);
+    unused (c);
   }
+
+  // copies share their nodes until they are modified
+  const std::size_t bytes = octree.memoryBytes ();
+  DynamicOctree     copy (octree);
+  assert (octree.memoryBytes () < bytes);
+  unused (bytes);
+
+  for (unsigned int i = 0; i < numSamples; i += 2)
+  {
+    copy.deleteElement (i);
+  }
+  copy.deleteEmptyChildren ();
+  assert (numElements (copy) == numSamples / 2);
+  assert (numElements (octree) == numSamples);
+  assert (copy.statistics ().numElements == numSamples / 2);
+  assert (copy.statistics ().numEmptyNodes == 0);
+
+  // compacting the indices of the remaining elements drops the map entries of deleted ones
+  std::vector<unsigned int> newIndices (numSamples, Util::invalidIndex ());
+  for (unsigned int i = 1; i < numSamples; i += 2)
+  {
+    newIndices[i] = i / 2;
+  }
+  const std::size_t uncompactedBytes = copy.memoryBytes ();
+  copy.updateIndices (newIndices);
+  assert (numElements (copy) == numSamples / 2);
+  assert (copy.memoryBytes () < uncompactedBytes);
+  unused (uncompactedBytes);
+
   for (unsigned int i = 0; i < numSamples; i++)
   {
     octree.deleteElement (i);
   }
+  assert (octree.statistics ().numElements == 0);
+  assert (octree.hasRoot () == false || octree.statistics ().emptyNodeRatio () == 1.0f);
+  unused (numElements);
+  unused (closestIntersection);
+  unused (closestIntersections);
+  unused (bruteForceClosestIntersection);
 }
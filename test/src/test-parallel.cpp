@@ -0,0 +1,112 @@
+/* This file is part of Dilay
+ * Copyright © 2015-2018 Alexander Bau
+ * Use and redistribute under the terms of the GNU General Public License
+ */
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <vector>
+#include "dynamic/mesh.hpp"
+#include "mesh-util.hpp"
+#include "mesh.hpp"
+#include "parallel.hpp"
+#include "test-parallel.hpp"
+
+namespace
+{
+  std::vector<glm::vec3> normals (const DynamicMesh& mesh)
+  {
+    std::vector<glm::vec3> n;
+    for (unsigned int i = 0; i < mesh.numVertices (); i++)
+    {
+      n.push_back (mesh.vertexNormal (i));
+    }
+    return n;
+  }
+}
+
+void TestParallel::test ()
+{
+  Parallel::numThreads (7);
+
+  // each element is visited once
+  std::vector<unsigned int> visited (100000, 0);
+  Parallel::forRanges (visited.size (), 1000, [&visited](unsigned int begin, unsigned int end) {
+    for (unsigned int i = begin; i < end; i++)
+    {
+      visited[i]++;
+    }
+  });
+  assert (std::all_of (visited.begin (), visited.end (), [](unsigned int v) { return v == 1; }));
+
+  // the workers persist between calls with different numbers of threads
+  for (unsigned int numThreads = 1; numThreads < 9; numThreads++)
+  {
+    Parallel::numThreads (numThreads);
+    Parallel::forRanges (visited.size (), 1, [&visited](unsigned int begin, unsigned int end) {
+      for (unsigned int i = begin; i < end; i++)
+      {
+        visited[i]++;
+      }
+    });
+  }
+  assert (std::all_of (visited.begin (), visited.end (), [](unsigned int v) { return v == 9; }));
+
+  // nested calls run their ranges on the calling thread
+  std::vector<unsigned int> nested (64 * 64, 0);
+  Parallel::forRanges (64, 1, [&nested](unsigned int outerBegin, unsigned int outerEnd) {
+    for (unsigned int o = outerBegin; o < outerEnd; o++)
+    {
+      Parallel::forRanges (64, 1, [&nested, o](unsigned int begin, unsigned int end) {
+        for (unsigned int i = begin; i < end; i++)
+        {
+          nested[(o * 64) + i]++;
+        }
+      });
+    }
+  });
+  assert (std::all_of (nested.begin (), nested.end (), [](unsigned int v) { return v == 1; }));
+
+  // results do not depend on the number of threads
+  DynamicMesh mesh (MeshUtil::icosphere (6));
+
+  Parallel::numThreads (1);
+  mesh.setAllNormals ();
+  const std::vector<glm::vec3> sequential = normals (mesh);
+
+  Parallel::numThreads (7);
+  mesh.setAllNormals ();
+  assert (normals (mesh) == sequential);
+
+  std::vector<unsigned int> faces (mesh.numFaces (), 0);
+  mesh.forEachFaceParallel ([&faces](unsigned int i) { faces[i]++; });
+  assert (std::all_of (faces.begin (), faces.end (), [](unsigned int v) { return v == 1; }));
+
+  std::vector<glm::vec3> vertexNormals (mesh.numVertices ());
+  mesh.forEachVertexParallel (
+    [&mesh, &vertexNormals](unsigned int i) { vertexNormals[i] = mesh.vertexNormal (i); });
+  assert (vertexNormals == sequential);
+
+  // concurrent queries apply pending realignments once
+  std::vector<glm::vec3> points;
+  for (unsigned int i = 0; i < 700; i++)
+  {
+    points.push_back (mesh.vertex (i % mesh.numVertices ()) * 1.1f);
+  }
+  mesh.forEachVertex ([&mesh](unsigned int i) { mesh.vertex (i, mesh.vertex (i) * 1.5f); });
+  mesh.realignAllFaces ();
+
+  std::vector<float> distances (points.size ());
+  Parallel::forRanges (points.size (), 1, [&mesh, &points, &distances](unsigned int begin,
+                                                                       unsigned int end) {
+    for (unsigned int i = begin; i < end; i++)
+    {
+      distances[i] = mesh.unsignedDistance (points[i]);
+    }
+  });
+  for (unsigned int i = 0; i < points.size (); i++)
+  {
+    assert (distances[i] == mesh.unsignedDistance (points[i]));
+  }
+
+  Parallel::numThreads (0);
+}
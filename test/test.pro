@@ -8,22 +8,42 @@ INCLUDEPATH    += src $$PWD/../lib/src
 
 SOURCES += \
            src/main.cpp \
+           src/test-adjacency.cpp \
            src/test-bitset.cpp \
+           src/test-bvh.cpp \
+           src/test-cow-vector.cpp \
+           src/test-dirty-pages.cpp \
            src/test-distance.cpp \
+           src/test-faces.cpp \
+           src/test-history.cpp \
+           src/test-import-export.cpp \
            src/test-intersection.cpp \
            src/test-maybe.cpp \
+           src/test-mesh-delta.cpp \
            src/test-misc.cpp \
+           src/test-normals.cpp \
            src/test-octree.cpp \
+           src/test-parallel.cpp \
            src/test-prune.cpp \
            src/test-tree.cpp
 
 HEADERS += \
+           src/test-adjacency.hpp \
            src/test-bitset.hpp \
+           src/test-bvh.hpp \
+           src/test-cow-vector.hpp \
+           src/test-dirty-pages.hpp \
            src/test-distance.hpp \
+           src/test-faces.hpp \
+           src/test-history.hpp \
+           src/test-import-export.hpp \
            src/test-intersection.hpp \
            src/test-maybe.hpp \
+           src/test-mesh-delta.hpp \
            src/test-misc.hpp \
+           src/test-normals.hpp \
            src/test-octree.hpp \
+           src/test-parallel.hpp \
            src/test-prune.hpp \
            src/test-tree.hpp
 